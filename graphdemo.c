@@ -35,6 +35,10 @@ Boston, MA 02111-1307 USA
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
 #include "graphlib.h"
 
 #define CHECKERROR(err,no,s) \
@@ -50,6 +54,256 @@ Boston, MA 02111-1307 USA
   } \
 }
 
+#define CHECKSAME(same,no,s) \
+{ \
+  if (!(same)) \
+  { \
+    printf("Mismatch in Test %s at %s\n",no,s); \
+    exit(1); \
+  } \
+}
+
+/*-----------------------------------------------------*/
+/* compare two files byte by byte */
+
+int sameFile(const char *fn1, const char *fn2)
+{
+  FILE *f1,*f2;
+  int  c1,c2;
+
+  f1=fopen(fn1,"r");
+  f2=fopen(fn2,"r");
+  c1=c2=0;
+  if ((f1!=NULL) && (f2!=NULL))
+    {
+      do
+        {
+          c1=fgetc(f1);
+          c2=fgetc(f2);
+        }
+      while ((c1==c2) && (c1!=EOF));
+    }
+  if (f1!=NULL)
+    fclose(f1);
+  if (f2!=NULL)
+    fclose(f2);
+  return (f1!=NULL) && (f2!=NULL) && (c1==c2);
+}
+
+/*-----------------------------------------------------*/
+/* compare a file with a string */
+
+int sameText(const char *fn, const char *text)
+{
+  FILE *f;
+  int  c;
+
+  f=fopen(fn,"r");
+  if (f==NULL)
+    return 0;
+  while (((c=fgetc(f))!=EOF) && (c==(unsigned char)*text))
+    text++;
+  fclose(f);
+  return (c==EOF) && (*text==0);
+}
+
+/*-----------------------------------------------------*/
+/* length of a file, and the uncompressed length recorded at the
+   end of a gzip file (-1 if the file is not gzip compressed) */
+
+long fileLength(const char *fn)
+{
+  FILE *f;
+  long len;
+
+  f=fopen(fn,"r");
+  if (f==NULL)
+    return -1;
+  fseek(f,0,SEEK_END);
+  len=ftell(f);
+  fclose(f);
+  return len;
+}
+
+long gzipLength(const char *fn)
+{
+  FILE          *f;
+  unsigned char b[4];
+  long          len;
+
+  f=fopen(fn,"r");
+  if (f==NULL)
+    return -1;
+  len=-1;
+  if ((fread(b,1,2,f)==2) && (b[0]==0x1f) && (b[1]==0x8b) &&
+      (fseek(f,-4,SEEK_END)==0) && (fread(b,1,4,f)==4))
+    len=b[0]|(b[1]<<8)|(b[2]<<16)|((long)b[3]<<24);
+  fclose(f);
+  return len;
+}
+
+/*-----------------------------------------------------*/
+/* read a file into memory */
+
+char *readFile(const char *fn, uint64_t *len)
+{
+  FILE *f;
+  char *buf;
+
+  *len=fileLength(fn);
+  f=fopen(fn,"r");
+  if ((f==NULL) || ((buf=(char*)malloc(*len+1))==NULL))
+    return NULL;
+  if (fread(buf,1,*len,f)!=*len)
+    {
+      free(buf);
+      buf=NULL;
+    }
+  fclose(f);
+  return buf;
+}
+
+/*-----------------------------------------------------*/
+/* read GRF_BINCOL exports: little endian numbers and the entry of
+   a column in the column table (NULL if there is none) */
+
+uint64_t getLE(const char *p, int size)
+{
+  uint64_t v;
+  int      i;
+
+  v=0;
+  for (i=size-1; i>=0; i--)
+    v=(v<<8)|(unsigned char)p[i];
+  return v;
+}
+
+const char *findColumn(const char *buf, int kind)
+{
+  int i;
+
+  for (i=0; i<(int)getLE(buf+12,4); i++)
+    if (getLE(buf+32+i*24,4)==kind)
+      return buf+32+i*24;
+  return NULL;
+}
+
+/* check the header and the column table of a GRF_BINCOL export */
+
+int checkBincol(const char *buf, uint64_t len, graphlib_graph_p gr)
+{
+  int      num_nodes,num_edges,num_annotations,i,kind,size;
+  uint64_t count,offset,expect;
+
+  graphlib_nodeCount(gr,&num_nodes);
+  graphlib_edgeCount(gr,&num_edges);
+  if ((len<32) || (memcmp(buf,"\211GRC\r\n\032\n",8)!=0) ||
+      (getLE(buf+8,4)!=1) || (getLE(buf+16,8)!=num_nodes) ||
+      (getLE(buf+24,8)!=num_edges) || (32+getLE(buf+12,4)*24>len))
+    return 0;
+
+  num_annotations=0;
+  for (i=0; i<(int)getLE(buf+12,4); i++)
+    if (getLE(buf+32+i*24,4)==GRK_ANNOTATION)
+      num_annotations++;
+
+  for (i=0; i<(int)getLE(buf+12,4); i++)
+    {
+      kind=getLE(buf+32+i*24,4);
+      offset=getLE(buf+40+i*24,8);
+      count=getLE(buf+48+i*24,8);
+      size=8;
+      if ((kind==GRK_NODE_ID) || (kind==GRK_NODE_COLOR) ||
+          (kind==GRK_EDGE_FROM) || (kind==GRK_EDGE_TO) ||
+          (kind==GRK_EDGE_COLOR))
+        size=4;
+      else if (kind==GRK_HEAP)
+        size=1;
+      if (kind<=GRK_ANNOTATION)
+        expect=num_nodes+(kind==GRK_NODE_LABEL);
+      else if (kind==GRK_ANNOTATION_KEY)
+        expect=num_annotations+1;
+      else if (kind<GRK_HEAP)
+        expect=num_edges+(kind==GRK_EDGE_LABEL);
+      else
+        expect=count;
+      if ((offset%8!=0) || (count!=expect) || (offset+count*size>len))
+        return 0;
+    }
+  return 1;
+}
+
+/*-----------------------------------------------------*/
+/* compare two graphs through their indexed layout, which is
+   sorted and therefore independent of the order of insertion */
+
+int sameGraph(graphlib_graph_p gr1, graphlib_graph_p gr2)
+{
+  char     *ba1=0,*ba2=0;
+  uint64_t ba_len1=0,ba_len2=0;
+  int      same;
+
+  same=(GRL_IS_OK(graphlib_serializeGraphIndexed(gr1,&ba1,&ba_len1)) &&
+        GRL_IS_OK(graphlib_serializeGraphIndexed(gr2,&ba2,&ba_len2)) &&
+        (ba_len1==ba_len2) && (memcmp(ba1,ba2,ba_len1)==0));
+  if (ba1!=NULL)
+    free(ba1);
+  if (ba2!=NULL)
+    free(ba2);
+  return same;
+}
+
+/*-----------------------------------------------------*/
+/* export sinks: append to a stdio stream, or fail on the first call */
+
+graphlib_error_t writeSink(void *arg, const char *buf, uint64_t len)
+{
+  if (fwrite(buf,1,len,(FILE*)arg)!=len)
+    return GRL_FILEERROR;
+  return GRL_OK;
+}
+
+graphlib_error_t failSink(void *arg, const char *buf, uint64_t len)
+{
+  (*(int*)arg)++;
+  return GRL_FILEERROR;
+}
+
+/*-----------------------------------------------------*/
+/* text buffer routines: the label as it is, or padded with dots to
+   PADLEN characters, counting the calls whose buffer was too small */
+
+#define PADLEN 5000
+
+int short_calls=0;
+
+size_t copyText(const void *label, char *buf, size_t cap)
+{
+  size_t len;
+
+  len=strlen((char*)label);
+  if (len<=cap)
+    memcpy(buf,label,len);
+  else
+    short_calls++;
+  return len;
+}
+
+size_t padText(const void *label, char *buf, size_t cap)
+{
+  size_t len;
+
+  if (cap<PADLEN)
+    {
+      short_calls++;
+      return PADLEN;
+    }
+  len=strlen((char*)label);
+  memcpy(buf,label,len);
+  memset(buf+len,'.',PADLEN-len);
+  return PADLEN;
+}
+
 /*-----------------------------------------------------*/
 /* TEST A: Create a graph and save it */
 
@@ -732,6 +986,1205 @@ void testH()
 
 #undef TESTNO
 
+/*-----------------------------------------------------*/
+/* TEST I: lazy loading, change loaded nodes and edges */
+
+#define TESTNO "TEST I"
+
+void testI()
+{
+  graphlib_graph_p    gr,gr1,gr2;
+  graphlib_error_t    err;
+  graphlib_nodeattr_t nattr;
+  graphlib_edgeattr_t eattr;
+  void                *values[2];
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_saveGraphIndexed("demo-i.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 2");
+
+  err=graphlib_loadGraph("demo-i.grl",&gr1,NULL);
+  CHECKERROR(err,TESTNO,"Step 3");
+  err=graphlib_loadGraphLazy("demo-i.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 4");
+
+  /* existing nodes and edges of the lazy graph are still undecoded */
+
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.label="node4b";
+  nattr.attr_values=values;
+  values[0]="node4b";
+  values[1]="node4b";
+  err=graphlib_addNode(gr1,13,&nattr);
+  CHECKERROR(err,TESTNO,"Step 5");
+  err=graphlib_addNode(gr2,13,&nattr);
+  CHECKERROR(err,TESTNO,"Step 6");
+
+  graphlib_setDefEdgeAttr(&eattr);
+  eattr.label="edge2";
+  eattr.attr_values=values;
+  values[0]="edge2";
+  values[1]="edge2";
+  err=graphlib_addDirectedEdge(gr1,11,2,&eattr);
+  CHECKERROR(err,TESTNO,"Step 7");
+  err=graphlib_addDirectedEdge(gr2,11,2,&eattr);
+  CHECKERROR(err,TESTNO,"Step 8");
+
+  err=graphlib_exportGraph("demo-i1.dot",GRF_DOT,gr1);
+  CHECKERROR(err,TESTNO,"Step 9");
+  err=graphlib_exportGraph("demo-i2.dot",GRF_DOT,gr2);
+  CHECKERROR(err,TESTNO,"Step 10");
+  CHECKSAME(sameFile("demo-i1.dot","demo-i2.dot"),TESTNO,"Step 11");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 12");
+  err=graphlib_delGraph(gr1);
+  CHECKERROR(err,TESTNO,"Step 13");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 14");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST J: serialize into caller supplied buffers */
+
+#define TESTNO "TEST J"
+
+void testJ()
+{
+  graphlib_graph_p gr;
+  graphlib_error_t err;
+  char             *ba=0,*ba2;
+  uint64_t         ba_len=0,len,used;
+  struct iovec     *iov;
+  int              iovcnt,i;
+  FILE             *f;
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_serializeGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 2");
+
+  err=graphlib_serializedGraphLength(gr,&len);
+  CHECKERROR(err,TESTNO,"Step 3");
+  CHECKSAME(len==ba_len,TESTNO,"Step 4");
+
+  ba2=(char*)malloc(len);
+  err=graphlib_serializeGraphInto(gr,ba2,len-1,&used);
+  CHECKSAME((err==GRL_MEMORYERROR) && (used==len),TESTNO,"Step 5");
+  err=graphlib_serializeGraphInto(gr,ba2,len,&used);
+  CHECKERROR(err,TESTNO,"Step 6");
+  CHECKSAME((used==len) && (memcmp(ba,ba2,len)==0),TESTNO,"Step 7");
+
+  /* the scatter/gather list and the saved file hold the same bytes */
+
+  err=graphlib_serializeGraphIov(gr,&iov,&iovcnt,&len);
+  CHECKERROR(err,TESTNO,"Step 7.1");
+  used=0;
+  for (i=0;(i<iovcnt) && (used+iov[i].iov_len<=len);i++)
+    {
+      memcpy(ba2+used,iov[i].iov_base,iov[i].iov_len);
+      used+=iov[i].iov_len;
+    }
+  free(iov);
+  CHECKSAME((len==ba_len) && (used==len) && (memcmp(ba,ba2,len)==0),
+            TESTNO,"Step 7.2");
+
+  err=graphlib_saveGraph("demo-j.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 7.3");
+  memset(ba2,0,len);
+  f=fopen("demo-j.grl","r");
+  CHECKSAME((f!=NULL) && (fread(&used,sizeof(uint64_t),1,f)==1) &&
+            (used==len) && (fread(ba2,1,len,f)==len) &&
+            (fgetc(f)==EOF),TESTNO,"Step 7.4");
+  fclose(f);
+  CHECKSAME(memcmp(ba,ba2,len)==0,TESTNO,"Step 7.5");
+  free(ba2);
+  free(ba);
+
+  err=graphlib_serializeBasicGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 8");
+  err=graphlib_serializedBasicGraphLength(gr,&len);
+  CHECKERROR(err,TESTNO,"Step 9");
+  ba2=(char*)malloc(len);
+  err=graphlib_serializeBasicGraphInto(gr,ba2,len,&used);
+  CHECKERROR(err,TESTNO,"Step 10");
+  CHECKSAME((len==ba_len) && (used==len) && (memcmp(ba,ba2,len)==0),
+            TESTNO,"Step 11");
+  free(ba2);
+  free(ba);
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 12");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST K: view a graph in the indexed layout */
+
+#define TESTNO "TEST K"
+
+void testK()
+{
+  graphlib_graph_p     gr,gr2;
+  graphlib_error_t     err;
+  graphlib_graphview_t view;
+  graphlib_viewnode_t  vn;
+  graphlib_viewedge_t  ve;
+  graphlib_nodeattr_p  nattr;
+  char                 *ba=0;
+  uint64_t             ba_len=0,num,i,j,index;
+  int                  num_nodes,num_edges;
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_serializeGraphIndexed(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 2");
+  err=graphlib_viewGraph(&view,ba,ba_len);
+  CHECKERROR(err,TESTNO,"Step 3");
+
+  graphlib_nodeCount(gr,&num_nodes);
+  graphlib_edgeCount(gr,&num_edges);
+  err=graphlib_viewNodeCount(&view,&num);
+  CHECKSAME(GRL_IS_OK(err) && (num==num_nodes),TESTNO,"Step 4");
+  err=graphlib_viewEdgeCount(&view,&num);
+  CHECKSAME(GRL_IS_OK(err) && (num==num_edges),TESTNO,"Step 5");
+
+  for (i=0;i<num_nodes;i++)
+    {
+      err=graphlib_viewNode(&view,i,&vn);
+      CHECKERROR(err,TESTNO,"Step 6");
+      err=graphlib_getNodeAttr(gr,vn.id,&nattr);
+      CHECKERROR(err,TESTNO,"Step 7");
+      CHECKSAME((strcmp(vn.label,(char*)nattr->label)==0) &&
+                (vn.width==nattr->width) && (vn.color==nattr->color),
+                TESTNO,"Step 8");
+      err=graphlib_viewFindNode(&view,vn.id,&index);
+      CHECKSAME(GRL_IS_OK(err) && (index==i),TESTNO,"Step 9");
+      for (j=vn.out_first;j<vn.out_first+vn.out_count;j++)
+        {
+          err=graphlib_viewEdge(&view,j,&ve);
+          CHECKSAME(GRL_IS_OK(err) && (ve.node_from==vn.id),TESTNO,
+                    "Step 10");
+          err=graphlib_viewFindEdge(&view,ve.node_from,ve.node_to,&index);
+          CHECKSAME(GRL_IS_OK(err) && (index==j),TESTNO,"Step 11");
+        }
+    }
+
+  err=graphlib_deserializeGraphIndexed(&gr2,NULL,ba,ba_len);
+  CHECKERROR(err,TESTNO,"Step 12");
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 13");
+  free(ba);
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 14");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 15");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST L: save and load file format versions 1 and 2 */
+
+#define TESTNO "TEST L"
+
+void testL()
+{
+  graphlib_graph_p      gr,gr2,gr3;
+  graphlib_error_t      err;
+  graphlib_annotation_t val;
+  graphlib_nodeattr_t   nattr;
+  char                  label[4096];
+  int                   i;
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+
+  err=graphlib_saveGraph("demo-l1.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 2");
+  err=graphlib_loadGraph("demo-l1.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 3");
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 4");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 5");
+
+  err=graphlib_saveGraphIndexed("demo-l2.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 6");
+  err=graphlib_loadGraph("demo-l2.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 7");
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 8");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 9");
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 10");
+
+  /* version 2 keeps annotation values */
+
+  err=graphlib_loadGraph("demo-f.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 11");
+  err=graphlib_AnnotationSet(gr,4,2,45.0);
+  CHECKERROR(err,TESTNO,"Step 12");
+  err=graphlib_saveGraphIndexed("demo-l3.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 13");
+  err=graphlib_loadGraph("demo-l3.grl",&gr3,NULL);
+  CHECKERROR(err,TESTNO,"Step 14");
+  err=graphlib_AnnotationGet(gr3,4,2,&val);
+  CHECKERROR(err,TESTNO,"Step 15");
+  CHECKSAME((val==45.0) && sameGraph(gr,gr3),TESTNO,"Step 16");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 17");
+  err=graphlib_delGraph(gr3);
+  CHECKERROR(err,TESTNO,"Step 18");
+
+  /* memory mapped loading reads both versions */
+
+  err=graphlib_loadGraph("demo-l1.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 19");
+  err=graphlib_loadGraphMapped("demo-l1.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 20");
+  err=graphlib_loadGraphMapped("demo-l2.grl",&gr3,NULL);
+  CHECKERROR(err,TESTNO,"Step 21");
+  CHECKSAME(sameGraph(gr,gr2) && sameGraph(gr,gr3),TESTNO,"Step 22");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 23");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 24");
+  err=graphlib_delGraph(gr3);
+  CHECKERROR(err,TESTNO,"Step 25");
+
+  /* compressed files are detected by both load routines */
+
+  err=graphlib_loadGraph("demo-l3.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 26");
+  err=graphlib_saveGraphCompressed("demo-l4.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 27");
+  err=graphlib_loadGraph("demo-l4.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 28");
+  err=graphlib_loadGraphMapped("demo-l4.grl",&gr3,NULL);
+  CHECKERROR(err,TESTNO,"Step 29");
+  CHECKSAME(sameGraph(gr,gr2) && sameGraph(gr,gr3),TESTNO,"Step 30");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 31");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 32");
+  err=graphlib_delGraph(gr3);
+  CHECKERROR(err,TESTNO,"Step 33");
+
+  /* a graph larger than the buffers saveGraphIndexed streams through */
+
+  err=graphlib_newGraph(&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 34");
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.label=label;
+  memset(label,'x',sizeof(label)-1);
+  label[sizeof(label)-1]=0;
+  for (i=0;i<2000;i++)
+    {
+      sprintf(label,"node%d",i);
+      label[strlen(label)]='x';
+      err=graphlib_addNode(gr,i,&nattr);
+      CHECKERROR(err,TESTNO,"Step 35");
+      if (i>0)
+        {
+          err=graphlib_addDirectedEdge(gr,i-1,i,NULL);
+          CHECKERROR(err,TESTNO,"Step 36");
+        }
+    }
+  err=graphlib_saveGraphIndexed("demo-l5.grl",gr);
+  CHECKERROR(err,TESTNO,"Step 37");
+  err=graphlib_loadGraph("demo-l5.grl",&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 38");
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 39");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 40");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 41");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST M: serialize with encodings and deserialize again */
+
+#define TESTNO "TEST M"
+
+void testM()
+{
+  graphlib_graph_p gr,gr1,gr2,gr3,gr4;
+  graphlib_error_t err;
+  char             *ba=0,*ba2=0;
+  uint64_t         ba_len=0,ba2_len=0;
+  int              f,e;
+  char             *files[]={"demo-h.grl","demo-l3.grl"};
+  int              encodings[]={GRE_COMPACT,GRE_COMPRESS,
+                                 GRE_COMPACT|GRE_COMPRESS,
+                                 GRE_COLUMNAR,GRE_COLUMNAR|GRE_COMPACT,
+                                 GRE_COLUMNAR|GRE_COMPRESS,
+                                 GRE_DICT,GRE_DICT|GRE_COMPACT,
+                                 GRE_DICT|GRE_COLUMNAR};
+
+  for (f=0;f<sizeof(files)/sizeof(char*);f++)
+    {
+      err=graphlib_loadGraph(files[f],&gr1,NULL);
+      CHECKERROR(err,TESTNO,"Step 1");
+
+      /* serialized graphs carry no annotation values, so the plain
+         serialize routines give the references */
+      err=graphlib_serializeGraph(gr1,&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 2");
+      err=graphlib_deserializeGraph(&gr,NULL,ba,ba_len);
+      CHECKERROR(err,TESTNO,"Step 3");
+      free(ba);
+      err=graphlib_serializeBasicGraph(gr,&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 4");
+      err=graphlib_deserializeBasicGraph(&gr3,NULL,ba,ba_len);
+      CHECKERROR(err,TESTNO,"Step 5");
+      free(ba);
+
+      for (e=0;e<sizeof(encodings)/sizeof(int);e++)
+        {
+          err=graphlib_serializeGraphEncoded(gr,encodings[e],&ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 6");
+          err=graphlib_deserializeGraph(&gr2,NULL,ba,ba_len);
+          CHECKERROR(err,TESTNO,"Step 7");
+          CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 8");
+          err=graphlib_delGraph(gr2);
+          CHECKERROR(err,TESTNO,"Step 9");
+
+          /* labels borrowed from the stream, where the encoding allows it */
+          err=graphlib_deserializeGraphFlags(&gr2,NULL,ba,ba_len,GRD_BORROW);
+          CHECKERROR(err,TESTNO,"Step 10");
+          CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 11");
+          err=graphlib_delGraph(gr2);
+          CHECKERROR(err,TESTNO,"Step 12");
+          free(ba);
+
+          err=graphlib_serializeBasicGraphEncoded(gr,encodings[e],
+                                                  &ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 13");
+          err=graphlib_deserializeBasicGraph(&gr4,NULL,ba,ba_len);
+          CHECKERROR(err,TESTNO,"Step 14");
+          free(ba);
+          CHECKSAME(sameGraph(gr3,gr4),TESTNO,"Step 15");
+          err=graphlib_delGraph(gr4);
+          CHECKERROR(err,TESTNO,"Step 16");
+
+          /* field masks matching the full and the basic serializers */
+          err=graphlib_serializeGraphMask(gr,encodings[e],GRM_ALL,NULL,NULL,
+                                          &ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 17");
+          err=graphlib_deserializeGraph(&gr2,NULL,ba,ba_len);
+          CHECKERROR(err,TESTNO,"Step 18");
+          free(ba);
+          CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 19");
+          err=graphlib_delGraph(gr2);
+          CHECKERROR(err,TESTNO,"Step 20");
+
+          err=graphlib_serializeGraphMask(gr,encodings[e],GRM_BASIC,NULL,
+                                          NULL,&ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 21");
+          err=graphlib_deserializeBasicGraph(&gr4,NULL,ba,ba_len);
+          CHECKERROR(err,TESTNO,"Step 22");
+          free(ba);
+          CHECKSAME(sameGraph(gr3,gr4),TESTNO,"Step 23");
+          err=graphlib_delGraph(gr4);
+          CHECKERROR(err,TESTNO,"Step 24");
+        }
+
+      /* a partial mask restores the selected fields and defaults for
+         the rest, so serializing the result again gives the same stream */
+      err=graphlib_serializeGraphMask(gr,GRE_DEFAULT,GRM_LABELS|GRM_COORDS,
+                                      NULL,NULL,&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 25");
+      err=graphlib_deserializeGraph(&gr2,NULL,ba,ba_len);
+      CHECKERROR(err,TESTNO,"Step 26");
+      err=graphlib_serializeGraphMask(gr2,GRE_DEFAULT,GRM_LABELS|GRM_COORDS,
+                                      NULL,NULL,&ba2,&ba2_len);
+      CHECKERROR(err,TESTNO,"Step 27");
+      CHECKSAME((ba_len==ba2_len) && (memcmp(ba,ba2,ba_len)==0),
+                TESTNO,"Step 28");
+      free(ba);
+      free(ba2);
+      err=graphlib_delGraph(gr2);
+      CHECKERROR(err,TESTNO,"Step 29");
+
+      err=graphlib_delGraph(gr);
+      CHECKERROR(err,TESTNO,"Step 30");
+      err=graphlib_delGraph(gr1);
+      CHECKERROR(err,TESTNO,"Step 31");
+      err=graphlib_delGraph(gr3);
+      CHECKERROR(err,TESTNO,"Step 32");
+    }
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST N: decode serialized graphs incrementally */
+
+#define TESTNO "TEST N"
+
+void testN()
+{
+  graphlib_graph_p   gr,gr2,gr3;
+  graphlib_error_t   err;
+  graphlib_decoder_p dec;
+  char               *ba=0;
+  uint64_t           ba_len=0,pos;
+  int                e;
+  FILE               *f;
+  int                encodings[]={GRE_DEFAULT,GRE_COMPACT,GRE_COMPRESS,
+                                  GRE_COLUMNAR};
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+
+  for (e=0;e<sizeof(encodings)/sizeof(int);e++)
+    {
+      err=graphlib_serializeGraphEncoded(gr,encodings[e],&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 2");
+
+      /* small chunks split every item */
+
+      err=graphlib_newDecoder(&dec,NULL);
+      CHECKERROR(err,TESTNO,"Step 3");
+      for (pos=0;pos<ba_len;pos+=7)
+        {
+          err=graphlib_decoderFeed(dec,ba+pos,(ba_len-pos<7) ? ba_len-pos : 7);
+          CHECKERROR(err,TESTNO,"Step 4");
+        }
+      err=graphlib_decoderFinish(dec,&gr2);
+      CHECKERROR(err,TESTNO,"Step 5");
+      CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 6");
+      err=graphlib_delGraph(gr2);
+      CHECKERROR(err,TESTNO,"Step 7");
+
+      /* the same stream read from a file */
+
+      f=fopen("demo-n.bin","w+");
+      CHECKSAME((f!=NULL) && (fwrite(ba,1,ba_len,f)==ba_len),TESTNO,
+                "Step 8");
+      rewind(f);
+      err=graphlib_newDecoder(&dec,NULL);
+      CHECKERROR(err,TESTNO,"Step 9");
+      err=graphlib_decoderFeedFd(dec,fileno(f));
+      CHECKERROR(err,TESTNO,"Step 10");
+      err=graphlib_decoderFinish(dec,&gr3);
+      CHECKERROR(err,TESTNO,"Step 11");
+      fclose(f);
+      CHECKSAME(sameGraph(gr,gr3),TESTNO,"Step 12");
+      err=graphlib_delGraph(gr3);
+      CHECKERROR(err,TESTNO,"Step 13");
+
+      /* an incomplete stream is reported */
+
+      err=graphlib_newDecoder(&dec,NULL);
+      CHECKERROR(err,TESTNO,"Step 14");
+      err=graphlib_decoderFeed(dec,ba,ba_len-1);
+      CHECKERROR(err,TESTNO,"Step 15");
+      err=graphlib_decoderFinish(dec,&gr3);
+      CHECKSAME(err==GRL_MEMORYERROR,TESTNO,"Step 16");
+      free(ba);
+    }
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 17");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST O: serialize and deserialize with several threads */
+
+#define TESTNO "TEST O"
+
+void testO()
+{
+  graphlib_graph_p gr,gr2,gr3,gr4;
+  graphlib_error_t err;
+  char             *ba=0,*ba2=0;
+  uint64_t         ba_len=0,ba_len2=0;
+  int              f,e;
+  char             *files[]={"demo-h.grl","demo-l5.grl"};
+  int              encodings[]={GRE_INDEX,GRE_INDEX|GRE_COMPACT};
+
+  for (f=0;f<sizeof(files)/sizeof(char*);f++)
+    {
+      err=graphlib_loadGraph(files[f],&gr,NULL);
+      CHECKERROR(err,TESTNO,"Step 1");
+
+      err=graphlib_serializeGraph(gr,&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 2");
+      err=graphlib_serializeGraphParallel(gr,4,&ba2,&ba_len2);
+      CHECKERROR(err,TESTNO,"Step 3");
+      CHECKSAME((ba_len==ba_len2) && (memcmp(ba,ba2,ba_len)==0),TESTNO,
+                "Step 4");
+      free(ba);
+      free(ba2);
+
+      err=graphlib_serializeBasicGraph(gr,&ba,&ba_len);
+      CHECKERROR(err,TESTNO,"Step 5");
+      err=graphlib_serializeBasicGraphParallel(gr,4,&ba2,&ba_len2);
+      CHECKERROR(err,TESTNO,"Step 6");
+      CHECKSAME((ba_len==ba_len2) && (memcmp(ba,ba2,ba_len)==0),TESTNO,
+                "Step 7");
+      err=graphlib_deserializeBasicGraph(&gr3,NULL,ba,ba_len);
+      CHECKERROR(err,TESTNO,"Step 8");
+      free(ba);
+      free(ba2);
+
+      /* streams with a chunk index are split over the threads */
+
+      for (e=0;e<sizeof(encodings)/sizeof(int);e++)
+        {
+          err=graphlib_serializeGraphEncoded(gr,encodings[e],&ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 9");
+          err=graphlib_deserializeGraphParallel(&gr2,NULL,ba,ba_len,4);
+          CHECKERROR(err,TESTNO,"Step 10");
+          free(ba);
+          CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 11");
+          err=graphlib_delGraph(gr2);
+          CHECKERROR(err,TESTNO,"Step 12");
+
+          err=graphlib_serializeBasicGraphEncoded(gr,encodings[e],
+                                                  &ba,&ba_len);
+          CHECKERROR(err,TESTNO,"Step 13");
+          err=graphlib_deserializeBasicGraphParallel(&gr4,NULL,ba,ba_len,4);
+          CHECKERROR(err,TESTNO,"Step 14");
+          free(ba);
+          CHECKSAME(sameGraph(gr3,gr4),TESTNO,"Step 15");
+          err=graphlib_delGraph(gr4);
+          CHECKERROR(err,TESTNO,"Step 16");
+        }
+
+      err=graphlib_delGraph(gr);
+      CHECKERROR(err,TESTNO,"Step 17");
+      err=graphlib_delGraph(gr3);
+      CHECKERROR(err,TESTNO,"Step 18");
+    }
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST P: build deserialized graphs in bulk */
+
+#define TESTNO "TEST P"
+
+void testP()
+{
+  graphlib_graph_p    gr,gr2,gr3;
+  graphlib_error_t    err;
+  graphlib_nodeattr_t nattr;
+  char                *ba=0;
+  uint64_t            ba_len=0;
+  int                 num_nodes,num_edges,index;
+  void                *values[2];
+
+  err=graphlib_loadGraph("demo-l5.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_serializeGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 2");
+  err=graphlib_deserializeGraph(&gr2,NULL,ba,ba_len);
+  CHECKERROR(err,TESTNO,"Step 3");
+  free(ba);
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 4");
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 5");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 6");
+
+  /* streams with duplicate node ids are merged node by node */
+
+  err=graphlib_newGraph(&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 7");
+  err=graphlib_addNodeNoCheck(gr,1,NULL);
+  CHECKERROR(err,TESTNO,"Step 8");
+  err=graphlib_addNodeNoCheck(gr,2,NULL);
+  CHECKERROR(err,TESTNO,"Step 9");
+  err=graphlib_addNodeNoCheck(gr,1,NULL);
+  CHECKERROR(err,TESTNO,"Step 10");
+  err=graphlib_addDirectedEdge(gr,1,2,NULL);
+  CHECKERROR(err,TESTNO,"Step 11");
+  err=graphlib_serializeGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 12");
+  err=graphlib_deserializeGraph(&gr2,NULL,ba,ba_len);
+  CHECKERROR(err,TESTNO,"Step 13");
+  free(ba);
+  graphlib_nodeCount(gr2,&num_nodes);
+  graphlib_edgeCount(gr2,&num_edges);
+  CHECKSAME((num_nodes==2) && (num_edges==1),TESTNO,"Step 14");
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 15");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 16");
+
+  /* labels borrowed from the buffer, copied before the buffer goes */
+
+  err=graphlib_loadGraph("demo-h.grl",&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 17");
+  err=graphlib_serializeGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 18");
+  err=graphlib_deserializeGraphFlags(&gr2,NULL,ba,ba_len,GRD_BORROW);
+  CHECKERROR(err,TESTNO,"Step 19");
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 20");
+  err=graphlib_materializeLabels(gr2);
+  CHECKERROR(err,TESTNO,"Step 21");
+  memset(ba,0,ba_len);
+  free(ba);
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 22");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 23");
+
+  /* merging into a graph with borrowed labels copies them first */
+
+  err=graphlib_serializeGraph(gr,&ba,&ba_len);
+  CHECKERROR(err,TESTNO,"Step 24");
+  err=graphlib_deserializeGraphFlags(&gr2,NULL,ba,ba_len,GRD_BORROW);
+  CHECKERROR(err,TESTNO,"Step 25");
+
+  err=graphlib_newGraph(&gr3,NULL);
+  CHECKERROR(err,TESTNO,"Step 26");
+  err=graphlib_addNodeAttrKey(gr3,"test1",&index);
+  CHECKERROR(err,TESTNO,"Step 27");
+  err=graphlib_addNodeAttrKey(gr3,"test2",&index);
+  CHECKERROR(err,TESTNO,"Step 28");
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.label="merged";
+  nattr.attr_values=values;
+  values[0]="merged";
+  values[1]="merged";
+  err=graphlib_addNode(gr3,10000,&nattr);
+  CHECKERROR(err,TESTNO,"Step 29");
+
+  err=graphlib_mergeGraphs(gr,gr3);
+  CHECKERROR(err,TESTNO,"Step 30");
+  err=graphlib_mergeGraphs(gr2,gr3);
+  CHECKERROR(err,TESTNO,"Step 31");
+  memset(ba,0,ba_len);
+  free(ba);
+  CHECKSAME(sameGraph(gr,gr2),TESTNO,"Step 32");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 33");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 34");
+  err=graphlib_delGraph(gr3);
+  CHECKERROR(err,TESTNO,"Step 35");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST Q: export a small graph and compare with the expected text */
+
+#define TESTNO "TEST Q"
+
+char *expect_dot=
+  "digraph G {\n"
+  "\tnode [shape=record,style=filled,labeljust=c,height=0.2];\n"
+  "\t1 [pos=\"-1,-1\", label=\"main\", fillcolor=\"#FF0000\", "
+  "fontcolor=\"#FFFFFF\"];\n"
+  "\t2 [pos=\"-1,-1\", label=\"worker\", fillcolor=\"#fb71c721\", "
+  "fontcolor=\"#FFFFFF\"];\n"
+  "\t3 [pos=\"-1,-1\", label=\"idle\", fillcolor=\"#f9FFf9\", "
+  "fontcolor=\"#000000\"];\n"
+  "\t1 -> 2 [label=\"call\"]\n"
+  "\t1 -> 3 [label=\"wait\"]\n"
+  "}\n";
+
+char *expect_plaindot=
+  "digraph G {\n"
+  "\tnode [shape=record,style=filled,labeljust=c,height=0.2];\n"
+  "\t1 [pos=\"-1,-1\", label=\"main\", fillcolor=red, fontcolor=black];\n"
+  "\t2 [pos=\"-1,-1\", label=\"worker\", fillcolor=beige, "
+  "fontcolor=black];\n"
+  "\t3 [pos=\"-1,-1\", label=\"idle\", fillcolor=green, fontcolor=black];\n"
+  "\t1 -> 2 [label=\"call\"]\n"
+  "\t1 -> 3 [label=\"wait\"]\n"
+  "}\n";
+
+char *expect_gml=
+  "Creator \"LLNL-graphlib\"\n"
+  "Version 2.2\n"
+  "graph\n"
+  "[\n"
+  "\tdirected 1\n"
+  "\tnode\n"
+  "\t[\n"
+  "\t\tid 1\n"
+  "\t\tlabel \"main\"\n"
+  "\t\tgraphics\n"
+  "\t\t[\n"
+  "\t\t\ttype \"rectangle\"\n"
+  "\t\t\tfill \"#FF0000\"\n"
+  "\t\t\toutline \"#000000\"\n"
+  "\t\t\tx -1\n"
+  "\t\t\ty -1\n"
+  "\t\t\tw 2.500000\n"
+  "\t\t\th 20.000000\n"
+  "\t\t]\n"
+  "\t]\n"
+  "\tnode\n"
+  "\t[\n"
+  "\t\tid 2\n"
+  "\t\tlabel \"worker\"\n"
+  "\t\tgraphics\n"
+  "\t\t[\n"
+  "\t\t\ttype \"rectangle\"\n"
+  "\t\t\tfill \"#fb71c721\"\n"
+  "\t\t\toutline \"#000000\"\n"
+  "\t\t\tx -1\n"
+  "\t\t\ty -1\n"
+  "\t\t\tw 20.000000\n"
+  "\t\t\th 20.000000\n"
+  "\t\t]\n"
+  "\t]\n"
+  "\tnode\n"
+  "\t[\n"
+  "\t\tid 3\n"
+  "\t\tlabel \"idle\"\n"
+  "\t\tgraphics\n"
+  "\t\t[\n"
+  "\t\t\ttype \"rectangle\"\n"
+  "\t\t\tfill \"#f9FFf9\"\n"
+  "\t\t\toutline \"#000000\"\n"
+  "\t\t\tx -1\n"
+  "\t\t\ty -1\n"
+  "\t\t\tw 20.000000\n"
+  "\t\t\th 20.000000\n"
+  "\t\t]\n"
+  "\t]\n"
+  "\tedge\n"
+  "\t[\n"
+  "\t\tsource 1\n"
+  "\t\ttarget 2\n"
+  "\t\tlabel \"1\"\n"
+  "\t\tgraphics\n"
+  "\t\t[\n"
+  "\t\t\twidth 5.000000\n"
+  "\t\t\ttargetArrow \"standard\"\n"
+  "\t\t\tfill \"#FFecec\"\n"
+  "\t\t]\n"
+  "\t\tLabelGraphics\n"
+  "\t\t[\n"
+  "\t\t\ttext \"call\"\n"
+  "\t\t\tmodel   \"centered\"\n"
+  "\t\t\tposition        \"center\"\n"
+  "\t\t]\n"
+  "\t]\n"
+  "\tedge\n"
+  "\t[\n"
+  "\t\tsource 1\n"
+  "\t\ttarget 3\n"
+  "\t\tlabel \"1\"\n"
+  "\t\tgraphics\n"
+  "\t\t[\n"
+  "\t\t\twidth 3.333333\n"
+  "\t\t\ttargetArrow \"standard\"\n"
+  "\t\t\tfill \"#0000FF\"\n"
+  "\t\t]\n"
+  "\t\tLabelGraphics\n"
+  "\t\t[\n"
+  "\t\t\ttext \"wait\"\n"
+  "\t\t\tmodel   \"centered\"\n"
+  "\t\t\tposition        \"center\"\n"
+  "\t\t]\n"
+  "\t]\n"
+  "]\n";
+
+void testQ()
+{
+  graphlib_graph_p    gr;
+  graphlib_error_t    err;
+  graphlib_nodeattr_t nattr;
+  graphlib_edgeattr_t eattr;
+
+  err=graphlib_newGraph(&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+
+  /* one node for each kind of color: fixed, rainbow and spectrum */
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.color=GRC_RED;
+  nattr.width=2.5;
+  nattr.label="main";
+  err=graphlib_addNode(gr,1,&nattr);
+  CHECKERROR(err,TESTNO,"Step 2");
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.color=GRC_RAINBOW+100;
+  nattr.label="worker";
+  err=graphlib_addNode(gr,2,&nattr);
+  CHECKERROR(err,TESTNO,"Step 3");
+  graphlib_setDefNodeAttr(&nattr);
+  nattr.color=GRC_GREENSPEC+7;
+  nattr.w=3;
+  nattr.label="idle";
+  err=graphlib_addNode(gr,3,&nattr);
+  CHECKERROR(err,TESTNO,"Step 4");
+
+  graphlib_setDefEdgeAttr(&eattr);
+  eattr.color=GRC_REDSPEC+20;
+  eattr.width=1.5;
+  eattr.label="call";
+  err=graphlib_addDirectedEdge(gr,1,2,&eattr);
+  CHECKERROR(err,TESTNO,"Step 5");
+  graphlib_setDefEdgeAttr(&eattr);
+  eattr.color=GRC_BLUE;
+  eattr.label="wait";
+  err=graphlib_addDirectedEdge(gr,1,3,&eattr);
+  CHECKERROR(err,TESTNO,"Step 6");
+
+  err=graphlib_exportGraph("demo-q.dot",GRF_DOT,gr);
+  CHECKERROR(err,TESTNO,"Step 7");
+  CHECKSAME(sameText("demo-q.dot",expect_dot),TESTNO,"Step 8");
+  err=graphlib_exportGraph("demo-q.pdot",GRF_PLAINDOT,gr);
+  CHECKERROR(err,TESTNO,"Step 9");
+  CHECKSAME(sameText("demo-q.pdot",expect_plaindot),TESTNO,"Step 10");
+  err=graphlib_exportGraph("demo-q.gml",GRF_GML,gr);
+  CHECKERROR(err,TESTNO,"Step 11");
+  CHECKSAME(sameText("demo-q.gml",expect_gml),TESTNO,"Step 12");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 13");
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST R: export through the other export routines and compare
+   the output with graphlib_exportGraph */
+
+#define TESTNO "TEST R"
+
+void testR()
+{
+  graphlib_graph_p    gr[3],empty;
+  graphlib_error_t    err;
+  graphlib_nodeattr_t nattr;
+  graphlib_edgeattr_t eattr;
+  int                 g,fo,t,i,fd,calls;
+  char                label[32];
+  char                *buf;
+  const char          *ids,*offs,*heap;
+  uint64_t            len;
+  FILE                *f;
+  int                 formats[]={GRF_DOT,GRF_PLAINDOT,GRF_GML};
+  int                 threads[]={1,3,0};
+  int                 lod[]={0,10,100,7000,100000};
+  int                 num_nodes,num_edges;
+
+  err=graphlib_loadGraph("demo-b.grl",&gr[0],NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_loadGraph("demo-h.grl",&gr[1],NULL);
+  CHECKERROR(err,TESTNO,"Step 2");
+
+  /* a tree spanning several node and edge fragments, so that the
+     export is split between threads */
+  err=graphlib_newGraph(&gr[2],NULL);
+  CHECKERROR(err,TESTNO,"Step 3");
+  graphlib_setDefNodeAttr(&nattr);
+  graphlib_setDefEdgeAttr(&eattr);
+  for (i=0; i<7000; i++)
+    {
+      sprintf(label,"node%i",i);
+      nattr.label=label;
+      nattr.color=(i%3==0) ? GRC_RAINBOW+i%GRC_RAINBOWCOLORS : i%15;
+      nattr.width=i%7;
+      err=graphlib_addNode(gr[2],i,&nattr);
+      CHECKERROR(err,TESTNO,"Step 4");
+      if (i>0)
+        {
+          sprintf(label,"edge%i",i);
+          eattr.label=label;
+          eattr.color=GRC_REDSPEC+i%GRC_SPECTRUMRANGE;
+          err=graphlib_addDirectedEdge(gr[2],i/2,i,&eattr);
+          CHECKERROR(err,TESTNO,"Step 5");
+        }
+    }
+
+  for (g=0;g<3;g++)
+    {
+      for (fo=0;fo<sizeof(formats)/sizeof(int);fo++)
+        {
+          err=graphlib_exportGraph("demo-r.out",formats[fo],gr[g]);
+          CHECKERROR(err,TESTNO,"Step 6");
+
+          for (t=0;t<sizeof(threads)/sizeof(int);t++)
+            {
+              err=graphlib_exportGraphParallel("demo-r-par.out",formats[fo],
+                                               gr[g],threads[t]);
+              CHECKERROR(err,TESTNO,"Step 7");
+              CHECKSAME(sameFile("demo-r.out","demo-r-par.out"),
+                        TESTNO,"Step 8");
+            }
+
+          err=graphlib_exportGraphToBuffer(formats[fo],gr[g],&buf,&len);
+          CHECKERROR(err,TESTNO,"Step 9");
+          f=fopen("demo-r-buf.out","w");
+          fwrite(buf,1,len,f);
+          fclose(f);
+          free(buf);
+          CHECKSAME(sameFile("demo-r.out","demo-r-buf.out"),TESTNO,"Step 10");
+
+          fd=open("demo-r-fd.out",O_WRONLY|O_CREAT|O_TRUNC,0644);
+          err=graphlib_exportGraphToFd(fd,formats[fo],gr[g]);
+          CHECKERROR(err,TESTNO,"Step 11");
+          close(fd);
+          CHECKSAME(sameFile("demo-r.out","demo-r-fd.out"),TESTNO,"Step 12");
+
+          f=fopen("demo-r-file.out","w");
+          err=graphlib_exportGraphToFile(f,formats[fo],gr[g]);
+          CHECKERROR(err,TESTNO,"Step 13");
+          fclose(f);
+          CHECKSAME(sameFile("demo-r.out","demo-r-file.out"),TESTNO,"Step 14");
+
+          f=fopen("demo-r-sink.out","w");
+          err=graphlib_exportGraphToSink(formats[fo],gr[g],writeSink,f);
+          CHECKERROR(err,TESTNO,"Step 15");
+          fclose(f);
+          CHECKSAME(sameFile("demo-r.out","demo-r-sink.out"),TESTNO,"Step 16");
+
+          /* a failing sink stops the export with its error */
+          calls=0;
+          err=graphlib_exportGraphToSink(formats[fo],gr[g],failSink,&calls);
+          CHECKSAME((err==GRL_FILEERROR) && (calls==1),TESTNO,"Step 17");
+
+          /* gzip compression selected by the name or the flag, if graphlib
+             was built with zlib */
+          err=graphlib_exportGraph("demo-r.out.gz",formats[fo],gr[g]);
+          if (err!=GRL_UNKNOWNFORMAT)
+            {
+              CHECKERROR(err,TESTNO,"Step 18");
+              CHECKSAME(gzipLength("demo-r.out.gz")==fileLength("demo-r.out"),
+                        TESTNO,"Step 19");
+              err=graphlib_exportGraph("demo-r-gz.out",formats[fo]|GRF_GZIP,
+                                       gr[g]);
+              CHECKERROR(err,TESTNO,"Step 20");
+              CHECKSAME(sameFile("demo-r.out.gz","demo-r-gz.out"),
+                        TESTNO,"Step 21");
+              err=graphlib_exportGraphParallel("demo-r-par.out.gz",
+                                               formats[fo],gr[g],3);
+              CHECKERROR(err,TESTNO,"Step 22");
+              CHECKSAME(sameFile("demo-r.out.gz","demo-r-par.out.gz"),
+                        TESTNO,"Step 23");
+            }
+        }
+    }
+
+  /* binary columns: header, column table and, for the generated
+     tree, the node ids and labels */
+  for (g=0;g<3;g++)
+    {
+      err=graphlib_exportGraphToBuffer(GRF_BINCOL,gr[g],&buf,&len);
+      CHECKERROR(err,TESTNO,"Step 24");
+      CHECKSAME(checkBincol(buf,len,gr[g]),TESTNO,"Step 25");
+      if (g==2)
+        {
+          ids=buf+getLE(findColumn(buf,GRK_NODE_ID)+8,8);
+          offs=buf+getLE(findColumn(buf,GRK_NODE_LABEL)+8,8);
+          heap=buf+getLE(findColumn(buf,GRK_HEAP)+8,8);
+          for (i=0; i<7000; i++)
+            {
+              sprintf(label,"node%i",(int)getLE(ids+i*4,4));
+              CHECKSAME((getLE(offs+i*8+8,8)-getLE(offs+i*8,8)==
+                         strlen(label)) &&
+                        (memcmp(heap+getLE(offs+i*8,8),label,
+                                strlen(label))==0),TESTNO,"Step 26");
+            }
+        }
+      err=graphlib_exportGraph("demo-r.bin",GRF_BINCOL,gr[g]);
+      CHECKERROR(err,TESTNO,"Step 27");
+      f=fopen("demo-r-buf.bin","w");
+      fwrite(buf,1,len,f);
+      fclose(f);
+      free(buf);
+      CHECKSAME(sameFile("demo-r.bin","demo-r-buf.bin"),TESTNO,"Step 28");
+    }
+
+  /* level of detail: nothing for k=0, the whole tree for k at least
+     the number of nodes, and a smaller tree with summary nodes else */
+  err=graphlib_newGraph(&empty,NULL);
+  CHECKERROR(err,TESTNO,"Step 29");
+  err=graphlib_exportGraph("demo-r.out",GRF_DOT,empty);
+  CHECKERROR(err,TESTNO,"Step 30");
+  err=graphlib_exportGraphLOD("demo-r-lod.out",GRF_DOT,gr[2],0,GRW_WIDTH);
+  CHECKERROR(err,TESTNO,"Step 31");
+  CHECKSAME(sameFile("demo-r.out","demo-r-lod.out"),TESTNO,"Step 32");
+  for (i=0;i<sizeof(lod)/sizeof(int);i++)
+    {
+      err=graphlib_exportGraphLOD("demo-r-lod.bin",GRF_BINCOL,gr[2],
+                                  lod[i],GRW_WIDTH);
+      CHECKERROR(err,TESTNO,"Step 33");
+      buf=readFile("demo-r-lod.bin",&len);
+      CHECKSAME((buf!=NULL) && (len>=32),TESTNO,"Step 34");
+      num_nodes=getLE(buf+16,8);
+      num_edges=getLE(buf+24,8);
+      free(buf);
+      if (lod[i]==0)
+        {
+          CHECKSAME((num_nodes==0) && (num_edges==0),TESTNO,"Step 35");
+        }
+      else if (lod[i]>=7000)
+        {
+          CHECKSAME((num_nodes==7000) && (num_edges==6999),TESTNO,"Step 36");
+        }
+      else
+        {
+          CHECKSAME((num_nodes>lod[i]) && (num_nodes<7000) &&
+                    (num_edges==num_nodes-1),TESTNO,"Step 37");
+        }
+    }
+  CHECKSAME((graphlib_exportGraphLOD("demo-r-lod.out",GRF_DOT,gr[2],-1,
+                                     GRW_WIDTH)==GRL_INVALID) &&
+            (graphlib_exportGraphLOD("demo-r-lod.out",GRF_DOT,gr[2],10,
+                                     0)==GRL_INVALID) &&
+            (graphlib_exportGraphLOD("demo-r-lod.out",GRF_DOT,gr[2],10,
+                                     -3)==GRL_INVALID),TESTNO,"Step 38");
+  err=graphlib_delGraph(empty);
+  CHECKERROR(err,TESTNO,"Step 39");
+
+  for (g=0;g<3;g++)
+    {
+      err=graphlib_delGraph(gr[g]);
+      CHECKERROR(err,TESTNO,"Step 40");
+    }
+}
+
+#undef TESTNO
+
+/*-----------------------------------------------------*/
+/* TEST S: export with text buffer routines */
+
+#define TESTNO "TEST S"
+
+void testS()
+{
+  graphlib_graph_p    gr,gr2,gr3;
+  graphlib_error_t    err;
+  graphlib_nodeattr_t nattr,*attr;
+  graphlib_edgeattr_t eattr;
+  int                 fo,i;
+  char                label[PADLEN+1];
+  int                 formats[]={GRF_DOT,GRF_GML};
+
+  /* the same tree twice, the second one with labels padded as by
+     padText */
+  err=graphlib_newGraph(&gr,NULL);
+  CHECKERROR(err,TESTNO,"Step 1");
+  err=graphlib_newGraph(&gr2,NULL);
+  CHECKERROR(err,TESTNO,"Step 2");
+  graphlib_setDefNodeAttr(&nattr);
+  graphlib_setDefEdgeAttr(&eattr);
+  for (i=0; i<1000; i++)
+    {
+      sprintf(label,"node%i",i);
+      nattr.label=label;
+      err=graphlib_addNode(gr,i,&nattr);
+      CHECKERROR(err,TESTNO,"Step 3");
+      memset(label+strlen(label),'.',PADLEN-strlen(label));
+      label[PADLEN]=0;
+      err=graphlib_addNode(gr2,i,&nattr);
+      CHECKERROR(err,TESTNO,"Step 4");
+      if (i>0)
+        {
+          sprintf(label,"edge%i",i);
+          eattr.label=label;
+          err=graphlib_addDirectedEdge(gr,i/2,i,&eattr);
+          CHECKERROR(err,TESTNO,"Step 5");
+          err=graphlib_addDirectedEdge(gr2,i/2,i,&eattr);
+          CHECKERROR(err,TESTNO,"Step 6");
+        }
+    }
+
+  for (fo=0;fo<sizeof(formats)/sizeof(int);fo++)
+    {
+      err=graphlib_exportGraph("demo-s.out",formats[fo],gr);
+      CHECKERROR(err,TESTNO,"Step 7");
+
+      /* routines writing the default text give the same file */
+      err=graphlib_setTextBufFunctions(gr,copyText,NULL,copyText,NULL);
+      CHECKERROR(err,TESTNO,"Step 8");
+      err=graphlib_exportGraph("demo-s-buf.out",formats[fo],gr);
+      CHECKERROR(err,TESTNO,"Step 9");
+      CHECKSAME(sameFile("demo-s.out","demo-s-buf.out"),TESTNO,"Step 10");
+      err=graphlib_exportGraphParallel("demo-s-buf.out",formats[fo],gr,3);
+      CHECKERROR(err,TESTNO,"Step 11");
+      CHECKSAME(sameFile("demo-s.out","demo-s-buf.out"),TESTNO,"Step 12");
+
+      /* text longer than the space left in the output buffers */
+      short_calls=0;
+      err=graphlib_setTextBufFunctions(gr,padText,NULL,copyText,NULL);
+      CHECKERROR(err,TESTNO,"Step 13");
+      err=graphlib_exportGraph("demo-s-buf.out",formats[fo],gr);
+      CHECKERROR(err,TESTNO,"Step 14");
+      err=graphlib_exportGraph("demo-s-pad.out",formats[fo],gr2);
+      CHECKERROR(err,TESTNO,"Step 15");
+      CHECKSAME(sameFile("demo-s-pad.out","demo-s-buf.out") &&
+                (short_calls>0),TESTNO,"Step 16");
+
+      /* and back to the built in routines */
+      err=graphlib_setTextBufFunctions(gr,NULL,NULL,NULL,NULL);
+      CHECKERROR(err,TESTNO,"Step 17");
+      err=graphlib_exportGraph("demo-s-buf.out",formats[fo],gr);
+      CHECKERROR(err,TESTNO,"Step 18");
+      CHECKSAME(sameFile("demo-s.out","demo-s-buf.out"),TESTNO,"Step 19");
+    }
+
+  /* kept text: repeated exports are unchanged, and labels replaced,
+     merged or changed in place and forgotten are exported anew */
+  err=graphlib_setTextCache(gr,1);
+  CHECKERROR(err,TESTNO,"Step 20");
+  for (i=0; i<2; i++)
+    {
+      err=graphlib_exportGraph("demo-s-buf.out",GRF_DOT,gr);
+      CHECKERROR(err,TESTNO,"Step 21");
+      err=graphlib_exportGraph("demo-s.out",GRF_DOT,gr);
+      CHECKERROR(err,TESTNO,"Step 22");
+      CHECKSAME(sameFile("demo-s.out","demo-s-buf.out"),TESTNO,"Step 23");
+    }
+
+  nattr.label="replaced";
+  err=graphlib_addNode(gr,7,&nattr);
+  CHECKERROR(err,TESTNO,"Step 24");
+  err=graphlib_newGraph(&gr3,NULL);
+  CHECKERROR(err,TESTNO,"Step 25");
+  nattr.label="merged";
+  err=graphlib_addNode(gr3,9,&nattr);
+  CHECKERROR(err,TESTNO,"Step 26");
+  err=graphlib_mergeGraphs(gr,gr3);
+  CHECKERROR(err,TESTNO,"Step 27");
+  err=graphlib_delGraph(gr3);
+  CHECKERROR(err,TESTNO,"Step 28");
+  err=graphlib_getNodeAttr(gr,11,&attr);
+  CHECKERROR(err,TESTNO,"Step 29");
+  ((char*)attr->label)[0]='N';
+  err=graphlib_forgetText(gr,attr->label);
+  CHECKERROR(err,TESTNO,"Step 30");
+
+  err=graphlib_exportGraph("demo-s-buf.out",GRF_DOT,gr);
+  CHECKERROR(err,TESTNO,"Step 31");
+  err=graphlib_setTextCache(gr,0);
+  CHECKERROR(err,TESTNO,"Step 32");
+  err=graphlib_exportGraph("demo-s.out",GRF_DOT,gr);
+  CHECKERROR(err,TESTNO,"Step 33");
+  CHECKSAME(sameFile("demo-s.out","demo-s-buf.out"),TESTNO,"Step 34");
+
+  err=graphlib_delGraph(gr);
+  CHECKERROR(err,TESTNO,"Step 35");
+  err=graphlib_delGraph(gr2);
+  CHECKERROR(err,TESTNO,"Step 36");
+}
+
+#undef TESTNO
+
 /*-----------------------------------------------------*/
 /* MAIN */
 
@@ -761,6 +2214,28 @@ int main(int argc, char **argv)
   printf("Completed test G\n");
   testH();
   printf("Completed test H\n");
+  testI();
+  printf("Completed test I\n");
+  testJ();
+  printf("Completed test J\n");
+  testK();
+  printf("Completed test K\n");
+  testL();
+  printf("Completed test L\n");
+  testM();
+  printf("Completed test M\n");
+  testN();
+  printf("Completed test N\n");
+  testO();
+  printf("Completed test O\n");
+  testP();
+  printf("Completed test P\n");
+  testQ();
+  printf("Completed test Q\n");
+  testR();
+  printf("Completed test R\n");
+  testS();
+  printf("Completed test S\n");
 
   err=graphlib_Finish();
   CHECKERROR(err,TESTNO,"Step 0");
@@ -45,9 +45,18 @@ Boston, MA 02111-1307 USA
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <pthread.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <errno.h>
 #include <string.h>
+#include <stddef.h>
 #include <assert.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 #include "graphlib.h"
 
 /*-----------------------------------------------------------------*/
@@ -80,6 +89,170 @@ Boston, MA 02111-1307 USA
 #define EDGEFRAGSIZE 2000
 
 
+/*.......................................................*/
+/* Scatter/gather serialization */
+
+/* labels shorter than this are copied rather than referenced */
+#define IOV_MINREF 64
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+
+/*.......................................................*/
+/* Streaming output: number and size of the ring buffers */
+
+#define XO_BUFFERS 4
+#define XO_BUFSIZE (1024*1024)
+
+
+/*.......................................................*/
+/* Compressed export: deflate level and chunk size; text exports
+   are repetitive enough that the fastest level compresses well */
+
+#define XG_LEVEL Z_BEST_SPEED
+#define XG_CHUNK (256*1024)
+
+
+/*.......................................................*/
+/* Text export: color strings of each kind for every GRC_ color,
+   both spectra and all rainbow colors; the last entry is shared by
+   all unknown colors */
+
+#define XE_COLORLEN  16
+#define XE_COLORS    (GRL_NUM_COLORS+2*GRC_SPECTRUMRANGE+GRC_RAINBOWCOLORS+1)
+#define XE_DOTFILL   0
+#define XE_DOTFONT   1
+#define XE_PLAINFILL 2
+#define XE_PLAINFONT 3
+#define XE_KINDS     4
+
+/* largest scaled value written without printf, see grlibint_outDouble */
+#define XE_MAXFAST   1e12
+
+/* labels and attribute values written by grlibint_outText, and the
+   space offered to the text buffer routines at least */
+#define XT_NODE      0
+#define XT_NODEATTR  1
+#define XT_EDGE      2
+#define XT_EDGEATTR  3
+#define XT_MINBUF    256
+
+/* initial hash table size of the text cache, see grlibint_textcache_t */
+#define XT_CACHEMIN  1024
+
+
+/*.......................................................*/
+/* Binary columnar export (GRF_BINCOL), layout in graphlib.h
+   - columns start at multiples of XB_ALIGN */
+
+#define XB_MAGIC       "\211GRC\r\n\032\n"
+#define XB_MAGICLEN    8
+#define XB_VERSION     1
+#define XB_ALIGN       8
+#define XB_FIXED       12  /* columns besides the annotation columns */
+
+
+/*.......................................................*/
+/* Extended serialization stream
+   - starts with a magic whose first four bytes are a negative int in
+     either byte order, so it can never be mistaken for the node count
+     that starts a version 1 stream
+   - followed by a version byte, a flags byte (GRE_ encodings plus
+     XS_FULL or XS_MASK), a byte with the GRM_ fields of XS_MASK
+     streams and a reserved byte
+   - streams without XS_MASK hold all fields (XS_FULL) or labels and
+     attributes only */
+
+#define XS_MAGIC       "\211GL\212"
+#define XS_MAGICLEN    4
+#define XS_HEADERLEN   8
+#define XS_VERSION     1
+#define XS_FULL        0x80
+#define XS_MASK        0x40
+#define XS_ENCODINGS   (GRE_COMPACT|GRE_INDEX|GRE_COLUMNAR|GRE_DICT)
+
+/* nodes and edges per chunk of the GRE_INDEX offset index */
+#define XS_CHUNK       4096
+
+/* alignment of the column blocks of GRE_COLUMNAR streams */
+#define XS_ALIGN       8
+
+/* integral widths below this are stored as varints */
+#define XS_MAXINTWIDTH 4503599627370496.0
+
+
+/*.......................................................*/
+/* Incremental decoder */
+
+/* read size and minimum buffer size */
+#define XD_CHUNK       (64*1024)
+
+/* input modes, decided by the first bytes */
+#define XD_UNKNOWN     0
+#define XD_PLAIN       1
+#define XD_FRAMED      2
+
+/* decoding states */
+#define XD_START       0
+#define XD_HEADER      1
+#define XD_NODES       2
+#define XD_EDGES       3
+#define XD_DONE        4
+#define XD_COLLECT     5  /* columnar stream, decoded when complete */
+
+
+/*.......................................................*/
+/* Indexed serialization layout (graph views and file format v2)
+   - version 1 is the length prefixed stream written by
+     graphlib_serializeGraph, it has no header */
+
+#define IX_MAGIC       "\211GRL\r\n\032\n"
+#define IX_MAGICLEN    8
+#define IX_VERSION     2
+#define IX_BYTEORDER   0x01020304
+
+/* header flags */
+#define IX_FLAG_CHECKSUM 0x1
+
+/* sections, in file order */
+#define IX_ANNOTATIONS 0
+#define IX_ATTRKEYS    1
+#define IX_NODES       2
+#define IX_EDGES       3
+#define IX_HEAP        4
+#define IX_SECTIONS    5
+
+#define IX_NOINDEX     UINT64_MAX
+
+
+/*.......................................................*/
+/* Block compression frame (GRE_COMPRESS and compressed .grl files)
+   - magic chosen like XS_MAGIC, followed by version and codec bytes,
+     the block size and the total uncompressed length
+   - blocks are compressed independently and carry their own sizes
+     and CRC-32, so they can be decoded in parallel or as they arrive */
+
+#define XZ_MAGIC       "\211GZ\212"
+#define XZ_MAGICLEN    4
+#define XZ_HEADERLEN   24
+#define XZ_VERSION     1
+#define XZ_CODEC_LZ4   1
+#define XZ_BLOCKSIZE   (256*1024)
+#define XZ_BLOCKHDR    (3*sizeof(uint32_t))
+#define XZ_STORED      0x80000000U
+#define XZ_MAXRATIO    255
+
+/* LZ4 block format parameters */
+#define LZ_HASHLOG       13
+#define LZ_MINMATCH      4
+#define LZ_LASTLITERALS  5
+#define LZ_MFLIMIT       12
+#define LZ_MAXOFFSET     65535
+#define LZ_SKIPSTRENGTH  6
+
+
 /*-----------------------------------------------------------------*/
 /* Types */
 
@@ -156,6 +329,215 @@ typedef struct graphlib_edgefragment_d
 } graphlib_edgefragment_t;
 
 
+/*............................................................*/
+/* Indexed layout
+   - a header with a section table, followed by the sections
+   - all records have a fixed size and are 8 byte aligned, variable
+     length data (keys, labels, attributes) lives in the heap and is
+     referenced through (offset,length) slots
+   - nodes are sorted by id, edges by (from,to) */
+
+typedef struct grlibint_ixslot_d
+{
+  uint64_t off;
+  uint64_t len;
+} grlibint_ixslot_t;
+
+typedef struct grlibint_ixsection_d
+{
+  uint64_t off;
+  uint64_t len;
+  uint32_t crc;
+  uint32_t reserved;
+} grlibint_ixsection_t;
+
+typedef struct grlibint_ixheader_d
+{
+  char                 magic[IX_MAGICLEN];
+  uint32_t             version;
+  uint32_t             byteorder;
+  uint64_t             total_len;
+  uint64_t             num_nodes;
+  uint64_t             num_edges;
+  int32_t              numannotation;
+  int32_t              num_node_attrs;
+  int32_t              num_edge_attrs;
+  int32_t              directed;
+  uint32_t             node_rec;
+  uint32_t             edge_rec;
+  uint32_t             flags;
+  uint32_t             header_crc;
+  grlibint_ixsection_t section[IX_SECTIONS];
+} grlibint_ixheader_t;
+
+typedef struct grlibint_ixnode_d
+{
+  graphlib_width_t    width,w,height;
+  graphlib_node_t     id;
+  graphlib_color_t    color;
+  graphlib_coor_t     x,y;
+  graphlib_fontsize_t fontsize;
+  int32_t             pad;
+  uint64_t            out_first;
+  uint64_t            out_count;
+  grlibint_ixslot_t   label;
+  /* followed by num_node_attrs slots and numannotation annotations */
+} grlibint_ixnode_t;
+
+typedef struct grlibint_ixedge_d
+{
+  graphlib_width_t    width;
+  graphlib_node_t     node_from;
+  graphlib_node_t     node_to;
+  graphlib_color_t    color;
+  graphlib_arc_t      arcstyle;
+  graphlib_block_t    block;
+  graphlib_fontsize_t fontsize;
+  uint64_t            index_from;
+  uint64_t            index_to;
+  grlibint_ixslot_t   label;
+  /* followed by num_edge_attrs slots */
+} grlibint_ixedge_t;
+
+/* nodes are collected together with their annotations before sorting */
+
+typedef struct grlibint_ixsrcnode_d
+{
+  graphlib_nodedata_p   node;
+  graphlib_annotation_t *grannot;
+} grlibint_ixsrcnode_t;
+
+/* sorted nodes and edges together with the header of the layout */
+
+typedef struct grlibint_ixplan_d
+{
+  grlibint_ixheader_t  hdr;
+  grlibint_ixsrcnode_t *nodes;
+  graphlib_edgedata_p  *edges;
+} grlibint_ixplan_t;
+
+
+/*............................................................*/
+/* Streaming output */
+
+typedef struct grlibint_ostream_d
+{
+  graphlib_sink_fn write;    /* NULL for in-memory streams */
+  void             *arg;
+  char             *buf[XO_BUFFERS];
+  uint64_t         cap[XO_BUFFERS];
+  uint64_t         used[XO_BUFFERS];
+  int              fill;     /* buffer being filled by the caller */
+  int              drain;    /* next buffer to write */
+  int              queued;   /* buffers waiting for the writer */
+  int              closing;
+  int              threaded;
+  graphlib_error_t err;      /* write error, protected by lock */
+  graphlib_error_t failed;   /* allocation error of the caller */
+  int              checksum; /* keep the running checksum */
+  uint32_t         crc;
+  pthread_t        thread;
+  pthread_mutex_t  lock;
+  pthread_cond_t   cond;
+} grlibint_ostream_t;
+
+
+/*............................................................*/
+/* Text export color strings */
+
+typedef struct grlibint_colortab_d
+{
+  char          str[XE_KINDS][XE_COLORS][XE_COLORLEN];
+  unsigned char len[XE_KINDS][XE_COLORS];
+} grlibint_colortab_t;
+
+
+/*............................................................*/
+/* Text cache of labels and attribute values
+   - entries are found by the address of the label in a hash table
+     with linear probing (entry+1, 0 for empty slots)
+   - forgotten entries keep their slot with label NULL until the
+     table is rebuilt
+   - parallel exports hold lock while they look up or add text */
+
+typedef struct grlibint_textentry_d
+{
+  const void *label;
+  const char *key;
+  int        kind;
+  char       *text;    /* NULL if the _to_text routine returned NULL */
+  size_t     len;
+} grlibint_textentry_t;
+
+typedef struct grlibint_textcache_d
+{
+  grlibint_textentry_t *entries;
+  uint32_t             num;
+  uint32_t             cap;
+  uint32_t             *hash;
+  uint32_t             hash_size;
+  pthread_mutex_t      lock;
+} grlibint_textcache_t;
+
+
+/*............................................................*/
+/* Text buffer routines of a graph, see graphlib_setTextBufFunctions */
+
+typedef struct grlibint_textbuf_d
+{
+  graphlib_text_buf_fn      node;
+  graphlib_attr_text_buf_fn node_attr;
+  graphlib_text_buf_fn      edge;
+  graphlib_attr_text_buf_fn edge_attr;
+} grlibint_textbuf_t;
+
+
+/*............................................................*/
+/* Binary columnar export header and column table entries */
+
+typedef struct grlibint_bcheader_d
+{
+  char     magic[XB_MAGICLEN];
+  uint32_t version;
+  uint32_t num_columns;
+  uint64_t num_nodes;
+  uint64_t num_edges;
+} grlibint_bcheader_t;
+
+typedef struct grlibint_bccolumn_d
+{
+  uint32_t kind;
+  uint32_t index;
+  uint64_t offset;
+  uint64_t count;
+} grlibint_bccolumn_t;
+
+
+/*............................................................*/
+/* Lazily loaded graphs
+   - the file stays mapped (or decompressed in memory) and a view on
+     it provides the labels and attribute values, which are decoded
+     when first needed
+   - nodes and edges still waiting for that have attr_values set to
+     grlibint_pending_values; nodes occupy the entries of nodefrags in
+     view order, edges those of edgefrags in view order without the
+     edges that were dropped
+   - the checksum of the heap is verified when the first label is
+     needed */
+
+typedef struct grlibint_lazy_d
+{
+  char                    *buf;
+  uint64_t                len;
+  int                     mapped;
+  graphlib_graphview_t    view;
+  graphlib_nodefragment_p *nodefrags;
+  graphlib_edgefragment_p *edgefrags;
+  int                     num_nodefrags;
+  int                     heap_checked;
+} grlibint_lazy_t;
+
+
 /*............................................................*/
 /* Graph and Graphlist */
 
@@ -174,6 +556,10 @@ typedef struct graphlib_graph_d
   graphlib_nodeentry_p     freenodes;
   graphlib_edgeentry_p     freeedges;
   graphlib_functiontable_p functions;
+  graphlib_functiontable_p borrowed;  /* caller table if labels are borrowed */
+  grlibint_lazy_t          *lazy;     /* source of labels not decoded yet */
+  grlibint_textcache_t     *textcache; /* text kept between exports */
+  grlibint_textbuf_t       textbuf;   /* caller text buffer routines */
 } graphlib_graph_t;
 
 typedef struct graphlib_graphlist_d *graphlib_graphlist_p;
@@ -195,6 +581,9 @@ static long node_clusters[GRC_RAINBOWCOLORS];
 /* Default function table */
 static graphlib_functiontable_p default_functions=NULL;
 
+/* Marks attr_values of nodes and edges of lazily loaded graphs */
+static void *grlibint_pending_values[1];
+
 
 
 /*-----------------------------------------------------------------*/
@@ -403,6 +792,220 @@ graphlib_error_t grlibint_findNodeEdge(graphlib_graph_p graph,
   return GRL_NOEDGE;
 }
 
+/*............................................................*/
+/* text cache: hash of a label address */
+
+uint32_t grlibint_textHash(const void *label)
+{
+  uint64_t v=(uint64_t)(uintptr_t)label;
+
+  return (uint32_t)(((v>>3)*11400714819323198485ULL)>>32);
+}
+
+
+/*............................................................*/
+/* text cache: drop forgotten entries and size the hash table for
+   the remaining ones */
+
+graphlib_error_t grlibint_textRebuild(grlibint_textcache_t *cache)
+{
+  uint32_t *hash;
+  uint32_t size,i,n,h;
+
+  n=0;
+  for (i=0;i<cache->num;i++)
+    {
+      if (cache->entries[i].label!=NULL)
+        cache->entries[n++]=cache->entries[i];
+    }
+  cache->num=n;
+
+  size=XT_CACHEMIN;
+  while ((n+1)*4>size)
+    size*=2;
+  hash=(uint32_t*)calloc(size,sizeof(uint32_t));
+  if (hash==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<n;i++)
+    {
+      h=grlibint_textHash(cache->entries[i].label)&(size-1);
+      while (hash[h]!=0)
+        h=(h+1)&(size-1);
+      hash[h]=i+1;
+    }
+  free(cache->hash);
+  cache->hash=hash;
+  cache->hash_size=size;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* text cache: find the text of a label, returns 0 if it is not kept */
+
+int grlibint_textFind(grlibint_textcache_t *cache, int kind, const char *key,
+                      const void *label, const char **otext, size_t *olen)
+{
+  grlibint_textentry_t *entry;
+  uint32_t             h,e;
+  int                  found=0;
+
+  pthread_mutex_lock(&(cache->lock));
+  if (cache->hash_size>0)
+    {
+      h=grlibint_textHash(label)&(cache->hash_size-1);
+      while ((!found) && ((e=cache->hash[h])!=0))
+        {
+          entry=&(cache->entries[e-1]);
+          if ((entry->label==label) && (entry->kind==kind) &&
+              (entry->key==key))
+            {
+              *otext=entry->text;
+              *olen=entry->len;
+              found=1;
+            }
+          h=(h+1)&(cache->hash_size-1);
+        }
+    }
+  pthread_mutex_unlock(&(cache->lock));
+  return found;
+}
+
+
+/*............................................................*/
+/* text cache: keep the text of a label
+   - the cache owns text afterwards, unless 0 is returned because
+     the label is kept already or memory is short */
+
+int grlibint_textAdd(grlibint_textcache_t *cache, int kind, const char *key,
+                     const void *label, char *text)
+{
+  grlibint_textentry_t *entry;
+  graphlib_error_t     err=GRL_OK;
+  uint32_t             h,e,size;
+  void                 *p;
+
+  pthread_mutex_lock(&(cache->lock));
+  if ((cache->num+1)*2>cache->hash_size)
+    err=grlibint_textRebuild(cache);
+  if ((GRL_IS_OK(err)) && (cache->num==cache->cap))
+    {
+      size=(cache->cap==0) ? XT_CACHEMIN : cache->cap*2;
+      p=realloc(cache->entries,size*sizeof(grlibint_textentry_t));
+      if (p==NULL)
+        err=GRL_NOMEM;
+      else
+        {
+          cache->entries=(grlibint_textentry_t*)p;
+          cache->cap=size;
+        }
+    }
+  if (GRL_IS_NOTOK(err))
+    {
+      pthread_mutex_unlock(&(cache->lock));
+      return 0;
+    }
+
+  h=grlibint_textHash(label)&(cache->hash_size-1);
+  while ((e=cache->hash[h])!=0)
+    {
+      entry=&(cache->entries[e-1]);
+      if ((entry->label==label) && (entry->kind==kind) &&
+          (entry->key==key))
+        {
+          pthread_mutex_unlock(&(cache->lock));
+          return 0;
+        }
+      h=(h+1)&(cache->hash_size-1);
+    }
+
+  entry=&(cache->entries[cache->num]);
+  entry->label=label;
+  entry->key=key;
+  entry->kind=kind;
+  entry->text=text;
+  entry->len=(text!=NULL) ? strlen(text) : 0;
+  cache->num++;
+  cache->hash[h]=cache->num;
+  pthread_mutex_unlock(&(cache->lock));
+  return 1;
+}
+
+
+/*............................................................*/
+/* text cache: forget the text of a label, or of all labels if label
+   is NULL */
+
+void grlibint_textForget(grlibint_textcache_t *cache, const void *label)
+{
+  grlibint_textentry_t *entry;
+  uint32_t             h,e,i;
+
+  if (label==NULL)
+    {
+      for (i=0;i<cache->num;i++)
+        free(cache->entries[i].text);
+      cache->num=0;
+      if (cache->hash!=NULL)
+        memset(cache->hash,0,cache->hash_size*sizeof(uint32_t));
+      return;
+    }
+  if (cache->hash_size==0)
+    return;
+
+  h=grlibint_textHash(label)&(cache->hash_size-1);
+  while ((e=cache->hash[h])!=0)
+    {
+      entry=&(cache->entries[e-1]);
+      if (entry->label==label)
+        {
+          free(entry->text);
+          entry->text=NULL;
+          entry->label=NULL;
+        }
+      h=(h+1)&(cache->hash_size-1);
+    }
+}
+
+
+/*............................................................*/
+/* text cache: forget the label and attribute values of a node or
+   edge before they are freed or merged */
+
+void grlibint_textForgetLabels(graphlib_graph_p graph, int is_node,
+                               const void *label, void **attr_values)
+{
+  int j,num;
+
+  if (graph->textcache==NULL)
+    return;
+  if (label!=NULL)
+    grlibint_textForget(graph->textcache,label);
+  if ((attr_values==NULL) || (attr_values==grlibint_pending_values))
+    return;
+  num=(is_node) ? graph->num_node_attrs : graph->num_edge_attrs;
+  for (j=0;j<num;j++)
+    {
+      if (attr_values[j]!=NULL)
+        grlibint_textForget(graph->textcache,attr_values[j]);
+    }
+}
+
+
+/*............................................................*/
+/* text cache: free it */
+
+void grlibint_textFree(grlibint_textcache_t *cache)
+{
+  grlibint_textForget(cache,NULL);
+  free(cache->entries);
+  free(cache->hash);
+  pthread_mutex_destroy(&(cache->lock));
+  free(cache);
+}
+
+
 /*............................................................*/
 /* delete a node */
 
@@ -415,13 +1018,18 @@ graphlib_error_t grlibint_delNode(graphlib_graph_p graph,
       return GRL_NONODE;
     }
 
-  graph->functions->free_node(node->entry.data.attr.label);
-
-  for (i=0; i<graph->num_node_attrs; i++)
+  if (node->entry.data.attr.attr_values!=grlibint_pending_values)
     {
-      graph->functions->free_node_attr(graph->node_attr_keys[i], node->entry.data.attr.attr_values[i]);
+      grlibint_textForgetLabels(graph,1,node->entry.data.attr.label,
+                                node->entry.data.attr.attr_values);
+      graph->functions->free_node(node->entry.data.attr.label);
+
+      for (i=0; i<graph->num_node_attrs; i++)
+        {
+          graph->functions->free_node_attr(graph->node_attr_keys[i], node->entry.data.attr.attr_values[i]);
+        }
+      free(node->entry.data.attr.attr_values);
     }
-  free(node->entry.data.attr.attr_values);
 
   node->full=0;
   node->entry.freeptr=graph->freenodes;
@@ -443,21 +1051,45 @@ graphlib_error_t grlibint_delEdge(graphlib_graph_p graph,
       return GRL_NOEDGE;
     }
 
-  for (i=0; i<graph->num_edge_attrs; i++)
+  if (edge->entry.data.attr.attr_values!=grlibint_pending_values)
     {
-      graph->functions->free_edge_attr(graph->edge_attr_keys[i], edge->entry.data.attr.attr_values[i]);
+      grlibint_textForgetLabels(graph,0,edge->entry.data.attr.label,
+                                edge->entry.data.attr.attr_values);
+      for (i=0; i<graph->num_edge_attrs; i++)
+        {
+          graph->functions->free_edge_attr(graph->edge_attr_keys[i], edge->entry.data.attr.attr_values[i]);
+        }
+      free(edge->entry.data.attr.attr_values);
+      graph->functions->free_edge(edge->entry.data.attr.label);
     }
-  free(edge->entry.data.attr.attr_values);
 
   edge->full=0;
   edge->entry.freeptr=graph->freeedges;
-  graph->functions->free_edge(edge->entry.data.attr.label);
   graph->freeedges=edge;
 
   return GRL_OK;
 }
 
 
+/*............................................................*/
+/* release the source of a lazily loaded graph */
+
+void grlibint_freeLazy(grlibint_lazy_t *lazy)
+{
+  if (lazy->mapped)
+    munmap(lazy->buf,lazy->len);
+  else
+    free(lazy->buf);
+  free(lazy->nodefrags);
+  free(lazy->edgefrags);
+  free(lazy);
+}
+
+
+/* decodes pending labels, defined with graphlib_loadGraphLazy */
+graphlib_error_t grlibint_lazyLoadAll(graphlib_graph_p graph);
+
+
 /*............................................................*/
 /* create and register a new graph */
 
@@ -539,12 +1171,104 @@ graphlib_error_t grlibint_newEdgeFragment(graphlib_edgefragment_p *newedgefrag)
 }
 
 
+/*............................................................*/
+/* preallocate the node fragments for num entries
+   - linked newest first with all but the last one full, just as
+     graphlib_addNode would have left them */
+
+graphlib_error_t grlibint_allocNodeFrags(graphlib_graph_p graph, int num,
+                                         graphlib_nodefragment_p **ofrags)
+{
+  graphlib_error_t err;
+  int              i,nfrags;
+
+  nfrags=(num+NODEFRAGSIZE-1)/NODEFRAGSIZE;
+  *ofrags=(graphlib_nodefragment_p*)calloc(nfrags+1,
+                                           sizeof(graphlib_nodefragment_p));
+  if (*ofrags==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<nfrags;i++)
+    {
+      err=grlibint_newNodeFragment(&((*ofrags)[i]),graph->numannotation);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      (*ofrags)[i]->count=(i<nfrags-1) ? NODEFRAGSIZE :
+                                         num-i*NODEFRAGSIZE;
+      (*ofrags)[i]->next=graph->nodes;
+      graph->nodes=(*ofrags)[i];
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* preallocate the edge fragments for num entries */
+
+graphlib_error_t grlibint_allocEdgeFrags(graphlib_graph_p graph, int num,
+                                         graphlib_edgefragment_p **ofrags)
+{
+  graphlib_error_t err;
+  int              i,nfrags;
+
+  nfrags=(num+EDGEFRAGSIZE-1)/EDGEFRAGSIZE;
+  *ofrags=(graphlib_edgefragment_p*)calloc(nfrags+1,
+                                           sizeof(graphlib_edgefragment_p));
+  if (*ofrags==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<nfrags;i++)
+    {
+      err=grlibint_newEdgeFragment(&((*ofrags)[i]));
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      (*ofrags)[i]->count=(i<nfrags-1) ? EDGEFRAGSIZE :
+                                         num-i*EDGEFRAGSIZE;
+      (*ofrags)[i]->next=graph->edges;
+      graph->edges=(*ofrags)[i];
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* CRC-32 (IEEE 802.3) used for section and block checksums */
+
+static uint32_t grlibint_crc_table[256];
+static int      grlibint_crc_init=0;
+
+uint32_t grlibint_crc32(uint32_t crc, const char *buf, uint64_t len)
+{
+  uint32_t c;
+  uint64_t i;
+  int      k;
+
+  if (!grlibint_crc_init)
+    {
+      for (i=0;i<256;i++)
+        {
+          c=(uint32_t)i;
+          for (k=0;k<8;k++)
+            c=(c&1) ? (0xEDB88320U^(c>>1)) : (c>>1);
+          grlibint_crc_table[i]=c;
+        }
+      grlibint_crc_init=1;
+    }
+
+  crc=~crc;
+  for (i=0;i<len;i++)
+    crc=grlibint_crc_table[(crc^(unsigned char)buf[i])&0xff]^(crc>>8);
+  return ~crc;
+}
+
+
 /*............................................................*/
 /* read a binary segment from disk */
 
-graphlib_error_t grlibint_read(int fh, char *buf, int len)
+graphlib_error_t grlibint_read(int fh, char *buf, uint64_t len)
 {
-  int sum,count;
+  uint64_t sum;
+  ssize_t  count;
 
   sum=0;
   while (sum!=len)
@@ -561,9 +1285,10 @@ graphlib_error_t grlibint_read(int fh, char *buf, int len)
 /*............................................................*/
 /* write a binary segment from disk */
 
-graphlib_error_t grlibint_write(int fh, char *buf, int len)
+graphlib_error_t grlibint_write(int fh, char *buf, uint64_t len)
 {
-  int sum,count;
+  uint64_t sum;
+  ssize_t  count;
 
   sum=0;
   while (sum!=len)
@@ -578,148 +1303,495 @@ graphlib_error_t grlibint_write(int fh, char *buf, int len)
 
 
 /*............................................................*/
-/* write len bytes of data from src to cur_pos (a marker into dest_array) -- realloc() as necessary
-   - updates cur_pos after write
-   - updates dest_array_len after realloc
-*/
+/* write a scatter/gather list to disk
+   - the iovec array is modified to track partial writes
+   - interrupted and short writes are retried, empty entries skipped */
 
-graphlib_error_t grlibint_copyDataToBuf(int *idx, const char *src, int len,
-                                        char **dest_array, int *dest_array_len)
+graphlib_error_t grlibint_writev(int fh, struct iovec *iov, int iovcnt)
 {
-  unsigned int alloc_size;
-  char         *dst;
-  if ((((*idx)+len)>(*dest_array_len)))
+  ssize_t count;
+  int     num;
+
+  while (iovcnt>0)
     {
-      alloc_size =  8192*(1+((*idx)+len)/8192);
-      *dest_array = (char*)realloc(*dest_array, alloc_size);
-      *dest_array_len = alloc_size;
+      if (iov->iov_len==0)
+        {
+          iov++;
+          iovcnt--;
+          continue;
+        }
+      num=(iovcnt>IOV_MAX) ? IOV_MAX : iovcnt;
+      count=writev(fh,iov,num);
+      if ((count<0) && (errno==EINTR))
+        continue;
+      if (count<=0)
+        return GRL_FILEERROR;
+      while ((iovcnt>0) && (count>=(ssize_t)iov->iov_len))
+        {
+          count-=iov->iov_len;
+          iov++;
+          iovcnt--;
+        }
+      if (count>0)
+        {
+          iov->iov_base=((char*)iov->iov_base)+count;
+          iov->iov_len-=count;
+        }
     }
-
-  dst=(*dest_array)+(*idx);
-  memcpy(dst,src,len);
-  (*idx)+=len;
-
-#ifdef DEBUG
-  fprintf(stderr,"[%s:%s():%d]: ", __FILE__,__FUNCTION__,__LINE__);
-  if (len == sizeof(int))
-    fprintf(stderr,"\tint: %d (%p) => %d (%p)\n",
-            *((int*)src),src,*((int*)dst),dst);
-  else if (len==sizeof(graphlib_width_t))
-    fprintf(stderr,"\tdouble: %.2lf (%p) => %.2lf (%p)\n",
-            *((double*)src),src,*((double*)dst),dst);
-  else
-    fprintf(stderr, "\tstring: \"%s\" (%p) => \"%s\" (%p)\n",src,src,dst,dst);
-#endif
-
   return GRL_OK;
 }
 
 
 /*............................................................*/
-/* read graph from a buffer */
+/* sink writing to the file descriptor passed as argument */
 
-graphlib_error_t grlibint_copyDataFromBuf(char *dst, int *idx, int len,
-                                          char *src_array, int src_array_len)
+graphlib_error_t grlibint_fdSink(void *arg, const char *buf, uint64_t len)
 {
-  char *src=src_array+*idx;
+  return grlibint_write((int)(intptr_t)arg,(char*)buf,len);
+}
 
-  /* check for array bounds read error */
-  if ((((*idx)+len)>(src_array_len)))
-    {
-      return GRL_MEMORYERROR;
-    }
 
-  memcpy(dst,src,len);
-  (*idx)+=len;
+/*............................................................*/
+/* sink writing to the stdio stream passed as argument */
+
+graphlib_error_t grlibint_fileSink(void *arg, const char *buf, uint64_t len)
+{
+  if ((len>0) && (fwrite(buf,1,len,(FILE*)arg)!=len))
+    return GRL_FILEERROR;
+  return GRL_OK;
+}
+
+
+#ifdef HAVE_ZLIB
+
+/*............................................................*/
+/* gzip compressing sink, passes the compressed data to another sink */
+
+typedef struct grlibint_gzsink_d
+{
+  z_stream         zs;
+  graphlib_sink_fn write;
+  void             *arg;
+  char             *out;
+} grlibint_gzsink_t;
+
+
+/*............................................................*/
+/* gzip sink: deflate the input, passing every full chunk on */
+
+graphlib_error_t grlibint_gzDeflate(grlibint_gzsink_t *gz, int flush)
+{
+  graphlib_error_t err;
+  int              ret;
+
+  do
+    {
+      gz->zs.next_out=(Bytef*)gz->out;
+      gz->zs.avail_out=XG_CHUNK;
+      ret=deflate(&(gz->zs),flush);
+      if (ret==Z_STREAM_ERROR)
+        return GRL_MEMORYERROR;
+      if (gz->zs.avail_out<XG_CHUNK)
+        {
+          err=gz->write(gz->arg,gz->out,XG_CHUNK-gz->zs.avail_out);
+          if (GRL_IS_FATALERROR(err))
+            return err;
+        }
+    }
+  while ((gz->zs.avail_out==0) || ((flush==Z_FINISH) && (ret!=Z_STREAM_END)));
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* gzip sink: write routine */
+
+graphlib_error_t grlibint_gzSink(void *arg, const char *buf, uint64_t len)
+{
+  grlibint_gzsink_t *gz=(grlibint_gzsink_t*)arg;
+  graphlib_error_t  err;
+  uInt              part;
+
+  while (len>0)
+    {
+      part=(len>XG_CHUNK) ? XG_CHUNK : (uInt)len;
+      gz->zs.next_in=(Bytef*)buf;
+      gz->zs.avail_in=part;
+      err=grlibint_gzDeflate(gz,Z_NO_FLUSH);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      buf+=part;
+      len-=part;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* gzip sink: set up compression in front of another sink */
+
+graphlib_error_t grlibint_gzOpen(grlibint_gzsink_t *gz,
+                                 graphlib_sink_fn write, void *arg)
+{
+  memset(gz,0,sizeof(grlibint_gzsink_t));
+  gz->write=write;
+  gz->arg=arg;
+  gz->out=(char*)malloc(XG_CHUNK);
+  if (gz->out==NULL)
+    return GRL_NOMEM;
+
+  /* window bits beyond 15 select the gzip wrapper */
+
+  if (deflateInit2(&(gz->zs),XG_LEVEL,Z_DEFLATED,15+16,8,
+                   Z_DEFAULT_STRATEGY)!=Z_OK)
+    {
+      free(gz->out);
+      return GRL_NOMEM;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* gzip sink: write the trailer (unless the export failed) and
+   release the compressor */
+
+graphlib_error_t grlibint_gzClose(grlibint_gzsink_t *gz, graphlib_error_t err)
+{
+  if (GRL_IS_OK(err))
+    {
+      gz->zs.avail_in=0;
+      err=grlibint_gzDeflate(gz,Z_FINISH);
+    }
+  deflateEnd(&(gz->zs));
+  free(gz->out);
+  return err;
+}
 
-#ifdef DEBUG
-  fprintf(stderr,"[%s:%s():%d]: ",__FILE__,__FUNCTION__,__LINE__);
-  if (len==sizeof(int))
-    fprintf(stderr,"int: %d (%p) <= %d (%p)\n",*((int*)dst),dst,*((int*)src),
-            src);
-  else if (len == sizeof(graphlib_width_t))
-    fprintf(stderr, "double: %.2lf (%p) <= %.2lf (%p)\n",
-            *((double*)dst),dst,*((double*)src),src);
-  else
-    fprintf(stderr, "string: \"%s\" (%p) <= \"%s\" (%p)\n",dst,dst,src,src);
 #endif
+
+
+/*............................................................*/
+/* run fn over an array of jobs, job 0 and any job whose thread
+   cannot be started run in the calling thread */
+
+void grlibint_runThreads(void *(*fn)(void*), void *jobs, size_t jobsize,
+                         int njobs)
+{
+  pthread_t *threads;
+  int       *started;
+  int       j;
+
+  threads=(pthread_t*)malloc(njobs*sizeof(pthread_t));
+  started=(int*)calloc(njobs,sizeof(int));
+  if ((threads!=NULL) && (started!=NULL))
+    {
+      for (j=1;j<njobs;j++)
+        started[j]=(pthread_create(&(threads[j]),NULL,fn,
+                                   (char*)jobs+j*jobsize)==0);
+    }
+  for (j=0;j<njobs;j++)
+    {
+      if ((started==NULL) || (!started[j]))
+        fn((char*)jobs+j*jobsize);
+    }
+  for (j=0;j<njobs;j++)
+    {
+      if ((started!=NULL) && started[j])
+        pthread_join(threads[j],NULL);
+    }
+  free(threads);
+  free(started);
+}
+
+
+/*............................................................*/
+/* streaming output: writer thread
+   - writes queued buffers in order until the stream is closed; after
+     an error the remaining buffers are only released */
+
+void *grlibint_ostreamThread(void *arg)
+{
+  grlibint_ostream_t *s=(grlibint_ostream_t*)arg;
+  graphlib_error_t   err;
+  int                b,skip;
+
+  pthread_mutex_lock(&(s->lock));
+  while (1)
+    {
+      while ((s->queued==0) && (!s->closing))
+        pthread_cond_wait(&(s->cond),&(s->lock));
+      if (s->queued==0)
+        break;
+      b=s->drain;
+      skip=GRL_IS_NOTOK(s->err);
+      pthread_mutex_unlock(&(s->lock));
+
+      err=GRL_OK;
+      if (!skip)
+        err=s->write(s->arg,s->buf[b],s->used[b]);
+
+      pthread_mutex_lock(&(s->lock));
+      if (GRL_IS_NOTOK(err) && GRL_IS_OK(s->err))
+        s->err=err;
+      s->drain=(s->drain+1)%XO_BUFFERS;
+      s->queued--;
+      pthread_cond_broadcast(&(s->cond));
+    }
+  pthread_mutex_unlock(&(s->lock));
+  return NULL;
+}
+
+
+/*............................................................*/
+/* streaming output: open a stream on a sink
+   - if no thread can be started, buffers are written synchronously */
+
+graphlib_error_t grlibint_ostreamOpenSink(grlibint_ostream_t *s,
+                                          graphlib_sink_fn write, void *arg)
+{
+  int i;
+
+  memset(s,0,sizeof(grlibint_ostream_t));
+  s->write=write;
+  s->arg=arg;
+  s->checksum=1;
+  for (i=0;i<XO_BUFFERS;i++)
+    {
+      s->cap[i]=XO_BUFSIZE;
+      s->buf[i]=(char*)malloc(XO_BUFSIZE);
+      if (s->buf[i]==NULL)
+        {
+          while (i>0)
+            free(s->buf[--i]);
+          return GRL_NOMEM;
+        }
+    }
+
+  pthread_mutex_init(&(s->lock),NULL);
+  pthread_cond_init(&(s->cond),NULL);
+  s->threaded=(pthread_create(&(s->thread),NULL,grlibint_ostreamThread,s)==0);
   return GRL_OK;
 }
 
 
-/*-----------------------------------------------------------------*/
-/* color management */
+/*............................................................*/
+/* streaming output: open a stream on a file descriptor */
+
+graphlib_error_t grlibint_ostreamOpen(grlibint_ostream_t *s, int fh)
+{
+  return grlibint_ostreamOpenSink(s,grlibint_fdSink,(void*)(intptr_t)fh);
+}
+
+
+/*............................................................*/
+/* streaming output: open an in-memory stream
+   - a single buffer that grows instead of being written, the caller
+     takes its contents and frees it */
+
+graphlib_error_t grlibint_ostreamOpenMem(grlibint_ostream_t *s)
+{
+  memset(s,0,sizeof(grlibint_ostream_t));
+  s->cap[0]=XO_BUFSIZE;
+  s->buf[0]=(char*)malloc(XO_BUFSIZE);
+  if (s->buf[0]==NULL)
+    return GRL_NOMEM;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* streaming output: hand the current buffer to the writer and
+   switch to the next free one */
+
+graphlib_error_t grlibint_ostreamSubmit(grlibint_ostream_t *s)
+{
+  graphlib_error_t err;
+
+  if (s->used[s->fill]==0)
+    return GRL_OK;
+
+  if (!s->threaded)
+    {
+      if (GRL_IS_OK(s->err))
+        s->err=s->write(s->arg,s->buf[s->fill],s->used[s->fill]);
+      s->used[s->fill]=0;
+      return s->err;
+    }
+
+  pthread_mutex_lock(&(s->lock));
+  s->queued++;
+  pthread_cond_broadcast(&(s->cond));
+  while (s->queued==XO_BUFFERS)
+    pthread_cond_wait(&(s->cond),&(s->lock));
+  err=s->err;
+  pthread_mutex_unlock(&(s->lock));
+
+  s->fill=(s->fill+1)%XO_BUFFERS;
+  s->used[s->fill]=0;
+  return err;
+}
+
+
+/*............................................................*/
+/* streaming output: get space for len bytes in the current buffer
+   - returns NULL if the stream failed */
+
+char *grlibint_ostreamReserve(grlibint_ostream_t *s, uint64_t len)
+{
+  char     *buf;
+  uint64_t cap;
+
+  if (s->used[s->fill]+len>s->cap[s->fill])
+    {
+      if ((s->write!=NULL) && GRL_IS_NOTOK(grlibint_ostreamSubmit(s)))
+        return NULL;
+      if (s->used[s->fill]+len>s->cap[s->fill])
+        {
+          /* single items larger than a buffer grow it, in-memory
+             streams grow by doubling */
+          cap=s->used[s->fill]+len;
+          if ((s->write==NULL) && (cap<2*s->cap[s->fill]))
+            cap=2*s->cap[s->fill];
+          buf=(char*)realloc(s->buf[s->fill],cap);
+          if (buf==NULL)
+            {
+              s->failed=GRL_NOMEM;
+              return NULL;
+            }
+          s->buf[s->fill]=buf;
+          s->cap[s->fill]=cap;
+        }
+    }
+  return s->buf[s->fill]+s->used[s->fill];
+}
+
+
+/*............................................................*/
+/* streaming output: append reserved bytes, they are included in the
+   running checksum unless that was turned off */
+
+void grlibint_ostreamCommit(grlibint_ostream_t *s, uint64_t len)
+{
+  if (s->checksum)
+    s->crc=grlibint_crc32(s->crc,s->buf[s->fill]+s->used[s->fill],len);
+  s->used[s->fill]+=len;
+}
+
+
+/*............................................................*/
+/* streaming output: return and reset the running checksum */
+
+uint32_t grlibint_ostreamCRC(grlibint_ostream_t *s)
+{
+  uint32_t crc;
+
+  crc=s->crc;
+  s->crc=0;
+  return crc;
+}
+
+
+/*............................................................*/
+/* streaming output: flush, stop the writer and release the buffers */
+
+graphlib_error_t grlibint_ostreamClose(grlibint_ostream_t *s)
+{
+  graphlib_error_t err;
+  int              i;
+
+  grlibint_ostreamSubmit(s);
+  if (s->threaded)
+    {
+      pthread_mutex_lock(&(s->lock));
+      s->closing=1;
+      pthread_cond_broadcast(&(s->cond));
+      pthread_mutex_unlock(&(s->lock));
+      pthread_join(s->thread,NULL);
+    }
+  pthread_mutex_destroy(&(s->lock));
+  pthread_cond_destroy(&(s->cond));
+
+  for (i=0;i<XO_BUFFERS;i++)
+    free(s->buf[i]);
+
+  err=s->err;
+  if (GRL_IS_OK(err))
+    err=s->failed;
+  return err;
+}
+
 
 /*............................................................*/
 /* color settings for GML export */
 
-void grlibint_exp_dot_color(graphlib_color_t color, FILE *fh)
+void grlibint_exp_dot_color(graphlib_color_t color, char *str)
 {
   switch (color)
     {
     case GRC_FIREBRICK:
-      fprintf(fh,"\"#B22222\"");
+      strcpy(str,"\"#B22222\"");
       break;
     case GRC_YELLOW:
-      fprintf(fh,"\"#FFFF00\"");
+      strcpy(str,"\"#FFFF00\"");
       break;
     case GRC_ORANGE:
-      fprintf(fh,"\"#FFA500\"");
+      strcpy(str,"\"#FFA500\"");
       break;
     case GRC_TAN:
-      fprintf(fh,"\"#D2B48C\"");
+      strcpy(str,"\"#D2B48C\"");
       break;
     case GRC_GOLDENROD:
-      fprintf(fh,"\"#DAA520\"");
+      strcpy(str,"\"#DAA520\"");
       break;
     case GRC_PURPLE:
-      fprintf(fh,"\"#800080\"");
+      strcpy(str,"\"#800080\"");
       break;
     case GRC_OLIVE:
-      fprintf(fh,"\"#556B2F\"");
+      strcpy(str,"\"#556B2F\"");
       break;
     case GRC_GREY:
-      fprintf(fh,"\"#AAAAAA\"");
+      strcpy(str,"\"#AAAAAA\"");
       break;
     case GRC_LIGHTGREY:
-      fprintf(fh,"\"#DDDDDD\"");
+      strcpy(str,"\"#DDDDDD\"");
       break;
     case GRC_BLACK:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_BLUE:
-      fprintf(fh,"\"#0000FF\"");
+      strcpy(str,"\"#0000FF\"");
       break;
     case GRC_GREEN:
-      fprintf(fh,"\"#00FF00\"");
+      strcpy(str,"\"#00FF00\"");
       break;
     case GRC_DARKGREEN:
-      fprintf(fh,"\"#009900\"");
+      strcpy(str,"\"#009900\"");
       break;
     case GRC_RED:
-      fprintf(fh,"\"#FF0000\"");
+      strcpy(str,"\"#FF0000\"");
       break;
     case GRC_WHITE:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_RANGE1:
-      fprintf(fh,"\"#808080\"");
+      strcpy(str,"\"#808080\"");
       break;
     case GRC_RANGE2:
-      fprintf(fh,"\"#8080A0\"");
+      strcpy(str,"\"#8080A0\"");
       break;
     case GRC_RANGE3:
-      fprintf(fh,"\"#8080D0\"");
+      strcpy(str,"\"#8080D0\"");
       break;
     case GRC_RANGE4:
-      fprintf(fh,"\"#8080F0\"");
+      strcpy(str,"\"#8080F0\"");
       break;
     default:
       {
         if ((color>=GRC_REDSPEC) && (color<GRC_REDSPEC+GRC_SPECTRUMRANGE))
-          fprintf(fh,"\"#FF%02x%02x\"",256-(color-GRC_REDSPEC),256-(color-GRC_REDSPEC));
+          sprintf(str,"\"#FF%02x%02x\"",256-(color-GRC_REDSPEC),256-(color-GRC_REDSPEC));
         else if ((color>=GRC_GREENSPEC) && (color<GRC_GREENSPEC+GRC_SPECTRUMRANGE))
-          fprintf(fh,"\"#%02xFF%02x\"",256-(color-GRC_GREENSPEC),256-(color-GRC_GREENSPEC));
+          sprintf(str,"\"#%02xFF%02x\"",256-(color-GRC_GREENSPEC),256-(color-GRC_GREENSPEC));
         else if ((color>=GRC_RAINBOW) && (color<GRC_RAINBOW+GRC_RAINBOWCOLORS))
           {
             unsigned int color_val;
@@ -736,30 +1808,20 @@ void grlibint_exp_dot_color(graphlib_color_t color, FILE *fh)
               color_val=16777215-(unsigned int)(((color-GRC_RAINBOW)/(float)(grlibint_num_colors+1))*16777215);
             else
               color_val=16777215-(unsigned int)(((color-GRC_RAINBOW)/(float)grlibint_num_colors)*16777215);
-            fprintf(fh,"\"#%06x\"",color_val);
+            sprintf(str,"\"#%06x\"",color_val);
           }
          else
-          fprintf(fh,"\"#CCCCFF\"");
+          strcpy(str,"\"#CCCCFF\"");
         break;
       }
     }
 }
 
 
-/*............................................................*/
-/* color settings for DOT files with arbitrary colors */
-
-void grlibint_exp_gml_color(graphlib_color_t color, FILE *fh)
-{
-  grlibint_exp_dot_color(color,fh);
-  fprintf(fh,"\n");
-}
-
-
 /*............................................................*/
 /* color settings for DOT files with reduced colors */
 
-void grlibint_exp_plaindot_color(graphlib_color_t color, FILE *fh)
+void grlibint_exp_plaindot_color(graphlib_color_t color, char *str)
 {
   if ((color>=GRC_RAINBOW) && (color<GRC_RAINBOW+GRC_RAINBOWCOLORS))
     {
@@ -769,71 +1831,71 @@ void grlibint_exp_plaindot_color(graphlib_color_t color, FILE *fh)
   switch (color)
     {
     case GRC_FIREBRICK:
-      fprintf(fh,"red");
+      strcpy(str,"red");
       break;
     case GRC_YELLOW:
-      fprintf(fh,"yellow");
+      strcpy(str,"yellow");
       break;
     case GRC_ORANGE:
-      fprintf(fh,"orange");
+      strcpy(str,"orange");
       break;
     case GRC_TAN:
-      fprintf(fh,"beige");
+      strcpy(str,"beige");
       break;
     case GRC_GOLDENROD:
-      fprintf(fh,"yellow");
+      strcpy(str,"yellow");
       break;
     case GRC_PURPLE:
-      fprintf(fh,"purple");
+      strcpy(str,"purple");
       break;
     case GRC_OLIVE:
-      fprintf(fh,"green");
+      strcpy(str,"green");
       break;
     case GRC_GREY:
-      fprintf(fh,"grey");
+      strcpy(str,"grey");
       break;
     case GRC_LIGHTGREY:
-      fprintf(fh,"grey");
+      strcpy(str,"grey");
       break;
     case GRC_BLACK:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_BLUE:
-      fprintf(fh,"blue");
+      strcpy(str,"blue");
       break;
     case GRC_GREEN:
-      fprintf(fh,"green");
+      strcpy(str,"green");
       break;
     case GRC_DARKGREEN:
-      fprintf(fh,"green");
+      strcpy(str,"green");
       break;
     case GRC_RED:
-      fprintf(fh,"red");
+      strcpy(str,"red");
       break;
     case GRC_WHITE:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_RANGE1:
-      fprintf(fh,"blue");
+      strcpy(str,"blue");
       break;
     case GRC_RANGE2:
-      fprintf(fh,"blue");
+      strcpy(str,"blue");
       break;
     case GRC_RANGE3:
-      fprintf(fh,"blue");
+      strcpy(str,"blue");
       break;
     case GRC_RANGE4:
-      fprintf(fh,"blue");
+      strcpy(str,"blue");
       break;
     default:
       {
         if ((color>=GRC_REDSPEC) && (color<GRC_REDSPEC+GRC_SPECTRUMRANGE))
-          fprintf(fh,"red");
+          strcpy(str,"red");
         else if ((color>=GRC_GREENSPEC) &&
                  (color<GRC_GREENSPEC+GRC_SPECTRUMRANGE))
-          fprintf(fh,"green");
+          strcpy(str,"green");
         else
-          fprintf(fh,"grey");
+          strcpy(str,"grey");
         break;
       }
     }
@@ -843,83 +1905,83 @@ void grlibint_exp_plaindot_color(graphlib_color_t color, FILE *fh)
 /*............................................................*/
 /* font color settings for GML export */
 
-void grlibint_exp_dot_fontcolor(graphlib_color_t color, FILE *fh)
+void grlibint_exp_dot_fontcolor(graphlib_color_t color, char *str)
 {
   switch (color)
     {
     case GRC_FIREBRICK:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_YELLOW:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_ORANGE:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_TAN:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_GOLDENROD:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_PURPLE:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_OLIVE:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_GREY:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_LIGHTGREY:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_BLACK:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_BLUE:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_GREEN:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_DARKGREEN:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_RED:
-      fprintf(fh,"\"#FFFFFF\"");
+      strcpy(str,"\"#FFFFFF\"");
       break;
     case GRC_WHITE:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_RANGE1:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_RANGE2:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_RANGE3:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     case GRC_RANGE4:
-      fprintf(fh,"\"#000000\"");
+      strcpy(str,"\"#000000\"");
       break;
     default:
       {
         if ((color>=GRC_REDSPEC) && (color<GRC_REDSPEC+GRC_SPECTRUMRANGE))
           {
             if ((color-GRC_REDSPEC)<(GRC_SPECTRUMRANGE/2))
-              fprintf(fh,"\"#000000\"");
+              strcpy(str,"\"#000000\"");
             else
-              fprintf(fh,"\"#FFFFFF\"");
+              strcpy(str,"\"#FFFFFF\"");
           }
         else if ((color>=GRC_GREENSPEC) && (color<GRC_GREENSPEC+
                                                     GRC_SPECTRUMRANGE))
           {
             if ((color-GRC_GREENSPEC)<(GRC_SPECTRUMRANGE/2))
-              fprintf(fh,"\"#000000\"");
+              strcpy(str,"\"#000000\"");
             else
-              fprintf(fh,"\"#FFFFFF\"");
+              strcpy(str,"\"#FFFFFF\"");
           }
         else if ((color>=GRC_RAINBOW) && (color<GRC_RAINBOW+GRC_RAINBOWCOLORS))
           {
@@ -929,32 +1991,22 @@ void grlibint_exp_dot_fontcolor(graphlib_color_t color, FILE *fh)
             color_val=(unsigned int)(normalized_color_val*((float)0xFFFFFF));
             if (((color_val & 0xFF0000)+(color_val && 0xFF00)+(color_val &&
                                                                0xFF))>0xFF)
-              fprintf(fh,"\"#000000\"");
+              strcpy(str,"\"#000000\"");
             else
-              fprintf(fh,"\"#FFFFFF\"");
+              strcpy(str,"\"#FFFFFF\"");
           }
          else
-          fprintf(fh,"\"#FFFFFF\"");
+          strcpy(str,"\"#FFFFFF\"");
         break;
       }
     }
 }
 
 
-/*............................................................*/
-/* color settings for DOT files with arbitrary colors */
-
-void grlibint_exp_gml_fontcolor(graphlib_color_t color, FILE *fh)
-{
-  grlibint_exp_dot_fontcolor(color,fh);
-  fprintf(fh,"\n");
-}
-
-
 /*............................................................*/
 /* color settings for DOT files with reduced colors */
 
-void grlibint_exp_plaindot_fontcolor(graphlib_color_t color, FILE *fh)
+void grlibint_exp_plaindot_fontcolor(graphlib_color_t color, char *str)
 {
   if ((color>=GRC_RAINBOW) && (color<GRC_RAINBOW+GRC_RAINBOWCOLORS))
     {
@@ -964,77 +2016,268 @@ void grlibint_exp_plaindot_fontcolor(graphlib_color_t color, FILE *fh)
   switch (color)
     {
     case GRC_FIREBRICK:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_YELLOW:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_ORANGE:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_TAN:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_GOLDENROD:
-      fprintf(fh,"red");
+      strcpy(str,"red");
       break;
     case GRC_PURPLE:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_OLIVE:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_GREY:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_LIGHTGREY:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_BLACK:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_BLUE:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_GREEN:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_DARKGREEN:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_RED:
-      fprintf(fh,"black");
+      strcpy(str,"black");
       break;
     case GRC_WHITE:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_RANGE1:
-      fprintf(fh,"white");
+      strcpy(str,"white");
       break;
     case GRC_RANGE2:
-      fprintf(fh,"gray");
+      strcpy(str,"gray");
       break;
     case GRC_RANGE3:
-      fprintf(fh,"yellow");
+      strcpy(str,"yellow");
       break;
     case GRC_RANGE4:
-      fprintf(fh,"orange");
+      strcpy(str,"orange");
       break;
     default:
       {
         if ((color>=GRC_REDSPEC) && (color<GRC_REDSPEC+GRC_SPECTRUMRANGE))
-          fprintf(fh,"white");
+          strcpy(str,"white");
         else if ((color>=GRC_GREENSPEC) && (color<GRC_GREENSPEC+
                                                   GRC_SPECTRUMRANGE))
-          fprintf(fh,"black");
+          strcpy(str,"black");
         else
-          fprintf(fh,"black");
+          strcpy(str,"black");
         break;
       }
     }
 }
 
 
+/*............................................................*/
+/* text export: table index of a color */
+
+int grlibint_colorIndex(graphlib_color_t color)
+{
+  if ((color>=0) && (color<GRL_NUM_COLORS))
+    return color;
+  if ((color>=GRC_REDSPEC) && (color<GRC_REDSPEC+GRC_SPECTRUMRANGE))
+    return GRL_NUM_COLORS+(color-GRC_REDSPEC);
+  if ((color>=GRC_GREENSPEC) && (color<GRC_GREENSPEC+GRC_SPECTRUMRANGE))
+    return GRL_NUM_COLORS+GRC_SPECTRUMRANGE+(color-GRC_GREENSPEC);
+  if ((color>=GRC_RAINBOW) && (color<GRC_RAINBOW+GRC_RAINBOWCOLORS))
+    return GRL_NUM_COLORS+2*GRC_SPECTRUMRANGE+(color-GRC_RAINBOW);
+  return XE_COLORS-1;
+}
+
+
+/*............................................................*/
+/* text export: build the color strings of all colors
+   - rainbow colors depend on the number of colors in use, so the
+     table is built for each export */
+
+graphlib_error_t grlibint_newColorTab(grlibint_colortab_t **otab)
+{
+  grlibint_colortab_t *tab;
+  graphlib_color_t    color;
+  int                 i,k;
+
+  tab=(grlibint_colortab_t*)malloc(sizeof(grlibint_colortab_t));
+  if (tab==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<XE_COLORS;i++)
+    {
+      if (i<GRL_NUM_COLORS)
+        color=i;
+      else if (i<GRL_NUM_COLORS+GRC_SPECTRUMRANGE)
+        color=GRC_REDSPEC+(i-GRL_NUM_COLORS);
+      else if (i<GRL_NUM_COLORS+2*GRC_SPECTRUMRANGE)
+        color=GRC_GREENSPEC+(i-GRL_NUM_COLORS-GRC_SPECTRUMRANGE);
+      else if (i<XE_COLORS-1)
+        color=GRC_RAINBOW+(i-GRL_NUM_COLORS-2*GRC_SPECTRUMRANGE);
+      else
+        color=-1;
+
+      grlibint_exp_dot_color(color,tab->str[XE_DOTFILL][i]);
+      grlibint_exp_dot_fontcolor(color,tab->str[XE_DOTFONT][i]);
+      grlibint_exp_plaindot_color(color,tab->str[XE_PLAINFILL][i]);
+      grlibint_exp_plaindot_fontcolor(color,tab->str[XE_PLAINFONT][i]);
+      for (k=0;k<XE_KINDS;k++)
+        tab->len[k][i]=strlen(tab->str[k][i]);
+    }
+
+  *otab=tab;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* text export: formatted output into a stream
+   - strings, ints and doubles are converted without stdio; NULL
+     strings are written as (null), like printf does
+   - output after a failed write is dropped, the error is reported
+     when the stream is closed */
+
+void grlibint_outBytes(grlibint_ostream_t *s, const char *src, uint64_t len)
+{
+  char *dst;
+
+  /* text is not checksummed, so it can be appended directly */
+  if ((!s->checksum) && (s->used[s->fill]+len<=s->cap[s->fill]))
+    {
+      memcpy(s->buf[s->fill]+s->used[s->fill],src,len);
+      s->used[s->fill]+=len;
+      return;
+    }
+  dst=grlibint_ostreamReserve(s,len);
+  if (dst==NULL)
+    return;
+  memcpy(dst,src,len);
+  grlibint_ostreamCommit(s,len);
+}
+
+void grlibint_outStr(grlibint_ostream_t *s, const char *str)
+{
+  if (str==NULL)
+    str="(null)";
+  grlibint_outBytes(s,str,strlen(str));
+}
+
+void grlibint_outInt(grlibint_ostream_t *s, int64_t val)
+{
+  char     digits[24];
+  uint64_t n;
+  int      pos;
+
+  n=(val<0) ? -(uint64_t)val : (uint64_t)val;
+  pos=sizeof(digits);
+  do
+    {
+      digits[--pos]='0'+n%10;
+      n/=10;
+    }
+  while (n>0);
+  if (val<0)
+    digits[--pos]='-';
+  grlibint_outBytes(s,digits+pos,sizeof(digits)-pos);
+}
+
+void grlibint_outColor(grlibint_ostream_t *s, grlibint_colortab_t *tab,
+                       int kind, graphlib_color_t color)
+{
+  int i;
+
+  i=grlibint_colorIndex(color);
+  grlibint_outBytes(s,tab->str[kind][i],tab->len[kind][i]);
+}
+
+
+/*............................................................*/
+/* text export: double through printf */
+
+void grlibint_outPrintf(grlibint_ostream_t *s, double val, int prec)
+{
+  char *dst;
+  int  len;
+
+  len=snprintf(NULL,0,"%.*f",prec,val);
+  dst=grlibint_ostreamReserve(s,len+1);
+  if (dst==NULL)
+    return;
+  snprintf(dst,len+1,"%.*f",prec,val);
+  grlibint_ostreamCommit(s,len);
+}
+
+
+/*............................................................*/
+/* text export: double with prec (at most 6) decimals, as "%.*f"
+   - the value scaled by 10^prec is rounded as an integer; it differs
+     from the exact product by at most half an ulp, so values far
+     from a rounding boundary round like printf
+   - large values, values close to a boundary, infinities and NaNs
+     go through printf */
+
+void grlibint_outDouble(grlibint_ostream_t *s, double val, int prec)
+{
+  static const uint64_t scale[7]={1,10,100,1000,10000,100000,1000000};
+  char                  digits[40];
+  uint64_t              bits,n,ip,fp;
+  double                a,frac;
+  int                   pos,i;
+
+  memcpy(&bits,&val,sizeof(double));
+  a=((bits>>63) ? -val : val)*scale[prec];
+  if (!(a<XE_MAXFAST))
+    {
+      grlibint_outPrintf(s,val,prec);
+      return;
+    }
+  n=(uint64_t)a;
+  frac=a-(double)n;
+  if ((frac>0.499) && (frac<0.501))
+    {
+      grlibint_outPrintf(s,val,prec);
+      return;
+    }
+  if (frac>0.5)
+    n++;
+
+  ip=n/scale[prec];
+  fp=n%scale[prec];
+  pos=sizeof(digits);
+  for (i=0;i<prec;i++)
+    {
+      digits[--pos]='0'+fp%10;
+      fp/=10;
+    }
+  if (prec>0)
+    digits[--pos]='.';
+  do
+    {
+      digits[--pos]='0'+ip%10;
+      ip/=10;
+    }
+  while (ip>0);
+  if (bits>>63)
+    digits[--pos]='-';
+  grlibint_outBytes(s,digits+pos,sizeof(digits)-pos);
+}
+
+
 /*............................................................*/
 /* dynamic color distribution */
 /* THIS IS A HACK RIGHT NOW USING A GLOBAL TABLE */
@@ -1096,11 +2339,12 @@ int grlibint_getNodeAttrColor(const char *key, const void *label, long (*edge_ch
 #ifdef DEBUG
 void grlibint_print_color_assignment()
 {
+    char str[XE_COLORLEN];
+
     for (unsigned int i=0;(i<grlibint_num_colors) && (i<1024);i++)
       {
-        fprintf(stderr,"Color[%d]: val: ",i+1);
-        grlibint_exp_dot_color(i+1,stderr);
-        fprintf(stderr,"\n");
+        grlibint_exp_dot_color(i+1,str);
+        fprintf(stderr,"Color[%d]: val: %s\n",i+1,str);
       }
 }
 #endif
@@ -1134,6 +2378,15 @@ char *grlibint_node_to_text(const void *label)
   else
     return NULL;
 }
+size_t grlibint_node_to_text_buf(const void *label, char *buf, size_t cap)
+{
+  size_t len;
+
+  len=strlen((char*)label);
+  if (len<=cap)
+    memcpy(buf,label,len);
+  return len;
+}
 void *grlibint_merge_node(void *label1, const void *label2)
 {
   if (label1==NULL || label2==NULL)
@@ -1183,6 +2436,11 @@ char *grlibint_node_attr_to_text(const char *key, const void *label)
   else
     return NULL;
 }
+size_t grlibint_node_attr_to_text_buf(const char *key, const void *label,
+                                      char *buf, size_t cap)
+{
+  return grlibint_node_to_text_buf(label,buf,cap);
+}
 void *grlibint_merge_node_attr(const char *key, void *label1, const void *label2)
 {
   if (label1==NULL || label2==NULL)
@@ -1232,7 +2490,15 @@ long grlibint_edge_checksum(const char *key, const void * label)
     sum+=(int)((char*)label)[i];
 }
 
-graphlib_error_t graphlib_Init()
+/* Borrowed labels point into a deserialization buffer and are never freed */
+void grlibint_free_borrowed(void *label)
+{
+}
+void grlibint_free_borrowed_attr(const char *key, void *label)
+{
+}
+
+graphlib_error_t graphlib_Init()
 {
   if (default_functions==NULL)
   {
@@ -1316,6 +2582,10 @@ graphlib_error_t graphlib_newGraph(graphlib_graph_p *newgraph,
     (*newgraph)->functions=functions;
   else
     (*newgraph)->functions=default_functions;
+  (*newgraph)->borrowed=NULL;
+  (*newgraph)->lazy=NULL;
+  (*newgraph)->textcache=NULL;
+  memset(&((*newgraph)->textbuf),0,sizeof(grlibint_textbuf_t));
 
   return GRL_OK;
 }
@@ -1357,6 +2627,10 @@ graphlib_error_t graphlib_newAnnotatedGraph(graphlib_graph_p *newgraph,
     (*newgraph)->functions=functions;
   else
     (*newgraph)->functions=default_functions;
+  (*newgraph)->borrowed=NULL;
+  (*newgraph)->lazy=NULL;
+  (*newgraph)->textcache=NULL;
+  memset(&((*newgraph)->textbuf),0,sizeof(grlibint_textbuf_t));
 
   return GRL_OK;
 }
@@ -1517,7 +2791,8 @@ graphlib_error_t graphlib_delGraph(graphlib_graph_p delgraph)
             {
               if (nodefrag->node[i].entry.data.attr.label != NULL)
                 delgraph->functions->free_node(nodefrag->node[i].entry.data.attr.label);
-              if (nodefrag->node[i].entry.data.attr.attr_values != NULL)
+              if ((nodefrag->node[i].entry.data.attr.attr_values != NULL) &&
+                  (nodefrag->node[i].entry.data.attr.attr_values != grlibint_pending_values))
                 {
                   for (j=0; j<delgraph->num_node_attrs; j++)
                     {
@@ -1538,7 +2813,8 @@ graphlib_error_t graphlib_delGraph(graphlib_graph_p delgraph)
             {
               if (edgefrag->edge[i].entry.data.attr.label != NULL)
                 delgraph->functions->free_edge(edgefrag->edge[i].entry.data.attr.label);
-              if (edgefrag->edge[i].entry.data.attr.attr_values != NULL)
+              if ((edgefrag->edge[i].entry.data.attr.attr_values != NULL) &&
+                  (edgefrag->edge[i].entry.data.attr.attr_values != grlibint_pending_values))
                 {
                   for (j=0; j<delgraph->num_edge_attrs; j++)
                     {
@@ -1625,6 +2901,13 @@ graphlib_error_t graphlib_delGraph(graphlib_graph_p delgraph)
   delgraph->freenodes=NULL;
   delgraph->freeedges=NULL;
 
+  if (delgraph->borrowed!=NULL)
+    free(delgraph->functions);
+  if (delgraph->lazy!=NULL)
+    grlibint_freeLazy(delgraph->lazy);
+  if (delgraph->textcache!=NULL)
+    grlibint_textFree(delgraph->textcache);
+
   free(delgraph);
 
   return GRL_OK;
@@ -1699,1128 +2982,7814 @@ graphlib_error_t graphlib_edgeCount(graphlib_graph_p igraph, int *num_edges)
 
 
 /*-----------------------------------------------------------------*/
-/* I/O routines */
+/* Indexed layout and graph views */
 
 /*............................................................*/
-/* load a full graph / internal format */
+/* sort order of nodes in the indexed layout */
 
-graphlib_error_t graphlib_loadGraph(graphlib_filename_t fn,
-                                    graphlib_graph_p *newgraph,
-                                    graphlib_functiontable_p functions)
+int grlibint_ixCompareNodes(const void *a, const void *b)
 {
-  int              fh;
-  graphlib_error_t err;
-  char             *serialized_graph;
-  uint64_t         size;
+  graphlib_node_t id1,id2;
 
-  fh=open(fn,O_RDONLY);
-  if (fh<0)
-    return GRL_FILEERROR;
+  id1=((const grlibint_ixsrcnode_t*)a)->node->id;
+  id2=((const grlibint_ixsrcnode_t*)b)->node->id;
+  return (id1>id2)-(id1<id2);
+}
 
-  err=grlibint_addGraph(newgraph);
-  if (GRL_IS_FATALERROR(err))
-    return err;
 
-  err=grlibint_read(fh,(char*)(&size), sizeof(uint64_t));
-  if (GRL_IS_FATALERROR(err))
-    return err;
+/*............................................................*/
+/* sort order of edges in the indexed layout */
 
-  serialized_graph=(char*)malloc(size);
-  if (serialized_graph==NULL)
-    return GRL_NOMEM;
+int grlibint_ixCompareEdges(const void *a, const void *b)
+{
+  graphlib_edgedata_p e1,e2;
 
-  err=grlibint_read(fh,serialized_graph,size);
-  if (GRL_IS_FATALERROR(err))
-    return err;
+  e1=*(graphlib_edgedata_p const*)a;
+  e2=*(graphlib_edgedata_p const*)b;
+  if (e1->node_from!=e2->node_from)
+    return (e1->node_from>e2->node_from)-(e1->node_from<e2->node_from);
+  return (e1->node_to>e2->node_to)-(e1->node_to<e2->node_to);
+}
 
-  err=graphlib_deserializeGraph(newgraph,functions,serialized_graph,size);
-  if (GRL_IS_FATALERROR(err))
-    return err;
 
-  if (serialized_graph!=NULL)
-    free(serialized_graph);
+/*............................................................*/
+/* find the position of a node in the sorted node array */
 
-  return GRL_OK;
+uint64_t grlibint_ixSearchNode(grlibint_ixsrcnode_t *nodes,
+                               uint64_t num_nodes, graphlib_node_t id)
+{
+  uint64_t lo,hi,mid;
+
+  lo=0;
+  hi=num_nodes;
+  while (lo<hi)
+    {
+      mid=lo+(hi-lo)/2;
+      if (nodes[mid].node->id<id)
+        lo=mid+1;
+      else
+        hi=mid;
+    }
+  if ((lo<num_nodes) && (nodes[lo].node->id==id))
+    return lo;
+  return IX_NOINDEX;
 }
 
 
 /*............................................................*/
-/* save a complete graph / internal format */
+/* record sizes of the indexed layout */
 
-graphlib_error_t graphlib_saveGraph(graphlib_filename_t fn,
-                                    graphlib_graph_p graph)
+uint64_t grlibint_ixNodeRecord(int num_node_attrs, int numannotation)
 {
-  int              fh,i;
-  char             *serialized_graph;
-  uint64_t         size;
-  graphlib_error_t err;
+  return sizeof(grlibint_ixnode_t)+num_node_attrs*sizeof(grlibint_ixslot_t)+
+    numannotation*sizeof(graphlib_annotation_t);
+}
 
-  fh=open(fn,O_WRONLY|O_CREAT|O_TRUNC,S_IREAD|S_IWRITE|S_IRGRP|S_IROTH);
-  if (fh<0)
-    return GRL_FILEERROR;
+uint64_t grlibint_ixEdgeRecord(int num_edge_attrs)
+{
+  return sizeof(grlibint_ixedge_t)+num_edge_attrs*sizeof(grlibint_ixslot_t);
+}
 
-  err = graphlib_serializeGraph(graph,&serialized_graph,&size);
-  if (GRL_IS_FATALERROR(err))
-    return err;
-  err=grlibint_write(fh,(char*) &size, sizeof(uint64_t));
-  if (GRL_IS_FATALERROR(err))
-    return err;
-  err=grlibint_write(fh, serialized_graph,size);
-  if (serialized_graph!=NULL)
-    free(serialized_graph);
-  if (GRL_IS_FATALERROR(err))
-    return err;
 
-  return GRL_OK;
+/*............................................................*/
+/* keys in heap order: annotations, node attributes, edge attributes */
+
+int grlibint_ixNumKeys(graphlib_graph_p igraph)
+{
+  return igraph->numannotation+igraph->num_node_attrs+igraph->num_edge_attrs;
+}
+
+const char *grlibint_ixKey(graphlib_graph_p igraph, int i)
+{
+  if (i<igraph->numannotation)
+    return igraph->annotations[i];
+  i-=igraph->numannotation;
+  if (i<igraph->num_node_attrs)
+    return igraph->node_attr_keys[i];
+  return igraph->edge_attr_keys[i-igraph->num_node_attrs];
 }
 
 
 /*............................................................*/
-/* export graph to new format */
+/* heap space used by the label and attributes of a node or edge */
 
-graphlib_error_t graphlib_exportGraph(graphlib_filename_t fn,
-                                      graphlib_format_t format,
-                                      graphlib_graph_p graph)
+uint64_t grlibint_ixNodeHeap(graphlib_graph_p igraph, graphlib_nodedata_p node)
 {
-  return graphlib_exportAttributedGraph(fn, format, graph, 0, NULL, NULL);
+  uint64_t len;
+  int      j;
+
+  len=igraph->functions->serialize_node_length(node->attr.label);
+  for (j=0;j<igraph->num_node_attrs;j++)
+    len+=igraph->functions->
+      serialize_node_attr_length(igraph->node_attr_keys[j],
+                                 node->attr.attr_values[j]);
+  return len;
 }
 
+uint64_t grlibint_ixEdgeHeap(graphlib_graph_p igraph, graphlib_edgedata_p edge)
+{
+  uint64_t len;
+  int      j;
+
+  len=igraph->functions->serialize_edge_length(edge->attr.label);
+  for (j=0;j<igraph->num_edge_attrs;j++)
+    len+=igraph->functions->
+      serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                 edge->attr.attr_values[j]);
+  return len;
+}
+
+
 /*............................................................*/
-/* export graph to new format */
+/* collect and sort nodes and edges, size the heap and lay out the
+   header and section table (without checksums) */
 
-graphlib_error_t graphlib_exportAttributedGraph(graphlib_filename_t fn,
-                                      graphlib_format_t format,
-                                      graphlib_graph_p graph,
-                                      int num_attrs,
-                                      char **attr_keys,
-                                      char **attr_values)
+graphlib_error_t grlibint_ixPlan(graphlib_graph_p igraph,
+                                 grlibint_ixplan_t *plan)
 {
-  char *tmp;
-  switch (format)
+  grlibint_ixheader_t     *hdr;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  uint64_t                num_nodes,num_edges,n,e,heap_len,pos;
+  int                     i,num_n,num_e;
+  const char              *key;
+
+  graphlib_nodeCount(igraph,&num_n);
+  graphlib_edgeCount(igraph,&num_e);
+  num_nodes=num_n;
+  num_edges=num_e;
+
+  plan->nodes=(grlibint_ixsrcnode_t*)malloc((num_nodes+1)*
+                                            sizeof(grlibint_ixsrcnode_t));
+  if (plan->nodes==NULL)
+    return GRL_NOMEM;
+  plan->edges=(graphlib_edgedata_p*)malloc((num_edges+1)*
+                                           sizeof(graphlib_edgedata_p));
+  if (plan->edges==NULL)
     {
+      free(plan->nodes);
+      return GRL_NOMEM;
+    }
 
-    /*=====================================================*/
+  heap_len=0;
+  for (i=0;i<grlibint_ixNumKeys(igraph);i++)
+    {
+      key=grlibint_ixKey(igraph,i);
+      if (key!=NULL)
+        heap_len+=strlen(key)+1;
+    }
 
-    case GRF_DOT:
-    case GRF_PLAINDOT:
-      {
-        FILE                     *fh;
-        graphlib_nodefragment_p  nodefrag;
-        graphlib_edgefragment_p  edgefrag;
-        graphlib_nodedata_p      node;
-        graphlib_edgedata_p      edge;
-        int                      i, j;
+  n=0;
+  nodefrag=igraph->nodes;
+  while (nodefrag!=NULL)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (nodefrag->node[i].full)
+            {
+              plan->nodes[n].node=&(nodefrag->node[i].entry.data);
+              plan->nodes[n].grannot=NULL;
+              if (igraph->numannotation>0)
+                plan->nodes[n].grannot=
+                  &(nodefrag->grannot[i*igraph->numannotation]);
+              heap_len+=grlibint_ixNodeHeap(igraph,plan->nodes[n].node);
+              n++;
+            }
+        }
+      nodefrag=nodefrag->next;
+    }
+
+  e=0;
+  edgefrag=igraph->edges;
+  while (edgefrag!=NULL)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (edgefrag->edge[i].full)
+            {
+              plan->edges[e]=&(edgefrag->edge[i].entry.data);
+              heap_len+=grlibint_ixEdgeHeap(igraph,plan->edges[e]);
+              e++;
+            }
+        }
+      edgefrag=edgefrag->next;
+    }
 
-        /* open file */
+  qsort(plan->nodes,num_nodes,sizeof(grlibint_ixsrcnode_t),
+        grlibint_ixCompareNodes);
+  qsort(plan->edges,num_edges,sizeof(graphlib_edgedata_p),
+        grlibint_ixCompareEdges);
+
+  hdr=&(plan->hdr);
+  memset(hdr,0,sizeof(grlibint_ixheader_t));
+  memcpy(hdr->magic,IX_MAGIC,IX_MAGICLEN);
+  hdr->version=IX_VERSION;
+  hdr->byteorder=IX_BYTEORDER;
+  hdr->num_nodes=num_nodes;
+  hdr->num_edges=num_edges;
+  hdr->numannotation=igraph->numannotation;
+  hdr->num_node_attrs=igraph->num_node_attrs;
+  hdr->num_edge_attrs=igraph->num_edge_attrs;
+  hdr->directed=igraph->directed;
+  hdr->node_rec=grlibint_ixNodeRecord(igraph->num_node_attrs,
+                                      igraph->numannotation);
+  hdr->edge_rec=grlibint_ixEdgeRecord(igraph->num_edge_attrs);
+
+  pos=sizeof(grlibint_ixheader_t);
+  hdr->section[IX_ANNOTATIONS].off=pos;
+  hdr->section[IX_ANNOTATIONS].len=
+    igraph->numannotation*sizeof(grlibint_ixslot_t);
+  pos+=hdr->section[IX_ANNOTATIONS].len;
+  hdr->section[IX_ATTRKEYS].off=pos;
+  hdr->section[IX_ATTRKEYS].len=
+    (igraph->num_node_attrs+igraph->num_edge_attrs)*sizeof(grlibint_ixslot_t);
+  pos+=hdr->section[IX_ATTRKEYS].len;
+  hdr->section[IX_NODES].off=pos;
+  hdr->section[IX_NODES].len=num_nodes*hdr->node_rec;
+  pos+=hdr->section[IX_NODES].len;
+  hdr->section[IX_EDGES].off=pos;
+  hdr->section[IX_EDGES].len=num_edges*hdr->edge_rec;
+  pos+=hdr->section[IX_EDGES].len;
+  hdr->section[IX_HEAP].off=pos;
+  hdr->section[IX_HEAP].len=heap_len;
+  hdr->total_len=pos+heap_len;
 
-        fh=fopen(fn,"w");
-        if (fh==NULL)
-          return GRL_FILEERROR;
+  return GRL_OK;
+}
 
-        /* write header */
+void grlibint_ixFreePlan(grlibint_ixplan_t *plan)
+{
+  free(plan->nodes);
+  free(plan->edges);
+}
 
-        fprintf(fh,"digraph G {\n");
-        for (i=0;i<num_attrs;i++)
-          {
-            if (i==0)
-              fprintf(fh,"\tgraph [");
-            else
-              fprintf(fh,",");
-            fprintf(fh,"%s=\"%s\"",attr_keys[i],attr_values[i]);
-            if (i==num_attrs-1)
-              fprintf(fh,"];\n");
-          }
-        fprintf(fh,"\tnode [shape=record,style=filled,labeljust=c,height=0.2];\n");
 
-        /* write nodes */
+/*............................................................*/
+/* fill the slot of a key
+   - returns the heap position after the key */
 
-        nodefrag=graph->nodes;
-        while (nodefrag!=NULL)
-          {
-            for (i=0;i<nodefrag->count;i++)
-              {
-                if (nodefrag->node[i].full)
-                  {
-                    node=&(nodefrag->node[i].entry.data);
-                    {
-                      /* write one node */
-
-                      fprintf(fh,"\t%i [",node->id);
-
-                      fprintf(fh,"pos=\"%i,%i\", ",node->attr.x,node->attr.y);
-                      tmp = graph->functions->node_to_text(node->attr.label);
-                      fprintf(fh,"label=\"%s\", ", tmp);
-                      free(tmp);
-                      fprintf(fh,"fillcolor=");
-                      if (format==GRF_PLAINDOT)
-                        grlibint_exp_plaindot_color(node->attr.color,fh);
-                      else
-                        grlibint_exp_dot_color(node->attr.color,fh);
-                      fprintf(fh,", fontcolor=");
-                      if (format==GRF_PLAINDOT)
-                        grlibint_exp_plaindot_fontcolor(node->attr.color,fh);
-                      else
-                        grlibint_exp_dot_fontcolor(node->attr.color,fh);
-                      for (j=0; j<graph->num_node_attrs; j++)
-                        {
-                          fprintf(fh,", %s=",graph->node_attr_keys[j]);
-                          tmp = graph->functions->node_attr_to_text(graph->node_attr_keys[j], node->attr.attr_values[j]);
-                          fprintf(fh,"\"%s\"", tmp);
-                          free(tmp);
-                        }
-                      fprintf(fh,"];\n");
-                    }
-                }
-              }
-            nodefrag=nodefrag->next;
-          }
+uint64_t grlibint_ixPutKeySlot(char *out, uint64_t heap_pos, const char *str)
+{
+  grlibint_ixslot_t slot;
+
+  slot.off=heap_pos;
+  slot.len=0;
+  if (str!=NULL)
+    slot.len=strlen(str)+1;
+  memcpy(out,&slot,sizeof(grlibint_ixslot_t));
+  return heap_pos+slot.len;
+}
 
-        /* write edges */
 
-        edgefrag=graph->edges;
-        while (edgefrag!=NULL)
-          {
-            for (i=0;i<edgefrag->count;i++)
-              {
-                if (edgefrag->edge[i].full)
-                  {
-                    edge=&(edgefrag->edge[i].entry.data);
-                    {
-                      /* write one edge */
-                      fprintf(fh,"\t%i -> %i [",edge->node_from,edge->node_to);
-                      tmp = graph->functions->edge_to_text(edge->attr.label);
-                      fprintf(fh,"label=\"%s\"", tmp);
-                      free(tmp);
-                      for (j=0; j<graph->num_edge_attrs; j++)
-                        {
-                          fprintf(fh,", %s=",graph->edge_attr_keys[j]);
-                          tmp = graph->functions->edge_attr_to_text(graph->edge_attr_keys[j], edge->attr.attr_values[j]);
-                          fprintf(fh,"\"%s\"", tmp);
-                          free(tmp);
-                        }
-                      fprintf(fh,"]\n");
-                    }
-                  }
-              }
-            edgefrag=edgefrag->next;
-          }
+/*............................................................*/
+/* fill the record of the n-th node
+   - the outgoing edges of each node are a range in the sorted edge
+     array, *e is the position in that array and must start at 0 for
+     the first node
+   - returns the heap position after the data of this node */
+
+uint64_t grlibint_ixPutNode(graphlib_graph_p igraph, grlibint_ixplan_t *plan,
+                            uint64_t n, uint64_t *e, uint64_t heap_pos,
+                            char *out)
+{
+  grlibint_ixnode_t   rec;
+  grlibint_ixslot_t   slot;
+  graphlib_nodedata_p node;
+  uint64_t            num_edges;
+  int                 j;
+
+  node=plan->nodes[n].node;
+  num_edges=plan->hdr.num_edges;
+
+  memset(&rec,0,sizeof(grlibint_ixnode_t));
+  rec.width=node->attr.width;
+  rec.w=node->attr.w;
+  rec.height=node->attr.height;
+  rec.id=node->id;
+  rec.color=node->attr.color;
+  rec.x=node->attr.x;
+  rec.y=node->attr.y;
+  rec.fontsize=node->attr.fontsize;
+
+  while ((*e<num_edges) && (plan->edges[*e]->node_from<node->id))
+    (*e)++;
+  rec.out_first=*e;
+  while ((*e<num_edges) && (plan->edges[*e]->node_from==node->id))
+    (*e)++;
+  rec.out_count=*e-rec.out_first;
+
+  rec.label.off=heap_pos;
+  rec.label.len=igraph->functions->serialize_node_length(node->attr.label);
+  heap_pos+=rec.label.len;
+  memcpy(out,&rec,sizeof(grlibint_ixnode_t));
+  out+=sizeof(grlibint_ixnode_t);
+
+  for (j=0;j<igraph->num_node_attrs;j++)
+    {
+      slot.off=heap_pos;
+      slot.len=igraph->functions->
+        serialize_node_attr_length(igraph->node_attr_keys[j],
+                                   node->attr.attr_values[j]);
+      heap_pos+=slot.len;
+      memcpy(out,&slot,sizeof(grlibint_ixslot_t));
+      out+=sizeof(grlibint_ixslot_t);
+    }
 
-        /* write footer */
+  if (igraph->numannotation>0)
+    memcpy(out,plan->nodes[n].grannot,
+           igraph->numannotation*sizeof(graphlib_annotation_t));
 
-        fprintf(fh,"}\n");
+  return heap_pos;
+}
 
-        /* done */
 
-        fclose(fh);
+/*............................................................*/
+/* fill the record of the e-th edge
+   - returns the heap position after the data of this edge */
 
-        break;
-      }
+uint64_t grlibint_ixPutEdge(graphlib_graph_p igraph, grlibint_ixplan_t *plan,
+                            uint64_t e, uint64_t heap_pos, char *out)
+{
+  grlibint_ixedge_t   erec;
+  grlibint_ixslot_t   slot;
+  graphlib_edgedata_p edge;
+  int                 j;
+
+  edge=plan->edges[e];
+
+  memset(&erec,0,sizeof(grlibint_ixedge_t));
+  erec.width=edge->attr.width;
+  erec.node_from=edge->node_from;
+  erec.node_to=edge->node_to;
+  erec.color=edge->attr.color;
+  erec.arcstyle=edge->attr.arcstyle;
+  erec.block=edge->attr.block;
+  erec.fontsize=edge->attr.fontsize;
+  erec.index_from=grlibint_ixSearchNode(plan->nodes,plan->hdr.num_nodes,
+                                        edge->node_from);
+  erec.index_to=grlibint_ixSearchNode(plan->nodes,plan->hdr.num_nodes,
+                                      edge->node_to);
+
+  erec.label.off=heap_pos;
+  erec.label.len=igraph->functions->serialize_edge_length(edge->attr.label);
+  heap_pos+=erec.label.len;
+  memcpy(out,&erec,sizeof(grlibint_ixedge_t));
+  out+=sizeof(grlibint_ixedge_t);
+
+  for (j=0;j<igraph->num_edge_attrs;j++)
+    {
+      slot.off=heap_pos;
+      slot.len=igraph->functions->
+        serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                   edge->attr.attr_values[j]);
+      heap_pos+=slot.len;
+      memcpy(out,&slot,sizeof(grlibint_ixslot_t));
+      out+=sizeof(grlibint_ixslot_t);
+    }
 
-    /*=====================================================*/
+  return heap_pos;
+}
 
-    case GRF_GML:
-      {
-        FILE                     *fh;
-        graphlib_nodefragment_p  nodefrag;
-        graphlib_edgefragment_p  edgefrag;
-        graphlib_nodedata_p      node;
-        graphlib_edgedata_p      edge;
-        int                      i,j;
-        double                   edgescale,maxw;
 
+/*............................................................*/
+/* write the heap data of a node or edge, in the order in which
+   grlibint_ixPutNode and grlibint_ixPutEdge assign it */
 
-        /* open file */
+void grlibint_ixPutNodeData(graphlib_graph_p igraph, graphlib_nodedata_p node,
+                            char *out)
+{
+  uint64_t len;
+  int      j;
 
-        fh=fopen(fn,"w");
-        if (fh==NULL)
-          return GRL_FILEERROR;
+  len=igraph->functions->serialize_node_length(node->attr.label);
+  if (len!=0)
+    igraph->functions->serialize_node(out,node->attr.label);
+  out+=len;
 
-        /* write header */
+  for (j=0;j<igraph->num_node_attrs;j++)
+    {
+      len=igraph->functions->
+        serialize_node_attr_length(igraph->node_attr_keys[j],
+                                   node->attr.attr_values[j]);
+      if (len!=0)
+        igraph->functions->serialize_node_attr(igraph->node_attr_keys[j],out,
+                                               node->attr.attr_values[j]);
+      out+=len;
+    }
+}
 
-        fprintf(fh,"Creator \"LLNL-graphlib\"\n");
-        fprintf(fh,"Version 2.2\n");
+void grlibint_ixPutEdgeData(graphlib_graph_p igraph, graphlib_edgedata_p edge,
+                            char *out)
+{
+  uint64_t len;
+  int      j;
 
-        fprintf(fh,"graph\n");
-        fprintf(fh,"[\n");
+  len=igraph->functions->serialize_edge_length(edge->attr.label);
+  if (len!=0)
+    igraph->functions->serialize_edge(out,edge->attr.label);
+  out+=len;
 
-        /* graph attributes */
+  for (j=0;j<igraph->num_edge_attrs;j++)
+    {
+      len=igraph->functions->
+        serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                   edge->attr.attr_values[j]);
+      if (len!=0)
+        igraph->functions->serialize_edge_attr(igraph->edge_attr_keys[j],out,
+                                               edge->attr.attr_values[j]);
+      out+=len;
+    }
+}
 
-        fprintf(fh,"\tdirected %i\n",graph->directed);
 
-        /* write nodes */
+/*............................................................*/
+/* serialize a graph into the indexed layout
+   - one pass collects and sorts nodes and edges and sizes the heap,
+     a second pass fills a single exact-size buffer */
 
-        nodefrag=graph->nodes;
-        while (nodefrag!=NULL)
-          {
-            for (i=0;i<nodefrag->count;i++)
-              {
-                if (nodefrag->node[i].full)
-                  {
-                    node=&(nodefrag->node[i].entry.data);
-                    {
-                      /* write one node */
+graphlib_error_t grlibint_serializeGraphIndexed(graphlib_graph_p igraph,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len)
+{
+  grlibint_ixplan_t plan;
+  graphlib_error_t  err;
+  uint64_t          n,e,heap,heap_pos,next,pos;
+  int               i;
+  const char        *key;
+  char              *base;
+
+  err=grlibint_ixPlan(igraph,&plan);
+  if (GRL_IS_FATALERROR(err))
+    return err;
 
-                      fprintf(fh,"\tnode\n");
-                      fprintf(fh,"\t[\n");
-                      fprintf(fh,"\t\tid %i\n",node->id);
-                      if (node->attr.label==NULL)
-                        {
-                          if (node->attr.width!=0.0)
-                            fprintf(fh,"\t\tlabel \"%.2f\"\n",
-                                    node->attr.width*1000.0);
-                          else
-                            fprintf(fh,"\t\tlabel \"\"\n");
-                        }
-                      else
-                        {
-                          tmp = graph->functions->node_to_text(node->attr.label);
-                          fprintf(fh,"\t\tlabel \"%s\"\n", tmp);
-                          free(tmp);
-                        }
+  base=(char*)malloc(plan.hdr.total_len);
+  if (base==NULL)
+    {
+      grlibint_ixFreePlan(&plan);
+      return GRL_NOMEM;
+    }
+  heap=plan.hdr.section[IX_HEAP].off;
+  memset(base,0,heap);
+  memcpy(base,&(plan.hdr),sizeof(grlibint_ixheader_t));
 
-                      for (j=0;j<graph->numannotation;j++)
-                        {
-                          if (graph->annotations[j]!=NULL)
-                            {
-                              fprintf(fh,"\t\t%s \"%f\"\n",
-                                      graph->annotations[j],
-                                      nodefrag->grannot[i*graph->numannotation
-                                                          +j]);
-                            }
-                        }
+  /* keys */
 
-                      fprintf(fh,"\t\tgraphics\n");
-                      fprintf(fh,"\t\t[\n");
-                      fprintf(fh,"\t\t\ttype \"rectangle\"\n");
-                      fprintf(fh,"\t\t\tfill ");
-                      grlibint_exp_gml_color(node->attr.color,fh);
-                      fprintf(fh,"\t\t\toutline \"#000000\"\n");
-                      fprintf(fh,"\t\t\tx %i\n",node->attr.x);
-                      fprintf(fh,"\t\t\ty %i\n",node->attr.y);
-                      fprintf(fh,"\t\t\tw %f\n",node->attr.w);
-                      if (node->attr.height==0)
-                        {
-                          if (node->attr.width!=0.0)
-                            fprintf(fh,"\t\t\th %f\n",20.0);
-                          else
-                            fprintf(fh,"\t\t\th %f\n",10.0);
-                        }
-                      else
-                        fprintf(fh,"\t\t\th %f\n",node->attr.height);
+  heap_pos=0;
+  pos=plan.hdr.section[IX_ANNOTATIONS].off;
+  for (i=0;i<grlibint_ixNumKeys(igraph);i++)
+    {
+      key=grlibint_ixKey(igraph,i);
+      next=grlibint_ixPutKeySlot(base+pos,heap_pos,key);
+      if (key!=NULL)
+        memcpy(base+heap+heap_pos,key,next-heap_pos);
+      heap_pos=next;
+      pos+=sizeof(grlibint_ixslot_t);
+    }
 
-                      fprintf(fh,"\t\t]\n");
+  /* nodes and edges */
 
-                      if ((node->attr.color==GRC_BLACK) ||
-                          (node->attr.fontsize!=DEFAULT_FONT_SIZE))
-                        {
-                          fprintf(fh,"\t\tLabelGraphics\n");
-                          fprintf(fh,"\t\t[\n");
-                          if (node->attr.label==NULL)
-                            {
-                              if (node->attr.width!=0.0)
-                                fprintf(fh,"\t\t\ttext \"%.2f\"\n",
-                                        node->attr.width*1000.0);
-                              else
-                                fprintf(fh,"\t\t\ttext \"\"\n");
-                            }
-                          else
-                            {
-                              tmp = graph->functions->node_to_text(node->attr.label);
-                              fprintf(fh,"\t\t\ttext \"%s\"\n", tmp);
-                              free(tmp);
-                            }
+  e=0;
+  for (n=0;n<plan.hdr.num_nodes;n++)
+    {
+      pos=plan.hdr.section[IX_NODES].off+n*plan.hdr.node_rec;
+      grlibint_ixPutNodeData(igraph,plan.nodes[n].node,base+heap+heap_pos);
+      heap_pos=grlibint_ixPutNode(igraph,&plan,n,&e,heap_pos,base+pos);
+    }
 
-                          fprintf(fh,"\t\t\tcolor ");
-                          grlibint_exp_gml_fontcolor(node->attr.color,fh);
+  for (e=0;e<plan.hdr.num_edges;e++)
+    {
+      pos=plan.hdr.section[IX_EDGES].off+e*plan.hdr.edge_rec;
+      grlibint_ixPutEdgeData(igraph,plan.edges[e],base+heap+heap_pos);
+      heap_pos=grlibint_ixPutEdge(igraph,&plan,e,heap_pos,base+pos);
+    }
 
-                          if (node->attr.fontsize!=DEFAULT_FONT_SIZE)
-                            {
-                              fprintf(fh,"\t\t\tfontSize %i\n",
-                                      node->attr.fontsize);
-                            }
-                          fprintf(fh,"\t\t]\n");
-                        }
+  assert(heap_pos==plan.hdr.section[IX_HEAP].len);
 
-                      fprintf(fh,"\t]\n");
-                    }
-                }
-              }
-            nodefrag=nodefrag->next;
-          }
+  grlibint_ixFreePlan(&plan);
 
-        /* write edges */
+  *obyte_array=base;
+  *obyte_array_len=plan.hdr.total_len;
+  return GRL_OK;
+}
 
-        maxw=1;
-        edgefrag=graph->edges;
-        while (edgefrag!=NULL)
-          {
-            for (i=0;i<edgefrag->count;i++)
-              {
-                if (edgefrag->edge[i].full)
-                  {
-                    edge=&(edgefrag->edge[i].entry.data);
-                    if (edge->attr.width>maxw)
-                      maxw=edge->attr.width;
-                  }
-              }
-            edgefrag=edgefrag->next;
-          }
-        /* just fro QBox paper to get uniform graphs */
-        /*   maxw=76; */
 
-        edgescale=MAXEDGE_GML/maxw;
+graphlib_error_t graphlib_serializeGraphIndexed(graphlib_graph_p igraph,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
 
-        edgefrag=graph->edges;
-        while (edgefrag!=NULL)
-          {
-            for (i=0;i<edgefrag->count;i++)
-              {
-                if (edgefrag->edge[i].full)
-                  {
-                    edge=&(edgefrag->edge[i].entry.data);
-                    {
-                      /* write one edge */
-
-                      fprintf(fh,"\tedge\n");
-                      fprintf(fh,"\t[\n");
-                      fprintf(fh,"\t\tsource %i\n",edge->node_from);
-                      fprintf(fh,"\t\ttarget %i\n",edge->node_to);
-                      if (edge->attr.width>0)
-                        fprintf(fh,"\t\tlabel \"%d\"\n", (int)edge->attr.width);
-                      fprintf(fh,"\t\tgraphics\n");
-                      fprintf(fh,"\t\t[\n");
-                      switch (edge->attr.arcstyle)
-                        {
-                        case GRA_ARC:
-                          {
-                            fprintf(fh,"\t\t\ttype \"arc\"\n");
-                            break;
-                          }
-                        case GRA_SPLINE:
-                          {
-                            fprintf(fh,"\t\t\ttype \"spline\"\n");
-                            break;
-                          }
-                        }
-                      if (edge->attr.width>0)
-                        fprintf(fh,"\t\t\twidth %f\n",
-                                edge->attr.width*edgescale);
-                      else
-                        fprintf(fh,"\t\t\twidth 1.0\n");
-                      fprintf(fh,"\t\t\ttargetArrow \"standard\"\n");
-                      fprintf(fh,"\t\t\tfill ");
-                      grlibint_exp_gml_color(edge->attr.color,fh);
-                      switch (edge->attr.arcstyle)
-                        {
-                        case GRA_ARC:
-                          {
-                            fprintf(fh,"\t\t\tarcType        \"fixedRatio\"\n");
-                            fprintf(fh,"\t\t\tarcRatio        1.0\n");
-                            break;
-                          }
-                        case GRA_SPLINE:
-                          {
-                            fprintf(fh,"\t\t\tarcType        \"fixedRatio\"\n");
-                            fprintf(fh,"\t\t\tarcRatio        1.0\n");
-                            break;
-                          }
-                        }
-                      fprintf(fh,"\t\t]\n");
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphIndexed(igraph,obyte_array,obyte_array_len);
+}
 
-                      fprintf(fh,"\t\tLabelGraphics\n");
-                      fprintf(fh,"\t\t[\n");
 
-                      if (graph->edgeset)
-                        {
-                          tmp = graph->functions->edge_to_text(edge->attr.label);
-                          fprintf(fh,"\t\t\ttext \"%s\"\n", tmp);
-                          free(tmp);
-                        }
-                      else
-                        {
-                          if (edge->attr.label!=NULL)
-                            {
-                              tmp = graph->functions->edge_to_text(edge->attr.label);
-                              fprintf(fh,"\t\t\ttext \"%s\"\n", tmp);
-                              free(tmp);
-                            }
-                        }
+/*............................................................*/
+/* check that a section lies within the buffer and has the expected
+   size */
 
-                      fprintf(fh,"\t\t\tmodel   \"centered\"\n");
-                      fprintf(fh,"\t\t\tposition        \"center\"\n");
-                      if (edge->attr.fontsize>0)
-                        fprintf(fh,"\t\t\tfontSize %i\n",edge->attr.fontsize);
-                      if ((edge->attr.block==GRB_BLOCK) ||
-                          (edge->attr.block==GRB_FULL))
-                        {
-                          fprintf(fh,"\t\t\toutline ");
-                          grlibint_exp_gml_color(edge->attr.color,fh);
-                        }
-                      if (edge->attr.block==GRB_FULL)
-                        {
-                          fprintf(fh,"\t\t\tfill ");
-                          grlibint_exp_gml_color(edge->attr.color,fh);
-                        }
+int grlibint_ixSectionOK(grlibint_ixheader_t *hdr, int sec, uint64_t count,
+                         uint64_t rec)
+{
+  grlibint_ixsection_t *s=&(hdr->section[sec]);
+
+  if ((s->off>hdr->total_len) || (s->len>hdr->total_len-s->off))
+    return 0;
+  if (rec==0)
+    return 1;
+  if ((s->len%rec!=0) || (s->len/rec!=count))
+    return 0;
+  return 1;
+}
 
-                      fprintf(fh,"\t\t]\n");
 
-                      fprintf(fh,"\t]\n");
-                    }
-                  }
-              }
-            edgefrag=edgefrag->next;
-          }
+/*............................................................*/
+/* check a (native byte order) header against the buffer length */
+
+graphlib_error_t grlibint_ixCheckHeader(grlibint_ixheader_t *hdr,
+                                        uint64_t ibyte_array_len)
+{
+  if ((memcmp(hdr->magic,IX_MAGIC,IX_MAGICLEN)!=0) ||
+      (hdr->version!=IX_VERSION) || (hdr->byteorder!=IX_BYTEORDER))
+    return GRL_UNKNOWNFORMAT;
+  if ((hdr->total_len>ibyte_array_len) ||
+      (hdr->numannotation<0) || (hdr->num_node_attrs<0) ||
+      (hdr->num_edge_attrs<0))
+    return GRL_UNKNOWNFORMAT;
+  if ((hdr->node_rec!=grlibint_ixNodeRecord(hdr->num_node_attrs,
+                                            hdr->numannotation)) ||
+      (hdr->edge_rec!=grlibint_ixEdgeRecord(hdr->num_edge_attrs)))
+    return GRL_UNKNOWNFORMAT;
+  if (!grlibint_ixSectionOK(hdr,IX_ANNOTATIONS,hdr->numannotation,
+                            sizeof(grlibint_ixslot_t)) ||
+      !grlibint_ixSectionOK(hdr,IX_ATTRKEYS,
+                            hdr->num_node_attrs+hdr->num_edge_attrs,
+                            sizeof(grlibint_ixslot_t)) ||
+      !grlibint_ixSectionOK(hdr,IX_NODES,hdr->num_nodes,hdr->node_rec) ||
+      !grlibint_ixSectionOK(hdr,IX_EDGES,hdr->num_edges,hdr->edge_rec) ||
+      !grlibint_ixSectionOK(hdr,IX_HEAP,0,0))
+    return GRL_UNKNOWNFORMAT;
 
-        /* write footer */
+  return GRL_OK;
+}
 
-        fprintf(fh,"]\n");
 
-        /* done */
+/*............................................................*/
+/* open a view on a graph in the indexed layout */
 
-        fclose(fh);
+graphlib_error_t graphlib_viewGraph(graphlib_graphview_p view,
+                                    const char *ibyte_array,
+                                    uint64_t ibyte_array_len)
+{
+  grlibint_ixheader_t hdr;
+  graphlib_error_t    err;
 
-        break;
-      }
+  if ((view==NULL) || (ibyte_array==NULL))
+    return GRL_INVALID;
+  if (ibyte_array_len<sizeof(grlibint_ixheader_t))
+    return GRL_UNKNOWNFORMAT;
 
-    /*=====================================================*/
+  memcpy(&hdr,ibyte_array,sizeof(grlibint_ixheader_t));
+  err=grlibint_ixCheckHeader(&hdr,ibyte_array_len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
 
-    default:
-      {
-        return GRL_UNKNOWNFORMAT;
-        break;
-      }
-    }
+  view->base=ibyte_array;
+  view->len=hdr.total_len;
+  view->num_nodes=hdr.num_nodes;
+  view->num_edges=hdr.num_edges;
+  view->numannotation=hdr.numannotation;
+  view->num_node_attrs=hdr.num_node_attrs;
+  view->num_edge_attrs=hdr.num_edge_attrs;
+  view->directed=hdr.directed;
+  view->node_rec=hdr.node_rec;
+  view->edge_rec=hdr.edge_rec;
+  view->annotations=hdr.section[IX_ANNOTATIONS].off;
+  view->attrkeys=hdr.section[IX_ATTRKEYS].off;
+  view->nodes=hdr.section[IX_NODES].off;
+  view->edges=hdr.section[IX_EDGES].off;
+  view->heap=hdr.section[IX_HEAP].off;
+  view->heap_len=hdr.section[IX_HEAP].len;
 
   return GRL_OK;
 }
 
+
+/*............................................................*/
+/* resolve a heap slot stored at position pos of a view */
+
+graphlib_error_t grlibint_viewSlot(graphlib_graphview_p view, uint64_t pos,
+                                   const char **odata, unsigned int *olen)
+{
+  grlibint_ixslot_t slot;
+
+  memcpy(&slot,view->base+pos,sizeof(grlibint_ixslot_t));
+  if (slot.len==0)
+    {
+      *odata=NULL;
+      *olen=0;
+      return GRL_OK;
+    }
+  if ((slot.off>view->heap_len) || (slot.len>view->heap_len-slot.off) ||
+      (slot.len>UINT_MAX))
+    return GRL_UNKNOWNFORMAT;
+
+  *odata=view->base+view->heap+slot.off;
+  *olen=(unsigned int)slot.len;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* resolve a key string stored at position pos of a view */
+
+graphlib_error_t grlibint_viewKey(graphlib_graphview_p view, uint64_t pos,
+                                  const char **okey)
+{
+  graphlib_error_t err;
+  unsigned int     len;
+
+  err=grlibint_viewSlot(view,pos,okey,&len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if ((len>0) && ((*okey)[len-1]!='\0'))
+    return GRL_UNKNOWNFORMAT;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* view: counts */
+
+graphlib_error_t graphlib_viewNodeCount(graphlib_graphview_p view,
+                                        uint64_t *onum_nodes)
+{
+  *onum_nodes=view->num_nodes;
+  return GRL_OK;
+}
+
+graphlib_error_t graphlib_viewEdgeCount(graphlib_graphview_p view,
+                                        uint64_t *onum_edges)
+{
+  *onum_edges=view->num_edges;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* view: keys */
+
+graphlib_error_t graphlib_viewAnnotationKey(graphlib_graphview_p view,
+                                            int num, const char **okey)
+{
+  if ((num<0) || (num>=view->numannotation))
+    return GRL_NOATTRIBUTE;
+  return grlibint_viewKey(view,view->annotations+
+                          num*sizeof(grlibint_ixslot_t),okey);
+}
+
+graphlib_error_t graphlib_viewNodeAttrKey(graphlib_graphview_p view,
+                                          int num, const char **okey)
+{
+  if ((num<0) || (num>=view->num_node_attrs))
+    return GRL_NOATTRIBUTE;
+  return grlibint_viewKey(view,view->attrkeys+
+                          num*sizeof(grlibint_ixslot_t),okey);
+}
+
+graphlib_error_t graphlib_viewEdgeAttrKey(graphlib_graphview_p view,
+                                          int num, const char **okey)
+{
+  if ((num<0) || (num>=view->num_edge_attrs))
+    return GRL_NOATTRIBUTE;
+  return grlibint_viewKey(view,view->attrkeys+
+                          (view->num_node_attrs+num)*sizeof(grlibint_ixslot_t),
+                          okey);
+}
+
+
+/*............................................................*/
+/* view: access a node by position */
+
+graphlib_error_t graphlib_viewNode(graphlib_graphview_p view, uint64_t index,
+                                   graphlib_viewnode_p onode)
+{
+  grlibint_ixnode_t rec;
+  uint64_t          pos;
+
+  if (index>=view->num_nodes)
+    return GRL_NONODE;
+
+  pos=view->nodes+index*view->node_rec;
+  memcpy(&rec,view->base+pos,sizeof(grlibint_ixnode_t));
+  if ((rec.out_first>view->num_edges) ||
+      (rec.out_count>view->num_edges-rec.out_first))
+    return GRL_UNKNOWNFORMAT;
+
+  onode->id=rec.id;
+  onode->width=rec.width;
+  onode->w=rec.w;
+  onode->height=rec.height;
+  onode->color=rec.color;
+  onode->x=rec.x;
+  onode->y=rec.y;
+  onode->fontsize=rec.fontsize;
+  onode->out_first=rec.out_first;
+  onode->out_count=rec.out_count;
+  return grlibint_viewSlot(view,pos+offsetof(grlibint_ixnode_t,label),
+                           &(onode->label),&(onode->label_len));
+}
+
+
+/*............................................................*/
+/* view: find a node by id (binary search) */
+
+graphlib_error_t graphlib_viewFindNode(graphlib_graphview_p view,
+                                       graphlib_node_t node, uint64_t *oindex)
+{
+  uint64_t        lo,hi,mid;
+  graphlib_node_t id;
+
+  lo=0;
+  hi=view->num_nodes;
+  while (lo<hi)
+    {
+      mid=lo+(hi-lo)/2;
+      memcpy(&id,view->base+view->nodes+mid*view->node_rec+
+             offsetof(grlibint_ixnode_t,id),sizeof(graphlib_node_t));
+      if (id==node)
+        {
+          *oindex=mid;
+          return GRL_OK;
+        }
+      if (id<node)
+        lo=mid+1;
+      else
+        hi=mid;
+    }
+
+  return GRL_NONODE;
+}
+
+
+/*............................................................*/
+/* view: access an edge by position */
+
+graphlib_error_t graphlib_viewEdge(graphlib_graphview_p view, uint64_t index,
+                                   graphlib_viewedge_p oedge)
+{
+  grlibint_ixedge_t rec;
+  uint64_t          pos;
+
+  if (index>=view->num_edges)
+    return GRL_NOEDGE;
+
+  pos=view->edges+index*view->edge_rec;
+  memcpy(&rec,view->base+pos,sizeof(grlibint_ixedge_t));
+
+  oedge->node_from=rec.node_from;
+  oedge->node_to=rec.node_to;
+  oedge->index_from=rec.index_from;
+  oedge->index_to=rec.index_to;
+  oedge->width=rec.width;
+  oedge->color=rec.color;
+  oedge->arcstyle=rec.arcstyle;
+  oedge->block=rec.block;
+  oedge->fontsize=rec.fontsize;
+  return grlibint_viewSlot(view,pos+offsetof(grlibint_ixedge_t,label),
+                           &(oedge->label),&(oedge->label_len));
+}
+
+
+/*............................................................*/
+/* view: find an edge by its end points (binary search) */
+
+graphlib_error_t graphlib_viewFindEdge(graphlib_graphview_p view,
+                                       graphlib_node_t node_from,
+                                       graphlib_node_t node_to,
+                                       uint64_t *oindex)
+{
+  uint64_t          lo,hi,mid;
+  grlibint_ixedge_t rec;
+
+  lo=0;
+  hi=view->num_edges;
+  while (lo<hi)
+    {
+      mid=lo+(hi-lo)/2;
+      memcpy(&rec,view->base+view->edges+mid*view->edge_rec,
+             sizeof(grlibint_ixedge_t));
+      if ((rec.node_from==node_from) && (rec.node_to==node_to))
+        {
+          *oindex=mid;
+          return GRL_OK;
+        }
+      if ((rec.node_from<node_from) ||
+          ((rec.node_from==node_from) && (rec.node_to<node_to)))
+        lo=mid+1;
+      else
+        hi=mid;
+    }
+
+  return GRL_NOEDGE;
+}
+
+
+/*............................................................*/
+/* view: attributes and annotations */
+
+graphlib_error_t graphlib_viewNodeAttr(graphlib_graphview_p view,
+                                       uint64_t index, int num,
+                                       const char **odata,
+                                       unsigned int *olen)
+{
+  if (index>=view->num_nodes)
+    return GRL_NONODE;
+  if ((num<0) || (num>=view->num_node_attrs))
+    return GRL_NOATTRIBUTE;
+  return grlibint_viewSlot(view,view->nodes+index*view->node_rec+
+                           sizeof(grlibint_ixnode_t)+
+                           num*sizeof(grlibint_ixslot_t),odata,olen);
+}
+
+graphlib_error_t graphlib_viewEdgeAttr(graphlib_graphview_p view,
+                                       uint64_t index, int num,
+                                       const char **odata,
+                                       unsigned int *olen)
+{
+  if (index>=view->num_edges)
+    return GRL_NOEDGE;
+  if ((num<0) || (num>=view->num_edge_attrs))
+    return GRL_NOATTRIBUTE;
+  return grlibint_viewSlot(view,view->edges+index*view->edge_rec+
+                           sizeof(grlibint_ixedge_t)+
+                           num*sizeof(grlibint_ixslot_t),odata,olen);
+}
+
+graphlib_error_t graphlib_viewAnnotationGet(graphlib_graphview_p view,
+                                            uint64_t index, int num,
+                                            graphlib_annotation_t *val)
+{
+  if (index>=view->num_nodes)
+    return GRL_NONODE;
+  if ((num<0) || (num>=view->numannotation))
+    return GRL_NOATTRIBUTE;
+  memcpy(val,view->base+view->nodes+index*view->node_rec+
+         sizeof(grlibint_ixnode_t)+
+         view->num_node_attrs*sizeof(grlibint_ixslot_t)+
+         num*sizeof(graphlib_annotation_t),sizeof(graphlib_annotation_t));
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* checksum of a header, computed with the header_crc field zeroed */
+
+uint32_t grlibint_ixHeaderCRC(const char *base)
+{
+  grlibint_ixheader_t hdr;
+
+  memcpy(&hdr,base,sizeof(grlibint_ixheader_t));
+  hdr.header_crc=0;
+  return grlibint_crc32(0,(const char*)&hdr,sizeof(grlibint_ixheader_t));
+}
+
+
+/*............................................................*/
+/* add section and header checksums to a graph in the indexed layout */
+
+void grlibint_ixChecksum(char *base)
+{
+  grlibint_ixheader_t hdr;
+  int                 i;
+
+  memcpy(&hdr,base,sizeof(grlibint_ixheader_t));
+  for (i=0;i<IX_SECTIONS;i++)
+    hdr.section[i].crc=grlibint_crc32(0,base+hdr.section[i].off,
+                                      hdr.section[i].len);
+  hdr.flags|=IX_FLAG_CHECKSUM;
+  memcpy(base,&hdr,sizeof(grlibint_ixheader_t));
+  hdr.header_crc=grlibint_ixHeaderCRC(base);
+  memcpy(base,&hdr,sizeof(grlibint_ixheader_t));
+}
+
+
+/*............................................................*/
+/* reverse the byte order of consecutive words of the given size */
+
+void grlibint_swapWords(char *buf, uint64_t len, int size)
+{
+  uint64_t pos;
+  int      i;
+  char     c;
+
+  for (pos=0;pos+size<=len;pos+=size)
+    {
+      for (i=0;i<size/2;i++)
+        {
+          c=buf[pos+i];
+          buf[pos+i]=buf[pos+size-1-i];
+          buf[pos+size-1-i]=c;
+        }
+    }
+}
+
+
+/*............................................................*/
+/* convert a header to the other byte order */
+
+void grlibint_ixSwapHeader(grlibint_ixheader_t *hdr)
+{
+  int i;
+
+  grlibint_swapWords((char*)&(hdr->version),2*sizeof(uint32_t),
+                     sizeof(uint32_t));
+  grlibint_swapWords((char*)&(hdr->total_len),3*sizeof(uint64_t),
+                     sizeof(uint64_t));
+  grlibint_swapWords((char*)&(hdr->numannotation),
+                     offsetof(grlibint_ixheader_t,section)-
+                     offsetof(grlibint_ixheader_t,numannotation),
+                     sizeof(uint32_t));
+  for (i=0;i<IX_SECTIONS;i++)
+    {
+      grlibint_swapWords((char*)&(hdr->section[i].off),2*sizeof(uint64_t),
+                         sizeof(uint64_t));
+      grlibint_swapWords((char*)&(hdr->section[i].crc),2*sizeof(uint32_t),
+                         sizeof(uint32_t));
+    }
+}
+
+
+/*............................................................*/
+/* verify checksums and convert a graph in the indexed layout to
+   native byte order, in place
+   - graphs written on a machine with other byte order are converted
+     field by field; labels and attributes are left untouched, their
+     format is defined by the function table
+   - sections in the skip mask are not verified, the caller does
+     that before it uses them */
+
+graphlib_error_t grlibint_ixPrepare(char *base, uint64_t len, int skip)
+{
+  grlibint_ixheader_t hdr;
+  graphlib_error_t    err;
+  uint64_t            i,pos;
+  int                 swap,s;
+
+  if (len<sizeof(grlibint_ixheader_t))
+    return GRL_UNKNOWNFORMAT;
+  memcpy(&hdr,base,sizeof(grlibint_ixheader_t));
+  if (memcmp(hdr.magic,IX_MAGIC,IX_MAGICLEN)!=0)
+    return GRL_UNKNOWNFORMAT;
+
+  swap=(hdr.byteorder!=IX_BYTEORDER);
+  if (swap)
+    grlibint_ixSwapHeader(&hdr);
+  err=grlibint_ixCheckHeader(&hdr,len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  /* checksums cover the data as written */
+
+  if (hdr.flags & IX_FLAG_CHECKSUM)
+    {
+      if (grlibint_ixHeaderCRC(base)!=hdr.header_crc)
+        return GRL_FILEERROR;
+      for (s=0;s<IX_SECTIONS;s++)
+        if (!(skip & (1<<s)) &&
+            (grlibint_crc32(0,base+hdr.section[s].off,hdr.section[s].len)!=
+             hdr.section[s].crc))
+          return GRL_FILEERROR;
+    }
+
+  if (!swap)
+    return GRL_OK;
+
+  memcpy(base,&hdr,sizeof(grlibint_ixheader_t));
+
+  /* key slots */
+  grlibint_swapWords(base+hdr.section[IX_ANNOTATIONS].off,
+                     hdr.section[IX_ANNOTATIONS].len,sizeof(uint64_t));
+  grlibint_swapWords(base+hdr.section[IX_ATTRKEYS].off,
+                     hdr.section[IX_ATTRKEYS].len,sizeof(uint64_t));
+
+  /* nodes: widths, int fields, then 64 bit words only (ranges, slots,
+     annotations) */
+  for (i=0;i<hdr.num_nodes;i++)
+    {
+      pos=hdr.section[IX_NODES].off+i*hdr.node_rec;
+      grlibint_swapWords(base+pos,offsetof(grlibint_ixnode_t,id),
+                         sizeof(graphlib_width_t));
+      grlibint_swapWords(base+pos+offsetof(grlibint_ixnode_t,id),
+                         offsetof(grlibint_ixnode_t,out_first)-
+                         offsetof(grlibint_ixnode_t,id),sizeof(int32_t));
+      grlibint_swapWords(base+pos+offsetof(grlibint_ixnode_t,out_first),
+                         hdr.node_rec-offsetof(grlibint_ixnode_t,out_first),
+                         sizeof(uint64_t));
+    }
+
+  /* edges: same structure */
+  for (i=0;i<hdr.num_edges;i++)
+    {
+      pos=hdr.section[IX_EDGES].off+i*hdr.edge_rec;
+      grlibint_swapWords(base+pos,offsetof(grlibint_ixedge_t,node_from),
+                         sizeof(graphlib_width_t));
+      grlibint_swapWords(base+pos+offsetof(grlibint_ixedge_t,node_from),
+                         offsetof(grlibint_ixedge_t,index_from)-
+                         offsetof(grlibint_ixedge_t,node_from),
+                         sizeof(int32_t));
+      grlibint_swapWords(base+pos+offsetof(grlibint_ixedge_t,index_from),
+                         hdr.edge_rec-offsetof(grlibint_ixedge_t,index_from),
+                         sizeof(uint64_t));
+    }
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy the annotation and attribute keys of a view into a graph */
+
+graphlib_error_t grlibint_keysFromView(graphlib_graph_p graph,
+                                       graphlib_graphview_p view)
+{
+  graphlib_error_t err;
+  const char       *key;
+  int              i,index;
+
+  for (i=0;i<view->numannotation;i++)
+    {
+      err=graphlib_viewAnnotationKey(view,i,&key);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      if (key!=NULL)
+        {
+          graph->annotations[i]=strdup(key);
+          if (graph->annotations[i]==NULL)
+            return GRL_NOMEM;
+        }
+    }
+  for (i=0;i<view->num_node_attrs;i++)
+    {
+      err=graphlib_viewNodeAttrKey(view,i,&key);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      err=graphlib_addNodeAttrKey(graph,(key!=NULL) ? key : "",&index);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+  for (i=0;i<view->num_edge_attrs;i++)
+    {
+      err=graphlib_viewEdgeAttrKey(view,i,&key);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      err=graphlib_addEdgeAttrKey(graph,(key!=NULL) ? key : "",&index);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy one node of a view into a graph
+   - the graph is new, so the node ends up in the last used entry
+     of the first fragment, which is returned */
+
+graphlib_error_t grlibint_nodeFromView(graphlib_graph_p graph,
+                                       graphlib_graphview_p view,
+                                       uint64_t index,
+                                       graphlib_nodeentry_p *oentry)
+{
+  graphlib_error_t    err;
+  graphlib_nodeattr_t node_attr = {0,0,0,0,0,0,NULL,14,NULL};
+  graphlib_viewnode_t vn;
+  graphlib_nodeentry_p entry;
+  const char          *data;
+  unsigned int        len;
+  int                 j,slot;
+
+  err=graphlib_viewNode(view,index,&vn);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  node_attr.width=vn.width;
+  node_attr.height=vn.height;
+  node_attr.color=vn.color;
+  node_attr.x=vn.x;
+  node_attr.y=vn.y;
+  node_attr.fontsize=vn.fontsize;
+  if (vn.label_len!=0)
+    graph->functions->deserialize_node(&(node_attr.label),vn.label,
+                                       vn.label_len);
+  node_attr.attr_values=(void **)calloc(1,graph->num_node_attrs*
+                                        sizeof(void *));
+  if (node_attr.attr_values==NULL)
+    err=GRL_NOMEM;
+  for (j=0;(j<graph->num_node_attrs) && GRL_IS_OK(err);j++)
+    {
+      err=graphlib_viewNodeAttr(view,index,j,&data,&len);
+      if (GRL_IS_OK(err) && (len!=0))
+        graph->functions->
+          deserialize_node_attr(graph->node_attr_keys[j],
+                                &(node_attr.attr_values[j]),data,len);
+    }
+
+  if (GRL_IS_OK(err))
+    err=graphlib_addNodeNoCheck(graph,vn.id,&node_attr);
+  if (GRL_IS_OK(err))
+    {
+      slot=graph->nodes->count-1;
+      entry=&(graph->nodes->node[slot]);
+      entry->entry.data.attr.w=vn.w;
+      for (j=0;j<graph->numannotation;j++)
+        graphlib_viewAnnotationGet(view,index,j,
+          &(graph->nodes->grannot[slot*graph->numannotation+j]));
+      *oentry=entry;
+    }
+
+  if (node_attr.label!=NULL)
+    graph->functions->free_node(node_attr.label);
+  if (node_attr.attr_values!=NULL)
+    {
+      for (j=0;j<graph->num_node_attrs;j++)
+        graph->functions->free_node_attr(graph->node_attr_keys[j],
+                                         node_attr.attr_values[j]);
+      free(node_attr.attr_values);
+    }
+
+  return err;
+}
+
+
+/*............................................................*/
+/* copy one edge of a view into a graph
+   - edges without end points are skipped, like graphlib_addDirectedEdge
+     does */
+
+graphlib_error_t grlibint_edgeFromView(graphlib_graph_p graph,
+                                       graphlib_graphview_p view,
+                                       uint64_t index,
+                                       graphlib_nodeentry_p *entries)
+{
+  graphlib_error_t    err;
+  graphlib_edgeattr_t edge_attr = {1,0,NULL,0,0,14,NULL};
+  graphlib_viewedge_t ve;
+  graphlib_edgeentry_p entry;
+  const char          *data;
+  unsigned int        len;
+  int                 j;
+
+  err=graphlib_viewEdge(view,index,&ve);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if ((ve.index_from>=view->num_nodes) || (ve.index_to>=view->num_nodes))
+    return GRL_OK;
+
+  edge_attr.width=ve.width;
+  edge_attr.color=ve.color;
+  edge_attr.arcstyle=ve.arcstyle;
+  edge_attr.block=ve.block;
+  edge_attr.fontsize=ve.fontsize;
+  if (ve.label_len!=0)
+    graph->functions->deserialize_edge(&(edge_attr.label),ve.label,
+                                       ve.label_len);
+  edge_attr.attr_values=(void **)calloc(1,graph->num_edge_attrs*
+                                        sizeof(void *));
+  if (edge_attr.attr_values==NULL)
+    err=GRL_NOMEM;
+  for (j=0;(j<graph->num_edge_attrs) && GRL_IS_OK(err);j++)
+    {
+      err=graphlib_viewEdgeAttr(view,index,j,&data,&len);
+      if (GRL_IS_OK(err) && (len!=0))
+        graph->functions->
+          deserialize_edge_attr(graph->edge_attr_keys[j],
+                                &(edge_attr.attr_values[j]),data,len);
+    }
+
+  if (GRL_IS_OK(err))
+    err=graphlib_addDirectedEdgeNoCheck(graph,ve.node_from,ve.node_to,
+                                        &edge_attr);
+  if (GRL_IS_OK(err))
+    {
+      entry=&(graph->edges->edge[graph->edges->count-1]);
+      entry->entry.data.ref_from=entries[ve.index_from];
+      entry->entry.data.ref_to=entries[ve.index_to];
+    }
+
+  if (edge_attr.label!=NULL)
+    graph->functions->free_edge(edge_attr.label);
+  if (edge_attr.attr_values!=NULL)
+    {
+      for (j=0;j<graph->num_edge_attrs;j++)
+        graph->functions->free_edge_attr(graph->edge_attr_keys[j],
+                                         edge_attr.attr_values[j]);
+      free(edge_attr.attr_values);
+    }
+
+  return err;
+}
+
+
+/*............................................................*/
+/* create a new graph from a view */
+
+graphlib_error_t grlibint_graphFromView(graphlib_graph_p *ograph,
+                                        graphlib_functiontable_p functions,
+                                        graphlib_graphview_p view)
+{
+  graphlib_error_t     err;
+  graphlib_graph_p     graph;
+  graphlib_nodeentry_p *entries;
+  uint64_t             i;
+
+  if (view->numannotation>0)
+    err=graphlib_newAnnotatedGraph(&graph,functions,view->numannotation);
+  else
+    err=graphlib_newGraph(&graph,functions);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  /* node positions of the view map to entries, for the edge references */
+  entries=(graphlib_nodeentry_p*)malloc((view->num_nodes+1)*
+                                        sizeof(graphlib_nodeentry_p));
+  if (entries==NULL)
+    err=GRL_NOMEM;
+
+  if (GRL_IS_OK(err))
+    err=grlibint_keysFromView(graph,view);
+  for (i=0;(i<view->num_nodes) && GRL_IS_OK(err);i++)
+    err=grlibint_nodeFromView(graph,view,i,&(entries[i]));
+  for (i=0;(i<view->num_edges) && GRL_IS_OK(err);i++)
+    err=grlibint_edgeFromView(graph,view,i,entries);
+
+  if (entries!=NULL)
+    free(entries);
+  if (GRL_IS_NOTOK(err))
+    {
+      graphlib_delGraph(graph);
+      return err;
+    }
+
+  graph->directed=view->directed;
+  *ograph=graph;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy graph from a buffer in the indexed layout */
+
+graphlib_error_t graphlib_deserializeGraphIndexed(graphlib_graph_p *ograph,
+                                                  graphlib_functiontable_p
+                                                    functions,
+                                                  char *ibyte_array,
+                                                  uint64_t ibyte_array_len)
+{
+  graphlib_graphview_t view;
+  graphlib_error_t     err;
+
+  err=grlibint_ixPrepare(ibyte_array,ibyte_array_len,0);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  err=graphlib_viewGraph(&view,ibyte_array,ibyte_array_len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_graphFromView(ograph,functions,&view);
+}
+
+
+/*-----------------------------------------------------------------*/
+/* Block compression */
+
+/*............................................................*/
+/* LZ4 block format codec
+   - greedy single-pass compressor with a small hash table on the
+     stack, so concurrent calls are safe
+   - the decompressor checks every read and write against the bounds */
+
+uint32_t grlibint_lzRead32(const unsigned char *p)
+{
+  uint32_t val;
+
+  memcpy(&val,p,sizeof(uint32_t));
+  return val;
+}
+
+uint32_t grlibint_lzHash(uint32_t val)
+{
+  return (val*2654435761U)>>(32-LZ_HASHLOG);
+}
+
+unsigned char *grlibint_lzPutLength(unsigned char *op, uint64_t len)
+{
+  while (len>=255)
+    {
+      *op++=255;
+      len-=255;
+    }
+  *op++=(unsigned char)len;
+  return op;
+}
+
+
+/*............................................................*/
+/* compress one block
+   - returns the compressed length, or 0 if the result would not fit
+     into dstcap bytes */
+
+uint64_t grlibint_lzCompress(const char *isrc, uint64_t srclen, char *idst,
+                             uint64_t dstcap)
+{
+  const unsigned char *src=(const unsigned char*)isrc;
+  const unsigned char *ip,*anchor,*ref,*iend,*mflimit,*matchlimit;
+  unsigned char       *op,*oend,*token;
+  uint32_t            table[1<<LZ_HASHLOG];
+  uint32_t            h;
+  uint64_t            litlen,mlen,off;
+
+  ip=src;
+  anchor=src;
+  iend=src+srclen;
+  op=(unsigned char*)idst;
+  oend=op+dstcap;
+
+  if (srclen>LZ_MFLIMIT)
+    {
+      mflimit=iend-LZ_MFLIMIT;
+      matchlimit=iend-LZ_LASTLITERALS;
+      memset(table,0,sizeof(table));
+      ip++;
+
+      while (ip<mflimit)
+        {
+          h=grlibint_lzHash(grlibint_lzRead32(ip));
+          ref=src+table[h];
+          table[h]=(uint32_t)(ip-src);
+
+          if ((ref>=ip) || (ip-ref>LZ_MAXOFFSET) ||
+              (grlibint_lzRead32(ref)!=grlibint_lzRead32(ip)))
+            {
+              /* skip faster through data that does not compress */
+              ip+=1+((ip-anchor)>>LZ_SKIPSTRENGTH);
+              continue;
+            }
+
+          litlen=ip-anchor;
+          mlen=LZ_MINMATCH;
+          while ((ip+mlen<matchlimit) && (ref[mlen]==ip[mlen]))
+            mlen++;
+
+          if ((uint64_t)(oend-op)<1+litlen+litlen/255+1+2+
+              (mlen-LZ_MINMATCH)/255+1)
+            return 0;
+
+          token=op++;
+          if (litlen>=15)
+            {
+              *token=15<<4;
+              op=grlibint_lzPutLength(op,litlen-15);
+            }
+          else
+            *token=(unsigned char)(litlen<<4);
+          memcpy(op,anchor,litlen);
+          op+=litlen;
+
+          off=ip-ref;
+          *op++=(unsigned char)(off&0xff);
+          *op++=(unsigned char)(off>>8);
+
+          if (mlen-LZ_MINMATCH>=15)
+            {
+              *token|=15;
+              op=grlibint_lzPutLength(op,mlen-LZ_MINMATCH-15);
+            }
+          else
+            *token|=(unsigned char)(mlen-LZ_MINMATCH);
+
+          ip+=mlen;
+          anchor=ip;
+          if (ip<mflimit)
+            table[grlibint_lzHash(grlibint_lzRead32(ip-2))]=
+              (uint32_t)(ip-2-src);
+        }
+    }
+
+  /* the block always ends with literals */
+
+  litlen=iend-anchor;
+  if ((uint64_t)(oend-op)<1+litlen+litlen/255+1)
+    return 0;
+  token=op++;
+  if (litlen>=15)
+    {
+      *token=15<<4;
+      op=grlibint_lzPutLength(op,litlen-15);
+    }
+  else
+    *token=(unsigned char)(litlen<<4);
+  memcpy(op,anchor,litlen);
+  op+=litlen;
+
+  return op-(unsigned char*)idst;
+}
+
+
+/*............................................................*/
+/* decompress one block of known uncompressed size */
+
+graphlib_error_t grlibint_lzDecompress(const char *isrc, uint64_t srclen,
+                                       char *idst, uint64_t dstlen)
+{
+  const unsigned char *ip,*iend,*match;
+  unsigned char       *op,*oend,*dst;
+  uint64_t            len,off,i;
+  unsigned char       token,byte;
+
+  ip=(const unsigned char*)isrc;
+  iend=ip+srclen;
+  dst=(unsigned char*)idst;
+  op=dst;
+  oend=dst+dstlen;
+
+  while (ip<iend)
+    {
+      token=*ip++;
+
+      len=token>>4;
+      if (len==15)
+        {
+          do
+            {
+              if (ip>=iend)
+                return GRL_UNKNOWNFORMAT;
+              byte=*ip++;
+              len+=byte;
+            }
+          while (byte==255);
+        }
+      if ((len>(uint64_t)(iend-ip)) || (len>(uint64_t)(oend-op)))
+        return GRL_UNKNOWNFORMAT;
+      memcpy(op,ip,len);
+      op+=len;
+      ip+=len;
+
+      /* last sequence has no match */
+      if (ip>=iend)
+        break;
+
+      if (iend-ip<2)
+        return GRL_UNKNOWNFORMAT;
+      off=ip[0]|(ip[1]<<8);
+      ip+=2;
+      if ((off==0) || (off>(uint64_t)(op-dst)))
+        return GRL_UNKNOWNFORMAT;
+
+      len=token&15;
+      if (len==15)
+        {
+          do
+            {
+              if (ip>=iend)
+                return GRL_UNKNOWNFORMAT;
+              byte=*ip++;
+              len+=byte;
+            }
+          while (byte==255);
+        }
+      len+=LZ_MINMATCH;
+      if (len>(uint64_t)(oend-op))
+        return GRL_UNKNOWNFORMAT;
+
+      /* matches may overlap their own output */
+      match=op-off;
+      for (i=0;i<len;i++)
+        op[i]=match[i];
+      op+=len;
+    }
+
+  if (op!=oend)
+    return GRL_UNKNOWNFORMAT;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* is this a compressed frame? */
+
+int grlibint_isCompressed(const char *buf, uint64_t len)
+{
+  return (len>=XZ_MAGICLEN) && (memcmp(buf,XZ_MAGIC,XZ_MAGICLEN)==0);
+}
+
+
+/*............................................................*/
+/* compress a buffer into a frame of independently compressed blocks
+   - frame header: magic, version, codec, block size, content length
+   - each block: uncompressed length, compressed length (XZ_STORED
+     set if the block did not compress), CRC-32 of the uncompressed
+     data, then the data; a zero length block ends the frame */
+
+graphlib_error_t grlibint_compressFrame(const char *src, uint64_t len,
+                                        char **odst, uint64_t *odstlen)
+{
+  char     *dst,*op,*shrunk;
+  uint64_t pos,blen,clen,bound;
+  uint32_t hdr[XZ_BLOCKHDR/sizeof(uint32_t)];
+
+  bound=XZ_HEADERLEN+((len+XZ_BLOCKSIZE-1)/XZ_BLOCKSIZE)*
+    (XZ_BLOCKHDR+XZ_BLOCKSIZE)+XZ_BLOCKHDR;
+  dst=(char*)malloc(bound);
+  if (dst==NULL)
+    return GRL_NOMEM;
+
+  memset(dst,0,XZ_HEADERLEN);
+  memcpy(dst,XZ_MAGIC,XZ_MAGICLEN);
+  dst[XZ_MAGICLEN]=XZ_VERSION;
+  dst[XZ_MAGICLEN+1]=XZ_CODEC_LZ4;
+  hdr[0]=XZ_BLOCKSIZE;
+  memcpy(dst+XZ_MAGICLEN+4,hdr,sizeof(uint32_t));
+  memcpy(dst+XZ_MAGICLEN+8,&len,sizeof(uint64_t));
+  op=dst+XZ_HEADERLEN;
+
+  for (pos=0;pos<len;pos+=blen)
+    {
+      blen=len-pos;
+      if (blen>XZ_BLOCKSIZE)
+        blen=XZ_BLOCKSIZE;
+
+      clen=grlibint_lzCompress(src+pos,blen,op+XZ_BLOCKHDR,blen-1);
+      if (clen==0)
+        {
+          memcpy(op+XZ_BLOCKHDR,src+pos,blen);
+          clen=blen|XZ_STORED;
+        }
+      hdr[0]=(uint32_t)blen;
+      hdr[1]=(uint32_t)clen;
+      hdr[2]=grlibint_crc32(0,src+pos,blen);
+      memcpy(op,hdr,XZ_BLOCKHDR);
+      op+=XZ_BLOCKHDR+(clen&~XZ_STORED);
+    }
+
+  memset(op,0,XZ_BLOCKHDR);
+  op+=XZ_BLOCKHDR;
+
+  *odstlen=op-dst;
+  shrunk=(char*)realloc(dst,*odstlen);
+  *odst=(shrunk!=NULL) ? shrunk : dst;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* decompress a frame into a newly allocated buffer */
+
+graphlib_error_t grlibint_decompressFrame(const char *src, uint64_t len,
+                                          char **odst, uint64_t *odstlen)
+{
+  graphlib_error_t err;
+  char             *dst;
+  uint64_t         total,pos,out,clen;
+  uint32_t         hdr[XZ_BLOCKHDR/sizeof(uint32_t)];
+
+  if ((len<XZ_HEADERLEN) || !grlibint_isCompressed(src,len))
+    return GRL_UNKNOWNFORMAT;
+  if ((src[XZ_MAGICLEN]!=XZ_VERSION) || (src[XZ_MAGICLEN+1]!=XZ_CODEC_LZ4))
+    return GRL_UNKNOWNFORMAT;
+  memcpy(&total,src+XZ_MAGICLEN+8,sizeof(uint64_t));
+
+  /* no block expands by more than a factor of 255, this keeps a
+     corrupted length from causing a huge allocation */
+  if (total/XZ_MAXRATIO>len)
+    return GRL_UNKNOWNFORMAT;
+
+  dst=(char*)malloc(total+1);
+  if (dst==NULL)
+    return GRL_NOMEM;
+
+  err=GRL_OK;
+  pos=XZ_HEADERLEN;
+  out=0;
+  while (GRL_IS_OK(err))
+    {
+      if (len-pos<XZ_BLOCKHDR)
+        {
+          err=GRL_MEMORYERROR;
+          break;
+        }
+      memcpy(hdr,src+pos,XZ_BLOCKHDR);
+      pos+=XZ_BLOCKHDR;
+      if (hdr[0]==0)
+        break;
+
+      clen=hdr[1]&~XZ_STORED;
+      if ((clen>len-pos) || (hdr[0]>total-out))
+        err=GRL_MEMORYERROR;
+      else if (hdr[1]&XZ_STORED)
+        {
+          if (clen!=hdr[0])
+            err=GRL_UNKNOWNFORMAT;
+          else
+            memcpy(dst+out,src+pos,clen);
+        }
+      else
+        err=grlibint_lzDecompress(src+pos,clen,dst+out,hdr[0]);
+      if (GRL_IS_OK(err) && (grlibint_crc32(0,dst+out,hdr[0])!=hdr[2]))
+        err=GRL_FILEERROR;
+      pos+=clen;
+      out+=hdr[0];
+    }
+
+  if (GRL_IS_OK(err) && (out!=total))
+    err=GRL_MEMORYERROR;
+  if (GRL_IS_NOTOK(err))
+    {
+      free(dst);
+      return err;
+    }
+
+  *odst=dst;
+  *odstlen=total;
+  return GRL_OK;
+}
+
+
+/*-----------------------------------------------------------------*/
+/* I/O routines */
+
+/*............................................................*/
+/* load a graph from the contents of a compressed file
+   - the frame holds an unmodified version 1 or version 2 file */
+
+graphlib_error_t grlibint_loadCompressed(graphlib_graph_p *newgraph,
+                                         graphlib_functiontable_p functions,
+                                         const char *buf, uint64_t len)
+{
+  graphlib_error_t err;
+  char             *raw;
+  uint64_t         rawlen,size;
+
+  err=grlibint_decompressFrame(buf,len,&raw,&rawlen);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  if (rawlen<sizeof(uint64_t))
+    err=GRL_FILEERROR;
+  else if (memcmp(raw,IX_MAGIC,IX_MAGICLEN)==0)
+    err=graphlib_deserializeGraphIndexed(newgraph,functions,raw,rawlen);
+  else
+    {
+      memcpy(&size,raw,sizeof(uint64_t));
+      if (size>rawlen-sizeof(uint64_t))
+        err=GRL_FILEERROR;
+      else
+        err=graphlib_deserializeGraph(newgraph,functions,
+                                      raw+sizeof(uint64_t),size);
+    }
+
+  free(raw);
+  return err;
+}
+
+
+/*............................................................*/
+/* load a full graph / internal format
+   - files start with the magic of the indexed layout (version 2) or
+     with the length of a serialized graph (version 1), either of them
+     may be wrapped into a compressed frame */
+
+graphlib_error_t graphlib_loadGraph(graphlib_filename_t fn,
+                                    graphlib_graph_p *newgraph,
+                                    graphlib_functiontable_p functions)
+{
+  int                 fh;
+  graphlib_error_t    err;
+  char                *serialized_graph;
+  uint64_t            size;
+  grlibint_ixheader_t hdr,native;
+  struct stat         st;
+
+  fh=open(fn,O_RDONLY);
+  if (fh<0)
+    return GRL_FILEERROR;
+
+  err=grlibint_read(fh,(char*)(&size), sizeof(uint64_t));
+  if (GRL_IS_FATALERROR(err))
+    {
+      close(fh);
+      return err;
+    }
+  if (fstat(fh,&st)!=0)
+    {
+      close(fh);
+      return GRL_FILEERROR;
+    }
+
+  if (grlibint_isCompressed((char*)&size,sizeof(uint64_t)))
+    {
+      /* compressed: read the complete file */
+
+      serialized_graph=(char*)malloc(st.st_size);
+      if (serialized_graph==NULL)
+        {
+          close(fh);
+          return GRL_NOMEM;
+        }
+      memcpy(serialized_graph,&size,sizeof(uint64_t));
+      err=grlibint_read(fh,serialized_graph+sizeof(uint64_t),
+                        st.st_size-sizeof(uint64_t));
+      if (GRL_IS_OK(err))
+        err=grlibint_loadCompressed(newgraph,functions,serialized_graph,
+                                    st.st_size);
+    }
+  else if (memcmp(&size,IX_MAGIC,IX_MAGICLEN)==0)
+    {
+      /* version 2: the header tells the total size, it is checked
+         against the file and its checksum before anything is
+         allocated */
+
+      memcpy(&hdr,&size,sizeof(uint64_t));
+      err=grlibint_read(fh,((char*)&hdr)+sizeof(uint64_t),
+                        sizeof(grlibint_ixheader_t)-sizeof(uint64_t));
+      if (GRL_IS_FATALERROR(err))
+        {
+          close(fh);
+          return err;
+        }
+      native=hdr;
+      if (native.byteorder!=IX_BYTEORDER)
+        grlibint_ixSwapHeader(&native);
+      size=native.total_len;
+      if ((size<sizeof(grlibint_ixheader_t)) ||
+          (GRL_IS_FATALERROR(grlibint_ixCheckHeader(&native,st.st_size))) ||
+          ((native.flags & IX_FLAG_CHECKSUM) &&
+           (grlibint_ixHeaderCRC((char*)&hdr)!=native.header_crc)))
+        {
+          close(fh);
+          return GRL_UNKNOWNFORMAT;
+        }
+
+      serialized_graph=(char*)malloc(size);
+      if (serialized_graph==NULL)
+        {
+          close(fh);
+          return GRL_NOMEM;
+        }
+      memcpy(serialized_graph,&hdr,sizeof(grlibint_ixheader_t));
+      err=grlibint_read(fh,serialized_graph+sizeof(grlibint_ixheader_t),
+                        size-sizeof(grlibint_ixheader_t));
+      if (GRL_IS_OK(err))
+        err=graphlib_deserializeGraphIndexed(newgraph,functions,
+                                             serialized_graph,size);
+    }
+  else
+    {
+      /* version 1: length followed by the serialized graph, which
+         has to fit into the file */
+
+      if (size>(uint64_t)st.st_size-sizeof(uint64_t))
+        {
+          close(fh);
+          return GRL_UNKNOWNFORMAT;
+        }
+      serialized_graph=(char*)malloc(size);
+      if (serialized_graph==NULL)
+        {
+          close(fh);
+          return GRL_NOMEM;
+        }
+      err=grlibint_read(fh,serialized_graph,size);
+      if (GRL_IS_OK(err))
+        err=graphlib_deserializeGraph(newgraph,functions,serialized_graph,
+                                      size);
+    }
+
+  free(serialized_graph);
+  close(fh);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* load a full graph / internal format from a memory mapped file
+   - deserializes straight from the mapping, no copy of the file */
+
+graphlib_error_t graphlib_loadGraphMapped(graphlib_filename_t fn,
+                                          graphlib_graph_p *newgraph,
+                                          graphlib_functiontable_p functions)
+{
+  int                 fh;
+  graphlib_error_t    err;
+  struct stat         st;
+  char                *map;
+  uint64_t            len,size;
+  grlibint_ixheader_t hdr;
+
+  fh=open(fn,O_RDONLY);
+  if (fh<0)
+    return GRL_FILEERROR;
+  if ((fstat(fh,&st)!=0) || (st.st_size<(off_t)sizeof(uint64_t)))
+    {
+      close(fh);
+      return GRL_FILEERROR;
+    }
+  len=st.st_size;
+
+  /* private mapping, so byte order conversion only touches our copy */
+  map=(char*)mmap(NULL,len,PROT_READ,MAP_PRIVATE,fh,0);
+  close(fh);
+  if (map==MAP_FAILED)
+    return GRL_FILEERROR;
+  madvise(map,len,MADV_SEQUENTIAL);
+
+  if (grlibint_isCompressed(map,len))
+    err=grlibint_loadCompressed(newgraph,functions,map,len);
+  else if (memcmp(map,IX_MAGIC,IX_MAGICLEN)==0)
+    {
+      /* version 2 */
+
+      err=GRL_OK;
+      if (len>=sizeof(grlibint_ixheader_t))
+        {
+          memcpy(&hdr,map,sizeof(grlibint_ixheader_t));
+          if ((hdr.byteorder!=IX_BYTEORDER) &&
+              (mprotect(map,len,PROT_READ|PROT_WRITE)!=0))
+            err=GRL_FILEERROR;
+        }
+      if (GRL_IS_OK(err))
+        err=graphlib_deserializeGraphIndexed(newgraph,functions,map,len);
+    }
+  else
+    {
+      /* version 1 */
+
+      memcpy(&size,map,sizeof(uint64_t));
+      if (size>len-sizeof(uint64_t))
+        err=GRL_FILEERROR;
+      else
+        err=graphlib_deserializeGraph(newgraph,functions,
+                                      map+sizeof(uint64_t),size);
+    }
+
+  munmap(map,len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* lazy loading: create a graph with the structure of a view
+   - ids, edges, numeric attributes and annotations are copied, the
+     labels and attribute values are left pending */
+
+graphlib_error_t grlibint_lazyFromView(graphlib_graph_p graph,
+                                       grlibint_lazy_t *lazy)
+{
+  graphlib_graphview_p view=&(lazy->view);
+  graphlib_error_t     err;
+  graphlib_viewnode_t  vn;
+  graphlib_viewedge_t  ve;
+  graphlib_nodeentry_p node;
+  graphlib_edgeentry_p edge;
+  uint64_t             i,num_edges;
+  int                  j,slot;
+
+  if ((view->num_nodes>INT_MAX) || (view->num_edges>INT_MAX))
+    return GRL_UNKNOWNFORMAT;
+
+  err=grlibint_allocNodeFrags(graph,(int)view->num_nodes,&(lazy->nodefrags));
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  lazy->num_nodefrags=(view->num_nodes+NODEFRAGSIZE-1)/NODEFRAGSIZE;
+
+  for (i=0;i<view->num_nodes;i++)
+    {
+      err=graphlib_viewNode(view,i,&vn);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      slot=i%NODEFRAGSIZE;
+      node=&(lazy->nodefrags[i/NODEFRAGSIZE]->node[slot]);
+      node->entry.data.id=vn.id;
+      node->entry.data.attr.width=vn.width;
+      node->entry.data.attr.w=vn.w;
+      node->entry.data.attr.height=vn.height;
+      node->entry.data.attr.color=vn.color;
+      node->entry.data.attr.x=vn.x;
+      node->entry.data.attr.y=vn.y;
+      node->entry.data.attr.fontsize=vn.fontsize;
+      node->entry.data.attr.label=NULL;
+      node->entry.data.attr.attr_values=grlibint_pending_values;
+      node->full=1;
+      for (j=0;j<graph->numannotation;j++)
+        graphlib_viewAnnotationGet(view,i,j,
+          &(lazy->nodefrags[i/NODEFRAGSIZE]->
+            grannot[slot*graph->numannotation+j]));
+    }
+
+  /* edges without end points are dropped, like graphlib_addDirectedEdge
+     does */
+
+  num_edges=0;
+  for (i=0;i<view->num_edges;i++)
+    {
+      err=graphlib_viewEdge(view,i,&ve);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      if ((ve.index_from<view->num_nodes) && (ve.index_to<view->num_nodes))
+        num_edges++;
+    }
+  err=grlibint_allocEdgeFrags(graph,(int)num_edges,&(lazy->edgefrags));
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  num_edges=0;
+  for (i=0;i<view->num_edges;i++)
+    {
+      graphlib_viewEdge(view,i,&ve);
+      if ((ve.index_from>=view->num_nodes) || (ve.index_to>=view->num_nodes))
+        continue;
+      edge=&(lazy->edgefrags[num_edges/EDGEFRAGSIZE]->
+             edge[num_edges%EDGEFRAGSIZE]);
+      num_edges++;
+      edge->entry.data.node_from=ve.node_from;
+      edge->entry.data.node_to=ve.node_to;
+      edge->entry.data.ref_from=&(lazy->nodefrags[ve.index_from/NODEFRAGSIZE]->
+                                  node[ve.index_from%NODEFRAGSIZE]);
+      edge->entry.data.ref_to=&(lazy->nodefrags[ve.index_to/NODEFRAGSIZE]->
+                                node[ve.index_to%NODEFRAGSIZE]);
+      edge->entry.data.attr.width=ve.width;
+      edge->entry.data.attr.color=ve.color;
+      edge->entry.data.attr.arcstyle=ve.arcstyle;
+      edge->entry.data.attr.block=ve.block;
+      edge->entry.data.attr.fontsize=ve.fontsize;
+      edge->entry.data.attr.label=NULL;
+      edge->entry.data.attr.attr_values=grlibint_pending_values;
+      edge->full=1;
+    }
+
+  graph->directed=view->directed;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* lazy loading: verify the heap checksum skipped at load time */
+
+graphlib_error_t grlibint_lazyCheckHeap(grlibint_lazy_t *lazy)
+{
+  grlibint_ixheader_t  hdr;
+  grlibint_ixsection_t *sec;
+
+  if (lazy->heap_checked)
+    return GRL_OK;
+
+  memcpy(&hdr,lazy->buf,sizeof(grlibint_ixheader_t));
+  sec=&(hdr.section[IX_HEAP]);
+  if ((hdr.flags & IX_FLAG_CHECKSUM) &&
+      (grlibint_crc32(0,lazy->buf+sec->off,sec->len)!=sec->crc))
+    return GRL_FILEERROR;
+  lazy->heap_checked=1;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* lazy loading: decode the label and attribute values of the node
+   or edge at a position of the view
+   - attributes added to the graph after loading stay unset
+   - *oattr_values is NULL if nothing was decoded, otherwise the
+     values belong to the caller even on error */
+
+graphlib_error_t grlibint_lazyDecode(graphlib_graph_p graph, int is_node,
+                                     uint64_t index, void **olabel,
+                                     void ***oattr_values)
+{
+  graphlib_graphview_p view=&(graph->lazy->view);
+  graphlib_error_t     err;
+  graphlib_viewnode_t  vn;
+  graphlib_viewedge_t  ve;
+  const char           *data;
+  unsigned int         len;
+  int                  j,num_attrs;
+
+  *olabel=NULL;
+  *oattr_values=NULL;
+  err=grlibint_lazyCheckHeap(graph->lazy);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  num_attrs=is_node ? graph->num_node_attrs : graph->num_edge_attrs;
+  *oattr_values=(void **)calloc(1,num_attrs*sizeof(void *));
+  if (*oattr_values==NULL)
+    return GRL_NOMEM;
+
+  if (is_node)
+    {
+      err=graphlib_viewNode(view,index,&vn);
+      if (GRL_IS_OK(err) && (vn.label_len!=0))
+        graph->functions->deserialize_node(olabel,vn.label,vn.label_len);
+      if (num_attrs>view->num_node_attrs)
+        num_attrs=view->num_node_attrs;
+    }
+  else
+    {
+      err=graphlib_viewEdge(view,index,&ve);
+      if (GRL_IS_OK(err) && (ve.label_len!=0))
+        graph->functions->deserialize_edge(olabel,ve.label,ve.label_len);
+      if (num_attrs>view->num_edge_attrs)
+        num_attrs=view->num_edge_attrs;
+    }
+
+  for (j=0;(j<num_attrs) && GRL_IS_OK(err);j++)
+    {
+      if (is_node)
+        err=graphlib_viewNodeAttr(view,index,j,&data,&len);
+      else
+        err=graphlib_viewEdgeAttr(view,index,j,&data,&len);
+      if (GRL_IS_NOTOK(err) || (len==0))
+        continue;
+      if (is_node)
+        graph->functions->
+          deserialize_node_attr(graph->node_attr_keys[j],
+                                &((*oattr_values)[j]),data,len);
+      else
+        graph->functions->
+          deserialize_edge_attr(graph->edge_attr_keys[j],
+                                &((*oattr_values)[j]),data,len);
+    }
+
+  return err;
+}
+
+
+/*............................................................*/
+/* lazy loading: decode a pending node
+   - its position in the view follows from its entry */
+
+graphlib_error_t grlibint_lazyNode(graphlib_graph_p graph,
+                                   graphlib_nodeentry_p entry)
+{
+  grlibint_lazy_t  *lazy=graph->lazy;
+  graphlib_error_t err;
+  void             *label;
+  void             **attr_values;
+  int              k;
+
+  if ((lazy==NULL) ||
+      (entry->entry.data.attr.attr_values!=grlibint_pending_values))
+    return GRL_OK;
+
+  for (k=0;k<lazy->num_nodefrags;k++)
+    {
+      if ((entry>=lazy->nodefrags[k]->node) &&
+          (entry<lazy->nodefrags[k]->node+NODEFRAGSIZE))
+        break;
+    }
+  if (k==lazy->num_nodefrags)
+    return GRL_NONODE;
+
+  err=grlibint_lazyDecode(graph,1,(uint64_t)k*NODEFRAGSIZE+
+                          (entry-lazy->nodefrags[k]->node),
+                          &label,&attr_values);
+  if (attr_values!=NULL)
+    {
+      entry->entry.data.attr.label=label;
+      entry->entry.data.attr.attr_values=attr_values;
+    }
+  return err;
+}
+
+
+/*............................................................*/
+/* lazy loading: decode everything still pending and release the
+   source of the graph */
+
+graphlib_error_t grlibint_lazyLoadAll(graphlib_graph_p graph)
+{
+  grlibint_lazy_t      *lazy=graph->lazy;
+  graphlib_graphview_p view;
+  graphlib_error_t     err=GRL_OK;
+  graphlib_viewedge_t  ve;
+  graphlib_nodeentry_p node;
+  graphlib_edgeentry_p edge;
+  void                 *label;
+  void                 **attr_values;
+  uint64_t             i,n;
+
+  if (lazy==NULL)
+    return GRL_OK;
+  view=&(lazy->view);
+
+  for (i=0;(i<view->num_nodes) && GRL_IS_OK(err);i++)
+    {
+      node=&(lazy->nodefrags[i/NODEFRAGSIZE]->node[i%NODEFRAGSIZE]);
+      if (node->full)
+        err=grlibint_lazyNode(graph,node);
+    }
+
+  n=0;
+  for (i=0;(i<view->num_edges) && GRL_IS_OK(err);i++)
+    {
+      graphlib_viewEdge(view,i,&ve);
+      if ((ve.index_from>=view->num_nodes) || (ve.index_to>=view->num_nodes))
+        continue;
+      edge=&(lazy->edgefrags[n/EDGEFRAGSIZE]->edge[n%EDGEFRAGSIZE]);
+      n++;
+      if (!edge->full ||
+          (edge->entry.data.attr.attr_values!=grlibint_pending_values))
+        continue;
+      err=grlibint_lazyDecode(graph,0,i,&label,&attr_values);
+      if (attr_values!=NULL)
+        {
+          edge->entry.data.attr.label=label;
+          edge->entry.data.attr.attr_values=attr_values;
+        }
+    }
+
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  grlibint_freeLazy(lazy);
+  graph->lazy=NULL;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* load a graph, but decode labels and attribute values only when
+   they are needed
+   - version 2 files are mapped (compressed ones are expanded into
+     memory) and stay with the graph until everything is decoded
+   - version 1 files have no index, they are loaded completely */
+
+graphlib_error_t graphlib_loadGraphLazy(graphlib_filename_t fn,
+                                        graphlib_graph_p *newgraph,
+                                        graphlib_functiontable_p functions)
+{
+  int                 fh;
+  graphlib_error_t    err;
+  graphlib_graph_p    graph;
+  grlibint_lazy_t     *lazy;
+  grlibint_ixheader_t hdr;
+  struct stat         st;
+  char                *raw;
+  uint64_t            rawlen;
+
+  fh=open(fn,O_RDONLY);
+  if (fh<0)
+    return GRL_FILEERROR;
+  if ((fstat(fh,&st)!=0) || (st.st_size<(off_t)sizeof(uint64_t)))
+    {
+      close(fh);
+      return GRL_FILEERROR;
+    }
+
+  lazy=(grlibint_lazy_t*)calloc(1,sizeof(grlibint_lazy_t));
+  if (lazy==NULL)
+    {
+      close(fh);
+      return GRL_NOMEM;
+    }
+  lazy->len=st.st_size;
+  lazy->buf=(char*)mmap(NULL,lazy->len,PROT_READ,MAP_PRIVATE,fh,0);
+  close(fh);
+  if (lazy->buf==MAP_FAILED)
+    {
+      free(lazy);
+      return GRL_FILEERROR;
+    }
+  lazy->mapped=1;
+
+  err=GRL_OK;
+  if (grlibint_isCompressed(lazy->buf,lazy->len))
+    {
+      err=grlibint_decompressFrame(lazy->buf,lazy->len,&raw,&rawlen);
+      munmap(lazy->buf,lazy->len);
+      lazy->buf=raw;
+      lazy->len=rawlen;
+      lazy->mapped=0;
+      if (GRL_IS_FATALERROR(err))
+        {
+          free(lazy);
+          return err;
+        }
+    }
+
+  if ((lazy->len<sizeof(grlibint_ixheader_t)) ||
+      (memcmp(lazy->buf,IX_MAGIC,IX_MAGICLEN)!=0))
+    {
+      /* version 1 */
+      grlibint_freeLazy(lazy);
+      return graphlib_loadGraph(fn,newgraph,functions);
+    }
+
+  /* private mapping, so byte order conversion only touches our copy */
+  memcpy(&hdr,lazy->buf,sizeof(grlibint_ixheader_t));
+  if ((hdr.byteorder!=IX_BYTEORDER) && lazy->mapped &&
+      (mprotect(lazy->buf,lazy->len,PROT_READ|PROT_WRITE)!=0))
+    err=GRL_FILEERROR;
+  if (GRL_IS_OK(err))
+    err=grlibint_ixPrepare(lazy->buf,lazy->len,1<<IX_HEAP);
+  if (GRL_IS_OK(err))
+    err=graphlib_viewGraph(&(lazy->view),lazy->buf,lazy->len);
+  if (GRL_IS_FATALERROR(err))
+    {
+      grlibint_freeLazy(lazy);
+      return err;
+    }
+
+  if (lazy->view.numannotation>0)
+    err=graphlib_newAnnotatedGraph(&graph,functions,
+                                   lazy->view.numannotation);
+  else
+    err=graphlib_newGraph(&graph,functions);
+  if (GRL_IS_FATALERROR(err))
+    {
+      grlibint_freeLazy(lazy);
+      return err;
+    }
+  graph->lazy=lazy;
+
+  err=grlibint_keysFromView(graph,&(lazy->view));
+  if (GRL_IS_OK(err))
+    err=grlibint_lazyFromView(graph,lazy);
+  if (GRL_IS_FATALERROR(err))
+    {
+      graphlib_delGraph(graph);
+      return err;
+    }
+
+  *newgraph=graph;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* write a graph in the indexed layout (version 2) to a file
+   - records and heap data are produced item by item into a ring of
+     buffers that a writer thread drains, so memory use does not grow
+     with the size of the serialized graph
+   - section checksums are computed on the way, the header is written
+     again with them at the end */
+
+graphlib_error_t grlibint_saveGraphStreamed(int fh, graphlib_graph_p graph)
+{
+  grlibint_ixplan_t  plan;
+  grlibint_ostream_t s;
+  graphlib_error_t   err;
+  uint64_t           n,e,len,heap_pos;
+  int                i,num_keys;
+  const char         *key;
+  char               *out;
+
+  err=grlibint_ixPlan(graph,&plan);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  err=grlibint_ostreamOpen(&s,fh);
+  if (GRL_IS_FATALERROR(err))
+    {
+      grlibint_ixFreePlan(&plan);
+      return err;
+    }
+  num_keys=grlibint_ixNumKeys(graph);
+
+  out=grlibint_ostreamReserve(&s,sizeof(grlibint_ixheader_t));
+  if (out!=NULL)
+    {
+      memcpy(out,&(plan.hdr),sizeof(grlibint_ixheader_t));
+      grlibint_ostreamCommit(&s,sizeof(grlibint_ixheader_t));
+      grlibint_ostreamCRC(&s);
+    }
+
+  /* key slots */
+
+  heap_pos=0;
+  for (i=0;(i<graph->numannotation) && (out!=NULL);i++)
+    {
+      out=grlibint_ostreamReserve(&s,sizeof(grlibint_ixslot_t));
+      if (out!=NULL)
+        {
+          heap_pos=grlibint_ixPutKeySlot(out,heap_pos,
+                                         grlibint_ixKey(graph,i));
+          grlibint_ostreamCommit(&s,sizeof(grlibint_ixslot_t));
+        }
+    }
+  plan.hdr.section[IX_ANNOTATIONS].crc=grlibint_ostreamCRC(&s);
+
+  for (;(i<num_keys) && (out!=NULL);i++)
+    {
+      out=grlibint_ostreamReserve(&s,sizeof(grlibint_ixslot_t));
+      if (out!=NULL)
+        {
+          heap_pos=grlibint_ixPutKeySlot(out,heap_pos,
+                                         grlibint_ixKey(graph,i));
+          grlibint_ostreamCommit(&s,sizeof(grlibint_ixslot_t));
+        }
+    }
+  plan.hdr.section[IX_ATTRKEYS].crc=grlibint_ostreamCRC(&s);
+
+  /* node and edge records */
+
+  e=0;
+  for (n=0;(n<plan.hdr.num_nodes) && (out!=NULL);n++)
+    {
+      out=grlibint_ostreamReserve(&s,plan.hdr.node_rec);
+      if (out!=NULL)
+        {
+          heap_pos=grlibint_ixPutNode(graph,&plan,n,&e,heap_pos,out);
+          grlibint_ostreamCommit(&s,plan.hdr.node_rec);
+        }
+    }
+  plan.hdr.section[IX_NODES].crc=grlibint_ostreamCRC(&s);
+
+  for (e=0;(e<plan.hdr.num_edges) && (out!=NULL);e++)
+    {
+      out=grlibint_ostreamReserve(&s,plan.hdr.edge_rec);
+      if (out!=NULL)
+        {
+          heap_pos=grlibint_ixPutEdge(graph,&plan,e,heap_pos,out);
+          grlibint_ostreamCommit(&s,plan.hdr.edge_rec);
+        }
+    }
+  plan.hdr.section[IX_EDGES].crc=grlibint_ostreamCRC(&s);
+
+  /* heap, in the order in which the records reference it */
+
+  for (i=0;(i<num_keys) && (out!=NULL);i++)
+    {
+      key=grlibint_ixKey(graph,i);
+      if (key!=NULL)
+        {
+          len=strlen(key)+1;
+          out=grlibint_ostreamReserve(&s,len);
+          if (out!=NULL)
+            {
+              memcpy(out,key,len);
+              grlibint_ostreamCommit(&s,len);
+            }
+        }
+    }
+  for (n=0;(n<plan.hdr.num_nodes) && (out!=NULL);n++)
+    {
+      len=grlibint_ixNodeHeap(graph,plan.nodes[n].node);
+      out=grlibint_ostreamReserve(&s,len);
+      if (out!=NULL)
+        {
+          grlibint_ixPutNodeData(graph,plan.nodes[n].node,out);
+          grlibint_ostreamCommit(&s,len);
+        }
+    }
+  for (e=0;(e<plan.hdr.num_edges) && (out!=NULL);e++)
+    {
+      len=grlibint_ixEdgeHeap(graph,plan.edges[e]);
+      out=grlibint_ostreamReserve(&s,len);
+      if (out!=NULL)
+        {
+          grlibint_ixPutEdgeData(graph,plan.edges[e],out);
+          grlibint_ostreamCommit(&s,len);
+        }
+    }
+  plan.hdr.section[IX_HEAP].crc=grlibint_ostreamCRC(&s);
+
+  err=grlibint_ostreamClose(&s);
+  grlibint_ixFreePlan(&plan);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  /* final header */
+
+  plan.hdr.flags|=IX_FLAG_CHECKSUM;
+  plan.hdr.header_crc=grlibint_ixHeaderCRC((char*)&(plan.hdr));
+  if (lseek(fh,0,SEEK_SET)!=0)
+    return GRL_FILEERROR;
+  return grlibint_write(fh,(char*)&(plan.hdr),sizeof(grlibint_ixheader_t));
+}
+
+
+/*............................................................*/
+/* save a complete graph / internal format (version 1) */
+
+graphlib_error_t graphlib_saveGraph(graphlib_filename_t fn,
+                                    graphlib_graph_p graph)
+{
+  int              fh,iovcnt;
+  struct iovec     *iov;
+  uint64_t         size;
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  fh=open(fn,O_WRONLY|O_CREAT|O_TRUNC,S_IREAD|S_IWRITE|S_IRGRP|S_IROTH);
+  if (fh<0)
+    return GRL_FILEERROR;
+
+  /* labels are written from where they are, no serialized copy needed */
+  err=graphlib_serializeGraphIov(graph,&iov,&iovcnt,&size);
+  if (GRL_IS_FATALERROR(err))
+    {
+      close(fh);
+      return err;
+    }
+  err=grlibint_write(fh,(char*) &size, sizeof(uint64_t));
+  if (GRL_IS_OK(err))
+    err=grlibint_writev(fh,iov,iovcnt);
+  free(iov);
+  if (close(fh)!=0 && GRL_IS_OK(err))
+    err=GRL_FILEERROR;
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* save a complete graph / internal format (version 2) */
+
+graphlib_error_t graphlib_saveGraphIndexed(graphlib_filename_t fn,
+                                           graphlib_graph_p graph)
+{
+  int              fh;
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  fh=open(fn,O_WRONLY|O_CREAT|O_TRUNC,S_IREAD|S_IWRITE|S_IRGRP|S_IROTH);
+  if (fh<0)
+    return GRL_FILEERROR;
+
+  err=grlibint_saveGraphStreamed(fh,graph);
+  if (close(fh)!=0 && GRL_IS_OK(err))
+    err=GRL_FILEERROR;
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* save a complete graph / internal format (version 2), compressed */
+
+graphlib_error_t graphlib_saveGraphCompressed(graphlib_filename_t fn,
+                                              graphlib_graph_p graph)
+{
+  int              fh;
+  char             *serialized_graph,*compressed;
+  uint64_t         size,clen;
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_OK(err))
+    err=grlibint_serializeGraphIndexed(graph,&serialized_graph,&size);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  grlibint_ixChecksum(serialized_graph);
+  err=grlibint_compressFrame(serialized_graph,size,&compressed,&clen);
+  free(serialized_graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  fh=open(fn,O_WRONLY|O_CREAT|O_TRUNC,S_IREAD|S_IWRITE|S_IRGRP|S_IROTH);
+  if (fh<0)
+    {
+      free(compressed);
+      return GRL_FILEERROR;
+    }
+  err=grlibint_write(fh,compressed,clen);
+  free(compressed);
+  if (close(fh)!=0 && GRL_IS_OK(err))
+    err=GRL_FILEERROR;
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* text export: text of a label or attribute value (XT_ kind) from
+   the _to_text routines */
+
+char *grlibint_textOf(graphlib_functiontable_p fct, int kind,
+                      const char *key, const void *label)
+{
+  if (kind==XT_NODE)
+    return fct->node_to_text(label);
+  else if (kind==XT_EDGE)
+    return fct->edge_to_text(label);
+  else if (kind==XT_NODEATTR)
+    return fct->node_attr_to_text(key,label);
+  else
+    return fct->edge_attr_to_text(key,label);
+}
+
+
+/*............................................................*/
+/* text export: write the text of a label or attribute value
+   - graphs with a text cache reuse the text of earlier exports and
+     keep the text of labels seen for the first time
+   - otherwise the text buffer routines of the graph, or the built in
+     ones for the default string labels, write directly into the
+     stream and are called again with enough space if the text did
+     not fit; without them, or for NULL labels, the _to_text routines
+     are used
+   - labels without text are written as none */
+
+void grlibint_outText(grlibint_ostream_t *s, graphlib_graph_p graph,
+                      int kind, const char *key, const void *label,
+                      const char *none)
+{
+  graphlib_functiontable_p  fct=graph->functions;
+  graphlib_text_buf_fn      to_buf=NULL;
+  graphlib_attr_text_buf_fn attr_to_buf=NULL;
+  const char                *text;
+  char                      *dst,*tmp;
+  size_t                    avail,len;
+  int                       strings;
+
+  if ((graph->textcache!=NULL) && (label!=NULL))
+    {
+      if (grlibint_textFind(graph->textcache,kind,key,label,&text,&len))
+        {
+          if (text!=NULL)
+            grlibint_outBytes(s,text,len);
+          else
+            grlibint_outStr(s,none);
+          return;
+        }
+      tmp=grlibint_textOf(fct,kind,key,label);
+      grlibint_outStr(s,(tmp!=NULL) ? tmp : none);
+      if (!grlibint_textAdd(graph->textcache,kind,key,label,tmp))
+        free(tmp);
+      return;
+    }
+
+  if (kind==XT_NODE)
+    {
+      to_buf=graph->textbuf.node;
+      strings=(fct->node_to_text==grlibint_node_to_text);
+    }
+  else if (kind==XT_EDGE)
+    {
+      to_buf=graph->textbuf.edge;
+      strings=(fct->edge_to_text==grlibint_node_to_text);
+    }
+  else if (kind==XT_NODEATTR)
+    {
+      attr_to_buf=graph->textbuf.node_attr;
+      strings=(fct->node_attr_to_text==grlibint_node_attr_to_text);
+    }
+  else
+    {
+      attr_to_buf=graph->textbuf.edge_attr;
+      strings=(fct->edge_attr_to_text==grlibint_node_attr_to_text);
+    }
+  if ((to_buf==NULL) && (attr_to_buf==NULL) && (strings))
+    {
+      if ((kind==XT_NODE) || (kind==XT_EDGE))
+        to_buf=grlibint_node_to_text_buf;
+      else
+        attr_to_buf=grlibint_node_attr_to_text_buf;
+    }
+
+  if ((label==NULL) || ((to_buf==NULL) && (attr_to_buf==NULL)))
+    {
+      tmp=grlibint_textOf(fct,kind,key,label);
+      grlibint_outStr(s,(tmp!=NULL) ? tmp : none);
+      free(tmp);
+      return;
+    }
+
+  dst=grlibint_ostreamReserve(s,XT_MINBUF);
+  if (dst==NULL)
+    return;
+  avail=s->cap[s->fill]-s->used[s->fill];
+  len=(to_buf!=NULL) ? to_buf(label,dst,avail) :
+    attr_to_buf(key,label,dst,avail);
+  if (len>avail)
+    {
+      dst=grlibint_ostreamReserve(s,len);
+      if (dst==NULL)
+        return;
+      if (to_buf!=NULL)
+        to_buf(label,dst,len);
+      else
+        attr_to_buf(key,label,dst,len);
+    }
+  grlibint_ostreamCommit(s,len);
+}
+
+
+/*............................................................*/
+/* register the text buffer routines of a graph */
+
+graphlib_error_t graphlib_setTextBufFunctions(graphlib_graph_p graph,
+                                      graphlib_text_buf_fn node_to_text_buf,
+                                      graphlib_attr_text_buf_fn
+                                        node_attr_to_text_buf,
+                                      graphlib_text_buf_fn edge_to_text_buf,
+                                      graphlib_attr_text_buf_fn
+                                        edge_attr_to_text_buf)
+{
+  graph->textbuf.node=node_to_text_buf;
+  graph->textbuf.node_attr=node_attr_to_text_buf;
+  graph->textbuf.edge=edge_to_text_buf;
+  graph->textbuf.edge_attr=edge_attr_to_text_buf;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* DOT export: header with the graph attributes */
+
+void grlibint_expDotHeader(grlibint_ostream_t *s, int num_attrs,
+                           char **attr_keys, char **attr_values)
+{
+  int i;
+
+  grlibint_outStr(s,"digraph G {\n");
+  for (i=0;i<num_attrs;i++)
+    {
+      if (i==0)
+        grlibint_outStr(s,"\tgraph [");
+      else
+        grlibint_outStr(s,",");
+      grlibint_outStr(s,attr_keys[i]);
+      grlibint_outStr(s,"=\"");
+      grlibint_outStr(s,attr_values[i]);
+      grlibint_outStr(s,"\"");
+      if (i==num_attrs-1)
+        grlibint_outStr(s,"];\n");
+    }
+  grlibint_outStr(s,"\tnode [shape=record,style=filled,labeljust=c,"
+                  "height=0.2];\n");
+}
+
+
+/*............................................................*/
+/* DOT export: one node */
+
+void grlibint_expDotNode(grlibint_ostream_t *s, graphlib_graph_p graph,
+                         grlibint_colortab_t *tab, graphlib_format_t format,
+                         graphlib_nodedata_p node)
+{
+  int j;
+
+  grlibint_outStr(s,"\t");
+  grlibint_outInt(s,node->id);
+  grlibint_outStr(s," [pos=\"");
+  grlibint_outInt(s,node->attr.x);
+  grlibint_outStr(s,",");
+  grlibint_outInt(s,node->attr.y);
+  grlibint_outStr(s,"\", label=\"");
+  grlibint_outText(s,graph,XT_NODE,NULL,node->attr.label,NULL);
+  grlibint_outStr(s,"\", fillcolor=");
+  grlibint_outColor(s,tab,(format==GRF_PLAINDOT) ? XE_PLAINFILL : XE_DOTFILL,
+                    node->attr.color);
+  grlibint_outStr(s,", fontcolor=");
+  grlibint_outColor(s,tab,(format==GRF_PLAINDOT) ? XE_PLAINFONT : XE_DOTFONT,
+                    node->attr.color);
+  for (j=0; j<graph->num_node_attrs; j++)
+    {
+      grlibint_outStr(s,", ");
+      grlibint_outStr(s,graph->node_attr_keys[j]);
+      grlibint_outStr(s,"=\"");
+      grlibint_outText(s,graph,XT_NODEATTR,
+                       graph->node_attr_keys[j],node->attr.attr_values[j],
+                       NULL);
+      grlibint_outStr(s,"\"");
+    }
+  grlibint_outStr(s,"];\n");
+}
+
+
+/*............................................................*/
+/* DOT export: one edge */
+
+void grlibint_expDotEdge(grlibint_ostream_t *s, graphlib_graph_p graph,
+                         graphlib_edgedata_p edge)
+{
+  int j;
+
+  grlibint_outStr(s,"\t");
+  grlibint_outInt(s,edge->node_from);
+  grlibint_outStr(s," -> ");
+  grlibint_outInt(s,edge->node_to);
+  grlibint_outStr(s," [label=\"");
+  grlibint_outText(s,graph,XT_EDGE,NULL,edge->attr.label,NULL);
+  grlibint_outStr(s,"\"");
+  for (j=0; j<graph->num_edge_attrs; j++)
+    {
+      grlibint_outStr(s,", ");
+      grlibint_outStr(s,graph->edge_attr_keys[j]);
+      grlibint_outStr(s,"=\"");
+      grlibint_outText(s,graph,XT_EDGEATTR,
+                       graph->edge_attr_keys[j],edge->attr.attr_values[j],
+                       NULL);
+      grlibint_outStr(s,"\"");
+    }
+  grlibint_outStr(s,"]\n");
+}
+
+
+/*............................................................*/
+/* GML export: header */
+
+void grlibint_expGmlHeader(grlibint_ostream_t *s, graphlib_graph_p graph)
+{
+  grlibint_outStr(s,"Creator \"LLNL-graphlib\"\n");
+  grlibint_outStr(s,"Version 2.2\n");
+  grlibint_outStr(s,"graph\n");
+  grlibint_outStr(s,"[\n");
+  grlibint_outStr(s,"\tdirected ");
+  grlibint_outInt(s,graph->directed);
+  grlibint_outStr(s,"\n");
+}
+
+
+/*............................................................*/
+/* GML export: node label, nodes without one show their width */
+
+void grlibint_expGmlLabel(grlibint_ostream_t *s, graphlib_graph_p graph,
+                          graphlib_nodedata_p node, const char *prefix)
+{
+  grlibint_outStr(s,prefix);
+  if (node->attr.label==NULL)
+    {
+      if (node->attr.width!=0.0)
+        grlibint_outDouble(s,node->attr.width*1000.0,2);
+    }
+  else
+    grlibint_outText(s,graph,XT_NODE,NULL,node->attr.label,NULL);
+  grlibint_outStr(s,"\"\n");
+}
+
+
+/*............................................................*/
+/* GML export: one node with its annotations */
+
+void grlibint_expGmlNode(grlibint_ostream_t *s, graphlib_graph_p graph,
+                         grlibint_colortab_t *tab, graphlib_nodedata_p node,
+                         graphlib_annotation_t *annot)
+{
+  int j;
+
+  grlibint_outStr(s,"\tnode\n");
+  grlibint_outStr(s,"\t[\n");
+  grlibint_outStr(s,"\t\tid ");
+  grlibint_outInt(s,node->id);
+  grlibint_outStr(s,"\n");
+  grlibint_expGmlLabel(s,graph,node,"\t\tlabel \"");
+
+  for (j=0;j<graph->numannotation;j++)
+    {
+      if (graph->annotations[j]!=NULL)
+        {
+          grlibint_outStr(s,"\t\t");
+          grlibint_outStr(s,graph->annotations[j]);
+          grlibint_outStr(s," \"");
+          grlibint_outDouble(s,annot[j],6);
+          grlibint_outStr(s,"\"\n");
+        }
+    }
+
+  grlibint_outStr(s,"\t\tgraphics\n");
+  grlibint_outStr(s,"\t\t[\n");
+  grlibint_outStr(s,"\t\t\ttype \"rectangle\"\n");
+  grlibint_outStr(s,"\t\t\tfill ");
+  grlibint_outColor(s,tab,XE_DOTFILL,node->attr.color);
+  grlibint_outStr(s,"\n");
+  grlibint_outStr(s,"\t\t\toutline \"#000000\"\n");
+  grlibint_outStr(s,"\t\t\tx ");
+  grlibint_outInt(s,node->attr.x);
+  grlibint_outStr(s,"\n\t\t\ty ");
+  grlibint_outInt(s,node->attr.y);
+  grlibint_outStr(s,"\n\t\t\tw ");
+  grlibint_outDouble(s,node->attr.w,6);
+  grlibint_outStr(s,"\n\t\t\th ");
+  if (node->attr.height==0)
+    {
+      if (node->attr.width!=0.0)
+        grlibint_outDouble(s,20.0,6);
+      else
+        grlibint_outDouble(s,10.0,6);
+    }
+  else
+    grlibint_outDouble(s,node->attr.height,6);
+  grlibint_outStr(s,"\n");
+
+  grlibint_outStr(s,"\t\t]\n");
+
+  if ((node->attr.color==GRC_BLACK) ||
+      (node->attr.fontsize!=DEFAULT_FONT_SIZE))
+    {
+      grlibint_outStr(s,"\t\tLabelGraphics\n");
+      grlibint_outStr(s,"\t\t[\n");
+      grlibint_expGmlLabel(s,graph,node,"\t\t\ttext \"");
+
+      grlibint_outStr(s,"\t\t\tcolor ");
+      grlibint_outColor(s,tab,XE_DOTFONT,node->attr.color);
+      grlibint_outStr(s,"\n");
+
+      if (node->attr.fontsize!=DEFAULT_FONT_SIZE)
+        {
+          grlibint_outStr(s,"\t\t\tfontSize ");
+          grlibint_outInt(s,node->attr.fontsize);
+          grlibint_outStr(s,"\n");
+        }
+      grlibint_outStr(s,"\t\t]\n");
+    }
+
+  grlibint_outStr(s,"\t]\n");
+}
+
+
+/*............................................................*/
+/* GML export: edge widths are scaled to at most MAXEDGE_GML */
+
+double grlibint_expGmlEdgeScale(graphlib_graph_p graph)
+{
+  graphlib_edgefragment_p edgefrag;
+  graphlib_edgedata_p     edge;
+  double                  maxw;
+  int                     i;
+
+  maxw=1;
+  edgefrag=graph->edges;
+  while (edgefrag!=NULL)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (edgefrag->edge[i].full)
+            {
+              edge=&(edgefrag->edge[i].entry.data);
+              if (edge->attr.width>maxw)
+                maxw=edge->attr.width;
+            }
+        }
+      edgefrag=edgefrag->next;
+    }
+  /* just fro QBox paper to get uniform graphs */
+  /*   maxw=76; */
+
+  return MAXEDGE_GML/maxw;
+}
+
+
+/*............................................................*/
+/* GML export: one edge */
+
+void grlibint_expGmlEdge(grlibint_ostream_t *s, graphlib_graph_p graph,
+                         grlibint_colortab_t *tab, graphlib_edgedata_p edge,
+                         double edgescale)
+{
+  grlibint_outStr(s,"\tedge\n");
+  grlibint_outStr(s,"\t[\n");
+  grlibint_outStr(s,"\t\tsource ");
+  grlibint_outInt(s,edge->node_from);
+  grlibint_outStr(s,"\n\t\ttarget ");
+  grlibint_outInt(s,edge->node_to);
+  grlibint_outStr(s,"\n");
+  if (edge->attr.width>0)
+    {
+      grlibint_outStr(s,"\t\tlabel \"");
+      grlibint_outInt(s,(int)edge->attr.width);
+      grlibint_outStr(s,"\"\n");
+    }
+  grlibint_outStr(s,"\t\tgraphics\n");
+  grlibint_outStr(s,"\t\t[\n");
+  if (edge->attr.arcstyle==GRA_ARC)
+    grlibint_outStr(s,"\t\t\ttype \"arc\"\n");
+  else if (edge->attr.arcstyle==GRA_SPLINE)
+    grlibint_outStr(s,"\t\t\ttype \"spline\"\n");
+  if (edge->attr.width>0)
+    {
+      grlibint_outStr(s,"\t\t\twidth ");
+      grlibint_outDouble(s,edge->attr.width*edgescale,6);
+      grlibint_outStr(s,"\n");
+    }
+  else
+    grlibint_outStr(s,"\t\t\twidth 1.0\n");
+  grlibint_outStr(s,"\t\t\ttargetArrow \"standard\"\n");
+  grlibint_outStr(s,"\t\t\tfill ");
+  grlibint_outColor(s,tab,XE_DOTFILL,edge->attr.color);
+  grlibint_outStr(s,"\n");
+  if ((edge->attr.arcstyle==GRA_ARC) || (edge->attr.arcstyle==GRA_SPLINE))
+    {
+      grlibint_outStr(s,"\t\t\tarcType        \"fixedRatio\"\n");
+      grlibint_outStr(s,"\t\t\tarcRatio        1.0\n");
+    }
+  grlibint_outStr(s,"\t\t]\n");
+
+  grlibint_outStr(s,"\t\tLabelGraphics\n");
+  grlibint_outStr(s,"\t\t[\n");
+
+  if ((graph->edgeset) || (edge->attr.label!=NULL))
+    {
+      grlibint_outStr(s,"\t\t\ttext \"");
+      grlibint_outText(s,graph,XT_EDGE,NULL,edge->attr.label,NULL);
+      grlibint_outStr(s,"\"\n");
+    }
+
+  grlibint_outStr(s,"\t\t\tmodel   \"centered\"\n");
+  grlibint_outStr(s,"\t\t\tposition        \"center\"\n");
+  if (edge->attr.fontsize>0)
+    {
+      grlibint_outStr(s,"\t\t\tfontSize ");
+      grlibint_outInt(s,edge->attr.fontsize);
+      grlibint_outStr(s,"\n");
+    }
+  if ((edge->attr.block==GRB_BLOCK) ||
+      (edge->attr.block==GRB_FULL))
+    {
+      grlibint_outStr(s,"\t\t\toutline ");
+      grlibint_outColor(s,tab,XE_DOTFILL,edge->attr.color);
+      grlibint_outStr(s,"\n");
+    }
+  if (edge->attr.block==GRB_FULL)
+    {
+      grlibint_outStr(s,"\t\t\tfill ");
+      grlibint_outColor(s,tab,XE_DOTFILL,edge->attr.color);
+      grlibint_outStr(s,"\n");
+    }
+
+  grlibint_outStr(s,"\t\t]\n");
+
+  grlibint_outStr(s,"\t]\n");
+}
+
+
+/*............................................................*/
+/* export the nodes of one fragment as text into a stream */
+
+void grlibint_exportNodeFrag(grlibint_ostream_t *s, graphlib_graph_p graph,
+                             grlibint_colortab_t *tab,
+                             graphlib_format_t format,
+                             graphlib_nodefragment_p nodefrag)
+{
+  int i;
+
+  for (i=0;i<nodefrag->count;i++)
+    {
+      if (!nodefrag->node[i].full)
+        continue;
+      if (format==GRF_GML)
+        grlibint_expGmlNode(s,graph,tab,&(nodefrag->node[i].entry.data),
+                            nodefrag->grannot+i*graph->numannotation);
+      else
+        grlibint_expDotNode(s,graph,tab,format,
+                            &(nodefrag->node[i].entry.data));
+    }
+}
+
+
+/*............................................................*/
+/* export the edges of one fragment as text into a stream */
+
+void grlibint_exportEdgeFrag(grlibint_ostream_t *s, graphlib_graph_p graph,
+                             grlibint_colortab_t *tab,
+                             graphlib_format_t format,
+                             graphlib_edgefragment_p edgefrag,
+                             double edgescale)
+{
+  int i;
+
+  for (i=0;i<edgefrag->count;i++)
+    {
+      if (!edgefrag->edge[i].full)
+        continue;
+      if (format==GRF_GML)
+        grlibint_expGmlEdge(s,graph,tab,&(edgefrag->edge[i].entry.data),
+                            edgescale);
+      else
+        grlibint_expDotEdge(s,graph,&(edgefrag->edge[i].entry.data));
+    }
+}
+
+
+/*............................................................*/
+/* export the header of a graph as text into a stream
+   - returns the edge scale used by GML edges */
+
+double grlibint_exportHeader(grlibint_ostream_t *s, graphlib_graph_p graph,
+                             graphlib_format_t format, int num_attrs,
+                             char **attr_keys, char **attr_values)
+{
+  if (format==GRF_GML)
+    {
+      grlibint_expGmlHeader(s,graph);
+      return grlibint_expGmlEdgeScale(graph);
+    }
+  grlibint_expDotHeader(s,num_attrs,attr_keys,attr_values);
+  return 0.0;
+}
+
+
+/*............................................................*/
+/* export the footer of a graph as text into a stream */
+
+void grlibint_exportFooter(grlibint_ostream_t *s, graphlib_format_t format)
+{
+  if (format==GRF_GML)
+    grlibint_outStr(s,"]\n");
+  else
+    grlibint_outStr(s,"}\n");
+}
+
+
+/*............................................................*/
+/* export a graph as text into a stream
+   - nodes and edges in fragment order, formatted with the
+     grlibint_expDot and grlibint_expGml routines */
+
+void grlibint_exportText(grlibint_ostream_t *s, graphlib_graph_p graph,
+                         grlibint_colortab_t *tab, graphlib_format_t format,
+                         int num_attrs, char **attr_keys, char **attr_values)
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  double                  edgescale;
+
+  edgescale=grlibint_exportHeader(s,graph,format,num_attrs,attr_keys,
+                                  attr_values);
+
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    grlibint_exportNodeFrag(s,graph,tab,format,nodefrag);
+
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    grlibint_exportEdgeFrag(s,graph,tab,format,edgefrag,edgescale);
+
+  grlibint_exportFooter(s,format);
+}
+
+
+/*............................................................*/
+/* parallel text export
+   - units are the node fragments followed by the edge fragments;
+     threads take units in order, format each into a private
+     in-memory stream and append it to the output stream when all
+     earlier units have been appended, so the output is identical to
+     the sequential version */
+
+typedef struct grlibint_exportunit_d
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+} grlibint_exportunit_t;
+
+typedef struct grlibint_exportwork_d
+{
+  graphlib_graph_p      graph;
+  grlibint_colortab_t   *tab;
+  graphlib_format_t     format;
+  double                edgescale;
+  grlibint_exportunit_t *units;
+  int                   nunits;
+  grlibint_ostream_t    *out;
+  int                   next;
+  int                   turn;
+  graphlib_error_t      err;
+  pthread_mutex_t       lock;
+  pthread_cond_t        cond;
+} grlibint_exportwork_t;
+
+typedef struct grlibint_exportjob_d
+{
+  grlibint_exportwork_t *work;
+  grlibint_ostream_t    text;
+} grlibint_exportjob_t;
+
+
+/*............................................................*/
+/* parallel text export: format and append units until none are left */
+
+void *grlibint_exportJob(void *arg)
+{
+  grlibint_exportjob_t  *job=(grlibint_exportjob_t*)arg;
+  grlibint_exportwork_t *work=job->work;
+  grlibint_exportunit_t *unit;
+  int                   u;
+
+  pthread_mutex_lock(&(work->lock));
+  while (work->next<work->nunits)
+    {
+      u=work->next++;
+      pthread_mutex_unlock(&(work->lock));
+
+      unit=&(work->units[u]);
+      job->text.used[0]=0;
+      if (unit->nodefrag!=NULL)
+        grlibint_exportNodeFrag(&(job->text),work->graph,work->tab,
+                                work->format,unit->nodefrag);
+      else
+        grlibint_exportEdgeFrag(&(job->text),work->graph,work->tab,
+                                work->format,unit->edgefrag,
+                                work->edgescale);
+
+      /* only the unit whose turn it is appends, so the output stream
+         needs no further locking */
+
+      pthread_mutex_lock(&(work->lock));
+      while (work->turn!=u)
+        pthread_cond_wait(&(work->cond),&(work->lock));
+      pthread_mutex_unlock(&(work->lock));
+
+      if (GRL_IS_FATALERROR(job->text.failed))
+        work->err=job->text.failed;
+      else
+        grlibint_outBytes(work->out,job->text.buf[0],job->text.used[0]);
+
+      pthread_mutex_lock(&(work->lock));
+      work->turn++;
+      pthread_cond_broadcast(&(work->cond));
+    }
+  pthread_mutex_unlock(&(work->lock));
+  return NULL;
+}
+
+
+/*............................................................*/
+/* export a graph as text into a stream using several threads */
+
+graphlib_error_t grlibint_exportTextParallel(grlibint_ostream_t *s,
+                                             graphlib_graph_p graph,
+                                             grlibint_colortab_t *tab,
+                                             graphlib_format_t format,
+                                             int nthreads, int num_attrs,
+                                             char **attr_keys,
+                                             char **attr_values)
+{
+  grlibint_exportwork_t   work;
+  grlibint_exportjob_t    *jobs;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  graphlib_error_t        err;
+  int                     u,j;
+
+  if (nthreads<=0)
+    nthreads=sysconf(_SC_NPROCESSORS_ONLN);
+
+  memset(&work,0,sizeof(grlibint_exportwork_t));
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    work.nunits++;
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    work.nunits++;
+  if (nthreads>work.nunits)
+    nthreads=work.nunits;
+  if (nthreads<=1)
+    {
+      grlibint_exportText(s,graph,tab,format,num_attrs,attr_keys,
+                          attr_values);
+      return GRL_OK;
+    }
+
+  work.units=(grlibint_exportunit_t*)calloc(work.nunits,
+                                            sizeof(grlibint_exportunit_t));
+  jobs=(grlibint_exportjob_t*)calloc(nthreads,sizeof(grlibint_exportjob_t));
+  if ((work.units==NULL) || (jobs==NULL))
+    {
+      free(work.units);
+      free(jobs);
+      return GRL_NOMEM;
+    }
+
+  err=GRL_OK;
+  for (j=0;(j<nthreads) && GRL_IS_OK(err);j++)
+    {
+      jobs[j].work=&work;
+      err=grlibint_ostreamOpenMem(&(jobs[j].text));
+    }
+  if (GRL_IS_FATALERROR(err))
+    {
+      for (j=0;j<nthreads;j++)
+        free(jobs[j].text.buf[0]);
+      free(work.units);
+      free(jobs);
+      return err;
+    }
+
+  u=0;
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    work.units[u++].nodefrag=nodefrag;
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    work.units[u++].edgefrag=edgefrag;
+
+  work.graph=graph;
+  work.tab=tab;
+  work.format=format;
+  work.out=s;
+  work.err=GRL_OK;
+  pthread_mutex_init(&(work.lock),NULL);
+  pthread_cond_init(&(work.cond),NULL);
+
+  work.edgescale=grlibint_exportHeader(s,graph,format,num_attrs,attr_keys,
+                                       attr_values);
+  grlibint_runThreads(grlibint_exportJob,jobs,sizeof(grlibint_exportjob_t),
+                      nthreads);
+  grlibint_exportFooter(s,format);
+
+  pthread_mutex_destroy(&(work.lock));
+  pthread_cond_destroy(&(work.cond));
+  for (j=0;j<nthreads;j++)
+    free(jobs[j].text.buf[0]);
+  free(work.units);
+  free(jobs);
+
+  return work.err;
+}
+
+
+/*............................................................*/
+/* binary columnar export: append count words of the given size in
+   little endian byte order */
+
+void grlibint_outLE(grlibint_ostream_t *s, const void *src, int size,
+                    uint64_t count)
+{
+  uint32_t one=1;
+  char     *dst;
+
+  if (*((char*)&one)==1)
+    {
+      grlibint_outBytes(s,(const char*)src,size*count);
+      return;
+    }
+  dst=grlibint_ostreamReserve(s,size*count);
+  if (dst==NULL)
+    return;
+  memcpy(dst,src,size*count);
+  grlibint_swapWords(dst,size*count,size);
+  grlibint_ostreamCommit(s,size*count);
+}
+
+
+/*............................................................*/
+/* binary columnar export: zero bytes up to the next column */
+
+void grlibint_outAlign(grlibint_ostream_t *s, uint64_t len)
+{
+  static const char zero[XB_ALIGN]={0};
+
+  if (len%XB_ALIGN!=0)
+    grlibint_outBytes(s,zero,XB_ALIGN-len%XB_ALIGN);
+}
+
+
+/*............................................................*/
+/* binary columnar export: size of the elements of a column */
+
+int grlibint_binElementSize(uint32_t kind)
+{
+  switch (kind)
+    {
+    case GRK_NODE_ID:
+    case GRK_NODE_COLOR:
+    case GRK_EDGE_FROM:
+    case GRK_EDGE_TO:
+    case GRK_EDGE_COLOR:
+      return sizeof(int32_t);
+    case GRK_NODE_WIDTH:
+    case GRK_NODE_W:
+    case GRK_EDGE_WIDTH:
+    case GRK_ANNOTATION:
+      return sizeof(double);
+    case GRK_HEAP:
+      return 1;
+    default:
+      return sizeof(uint64_t);
+    }
+}
+
+
+/*............................................................*/
+/* binary columnar export: write a node or edge column */
+
+void grlibint_binColumn(grlibint_ostream_t *s, graphlib_graph_p graph,
+                        grlibint_bccolumn_t *col)
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  graphlib_nodedata_p     node;
+  graphlib_edgedata_p     edge;
+  int32_t                 ival;
+  double                  dval;
+  int                     i;
+
+  if (col->kind<=GRK_ANNOTATION)
+    {
+      for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+        {
+          for (i=0;i<nodefrag->count;i++)
+            {
+              if (!nodefrag->node[i].full)
+                continue;
+              node=&(nodefrag->node[i].entry.data);
+              if (col->kind==GRK_NODE_ID)
+                ival=node->id;
+              else if (col->kind==GRK_NODE_COLOR)
+                ival=node->attr.color;
+              else if (col->kind==GRK_NODE_WIDTH)
+                dval=node->attr.width;
+              else if (col->kind==GRK_NODE_W)
+                dval=node->attr.w;
+              else
+                dval=nodefrag->grannot[i*graph->numannotation+col->index];
+              if (grlibint_binElementSize(col->kind)==sizeof(int32_t))
+                grlibint_outLE(s,&ival,sizeof(int32_t),1);
+              else
+                grlibint_outLE(s,&dval,sizeof(double),1);
+            }
+        }
+    }
+  else
+    {
+      for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+        {
+          for (i=0;i<edgefrag->count;i++)
+            {
+              if (!edgefrag->edge[i].full)
+                continue;
+              edge=&(edgefrag->edge[i].entry.data);
+              if (col->kind==GRK_EDGE_FROM)
+                ival=edge->node_from;
+              else if (col->kind==GRK_EDGE_TO)
+                ival=edge->node_to;
+              else if (col->kind==GRK_EDGE_COLOR)
+                ival=edge->attr.color;
+              else
+                dval=edge->attr.width;
+              if (grlibint_binElementSize(col->kind)==sizeof(int32_t))
+                grlibint_outLE(s,&ival,sizeof(int32_t),1);
+              else
+                grlibint_outLE(s,&dval,sizeof(double),1);
+            }
+        }
+    }
+}
+
+
+/*............................................................*/
+/* binary columnar export: collect the text of all labels and the
+   annotation keys into the heap
+   - off receives num_nodes+1 node label offsets, num_edges+1 edge
+     label offsets and numannotation+1 key offsets */
+
+graphlib_error_t grlibint_binHeap(grlibint_ostream_t *heap,
+                                  graphlib_graph_p graph, uint64_t *off)
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  int                     i;
+
+  *(off++)=0;
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (!nodefrag->node[i].full)
+            continue;
+          grlibint_outText(heap,graph,XT_NODE,NULL,
+                           nodefrag->node[i].entry.data.attr.label,"");
+          *(off++)=heap->used[0];
+        }
+    }
+
+  *(off++)=heap->used[0];
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (!edgefrag->edge[i].full)
+            continue;
+          grlibint_outText(heap,graph,XT_EDGE,NULL,
+                           edgefrag->edge[i].entry.data.attr.label,"");
+          *(off++)=heap->used[0];
+        }
+    }
+
+  *(off++)=heap->used[0];
+  for (i=0;i<graph->numannotation;i++)
+    {
+      if (graph->annotations[i]!=NULL)
+        grlibint_outStr(heap,graph->annotations[i]);
+      *(off++)=heap->used[0];
+    }
+
+  return heap->failed;
+}
+
+
+/*............................................................*/
+/* export a graph in the binary columnar format into a stream
+   - the heap is built in memory first, its size is needed for the
+     column table; the other columns are written directly from the
+     fragments */
+
+graphlib_error_t grlibint_exportBinCol(grlibint_ostream_t *s,
+                                       graphlib_graph_p graph)
+{
+  grlibint_ostream_t  heap;
+  grlibint_bcheader_t hdr;
+  grlibint_bccolumn_t *cols;
+  graphlib_error_t    err;
+  uint64_t            *off,*offs[3];
+  uint64_t            pos;
+  int                 num_nodes,num_edges,c,i;
+
+  graphlib_nodeCount(graph,&num_nodes);
+  graphlib_edgeCount(graph,&num_edges);
+
+  memset(&hdr,0,sizeof(grlibint_bcheader_t));
+  memcpy(hdr.magic,XB_MAGIC,XB_MAGICLEN);
+  hdr.version=XB_VERSION;
+  hdr.num_columns=XB_FIXED+graph->numannotation;
+  hdr.num_nodes=num_nodes;
+  hdr.num_edges=num_edges;
+
+  cols=(grlibint_bccolumn_t*)calloc(hdr.num_columns,
+                                    sizeof(grlibint_bccolumn_t));
+  off=(uint64_t*)malloc((num_nodes+num_edges+graph->numannotation+3)*
+                        sizeof(uint64_t));
+  err=grlibint_ostreamOpenMem(&heap);
+  if ((cols==NULL) || (off==NULL) || GRL_IS_FATALERROR(err))
+    {
+      free(cols);
+      free(off);
+      free(heap.buf[0]);
+      return GRL_NOMEM;
+    }
+
+  err=grlibint_binHeap(&heap,graph,off);
+  offs[0]=off;
+  offs[1]=off+num_nodes+1;
+  offs[2]=off+num_nodes+num_edges+2;
+
+  /* column table: node columns, annotations, key offsets, edge
+     columns, heap */
+
+  c=0;
+  for (i=GRK_NODE_ID;i<=GRK_NODE_LABEL;i++)
+    {
+      cols[c].kind=i;
+      cols[c++].count=num_nodes+(i==GRK_NODE_LABEL);
+    }
+  for (i=0;i<graph->numannotation;i++)
+    {
+      cols[c].kind=GRK_ANNOTATION;
+      cols[c].index=i;
+      cols[c++].count=num_nodes;
+    }
+  cols[c].kind=GRK_ANNOTATION_KEY;
+  cols[c++].count=graph->numannotation+1;
+  for (i=GRK_EDGE_FROM;i<=GRK_EDGE_LABEL;i++)
+    {
+      cols[c].kind=i;
+      cols[c++].count=num_edges+(i==GRK_EDGE_LABEL);
+    }
+  cols[c].kind=GRK_HEAP;
+  cols[c++].count=heap.used[0];
+
+  pos=sizeof(grlibint_bcheader_t)+
+    hdr.num_columns*sizeof(grlibint_bccolumn_t);
+  for (c=0;c<(int)hdr.num_columns;c++)
+    {
+      pos=(pos+XB_ALIGN-1)/XB_ALIGN*XB_ALIGN;
+      cols[c].offset=pos;
+      pos+=cols[c].count*grlibint_binElementSize(cols[c].kind);
+    }
+
+  /* header and column table, then the columns */
+
+  if (GRL_IS_OK(err))
+    {
+      grlibint_outBytes(s,hdr.magic,XB_MAGICLEN);
+      grlibint_outLE(s,&(hdr.version),sizeof(uint32_t),2);
+      grlibint_outLE(s,&(hdr.num_nodes),sizeof(uint64_t),2);
+      for (c=0;c<(int)hdr.num_columns;c++)
+        {
+          grlibint_outLE(s,&(cols[c].kind),sizeof(uint32_t),2);
+          grlibint_outLE(s,&(cols[c].offset),sizeof(uint64_t),2);
+        }
+
+      pos=sizeof(grlibint_bcheader_t)+
+        hdr.num_columns*sizeof(grlibint_bccolumn_t);
+      for (c=0;c<(int)hdr.num_columns;c++)
+        {
+          grlibint_outAlign(s,pos);
+          pos=cols[c].offset;
+          if (cols[c].kind==GRK_NODE_LABEL)
+            grlibint_outLE(s,offs[0],sizeof(uint64_t),cols[c].count);
+          else if (cols[c].kind==GRK_EDGE_LABEL)
+            grlibint_outLE(s,offs[1],sizeof(uint64_t),cols[c].count);
+          else if (cols[c].kind==GRK_ANNOTATION_KEY)
+            grlibint_outLE(s,offs[2],sizeof(uint64_t),cols[c].count);
+          else if (cols[c].kind==GRK_HEAP)
+            grlibint_outBytes(s,heap.buf[0],heap.used[0]);
+          else
+            grlibint_binColumn(s,graph,&(cols[c]));
+          pos+=cols[c].count*grlibint_binElementSize(cols[c].kind);
+        }
+    }
+
+  free(cols);
+  free(off);
+  free(heap.buf[0]);
+  return err;
+}
+
+
+/*............................................................*/
+/* check whether an export format (with flags) is supported */
+
+int grlibint_exportFormatOK(graphlib_format_t format)
+{
+#ifndef HAVE_ZLIB
+  if (format&GRF_GZIP)
+    return 0;
+#endif
+  format&=~GRF_GZIP;
+  return ((format==GRF_DOT) || (format==GRF_PLAINDOT) ||
+          (format==GRF_GML) || (format==GRF_BINCOL));
+}
+
+
+/*............................................................*/
+/* check the format of an export and set up its color table */
+
+graphlib_error_t grlibint_exportPrepare(graphlib_graph_p graph,
+                                        graphlib_format_t format,
+                                        grlibint_colortab_t **tab)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  if (!grlibint_exportFormatOK(format))
+    return GRL_UNKNOWNFORMAT;
+
+  return grlibint_newColorTab(tab);
+}
+
+
+/*............................................................*/
+/* export a graph to a sink
+   - text is formatted into the buffers of a streaming output, which
+     a writer thread passes to the sink
+   - with GRF_GZIP a compressing sink is put in front of it, so the
+     writer thread also does the compression */
+
+graphlib_error_t grlibint_exportSink(graphlib_format_t format,
+                                     graphlib_graph_p graph, int nthreads,
+                                     int num_attrs, char **attr_keys,
+                                     char **attr_values,
+                                     graphlib_sink_fn write, void *arg)
+{
+  grlibint_ostream_t  s;
+  grlibint_colortab_t *tab;
+  graphlib_error_t    err,err2;
+#ifdef HAVE_ZLIB
+  grlibint_gzsink_t   gz;
+#endif
+
+  err=grlibint_exportPrepare(graph,format,&tab);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+#ifdef HAVE_ZLIB
+  if (format&GRF_GZIP)
+    {
+      err=grlibint_gzOpen(&gz,write,arg);
+      if (GRL_IS_FATALERROR(err))
+        {
+          free(tab);
+          return err;
+        }
+      write=grlibint_gzSink;
+      arg=&gz;
+    }
+#endif
+
+  err=grlibint_ostreamOpenSink(&s,write,arg);
+  if (GRL_IS_OK(err))
+    {
+      s.checksum=0;
+      if ((format&~GRF_GZIP)==GRF_BINCOL)
+        err=grlibint_exportBinCol(&s,graph);
+      else
+        err=grlibint_exportTextParallel(&s,graph,tab,format&~GRF_GZIP,
+                                        nthreads,num_attrs,attr_keys,
+                                        attr_values);
+      err2=grlibint_ostreamClose(&s);
+      if (GRL_IS_OK(err))
+        err=err2;
+    }
+  free(tab);
+
+#ifdef HAVE_ZLIB
+  if (format&GRF_GZIP)
+    err=grlibint_gzClose(&gz,err);
+#endif
+
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* export a graph as text into a new file
+   - file names ending in .gz select GRF_GZIP */
+
+graphlib_error_t grlibint_exportFile(graphlib_filename_t fn,
+                                     graphlib_format_t format,
+                                     graphlib_graph_p graph, int nthreads,
+                                     int num_attrs, char **attr_keys,
+                                     char **attr_values)
+{
+  graphlib_error_t err;
+  size_t           len;
+  int              fh;
+
+  len=strlen(fn);
+  if ((len>3) && (strcmp(fn+len-3,".gz")==0))
+    format|=GRF_GZIP;
+  if (!grlibint_exportFormatOK(format))
+    return GRL_UNKNOWNFORMAT;
+
+  /* open file */
+
+  fh=open(fn,O_WRONLY|O_CREAT|O_TRUNC,S_IREAD|S_IWRITE|S_IRGRP|S_IROTH);
+  if (fh<0)
+    return GRL_FILEERROR;
+
+  err=grlibint_exportSink(format,graph,nthreads,num_attrs,attr_keys,
+                          attr_values,grlibint_fdSink,(void*)(intptr_t)fh);
+
+  if (close(fh)!=0 && GRL_IS_OK(err))
+    err=GRL_FILEERROR;
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* export graph to new format */
+
+graphlib_error_t graphlib_exportGraph(graphlib_filename_t fn,
+                                      graphlib_format_t format,
+                                      graphlib_graph_p graph)
+{
+  return graphlib_exportAttributedGraph(fn, format, graph, 0, NULL, NULL);
+}
+
+/*............................................................*/
+/* export graph to new format */
+
+graphlib_error_t graphlib_exportAttributedGraph(graphlib_filename_t fn,
+                                      graphlib_format_t format,
+                                      graphlib_graph_p graph,
+                                      int num_attrs,
+                                      char **attr_keys,
+                                      char **attr_values)
+{
+  return grlibint_exportFile(fn,format,graph,1,num_attrs,attr_keys,
+                             attr_values);
+}
+
+/*............................................................*/
+/* export graph to new format using several threads */
+
+graphlib_error_t graphlib_exportGraphParallel(graphlib_filename_t fn,
+                                              graphlib_format_t format,
+                                              graphlib_graph_p graph,
+                                              int nthreads)
+{
+  return grlibint_exportFile(fn,format,graph,nthreads,0,NULL,NULL);
+}
+
+/*............................................................*/
+/* export graph to new format through a write routine */
+
+graphlib_error_t graphlib_exportGraphToSink(graphlib_format_t format,
+                                            graphlib_graph_p graph,
+                                            graphlib_sink_fn write,
+                                            void *arg)
+{
+  if (write==NULL)
+    return GRL_INVALID;
+  return grlibint_exportSink(format,graph,1,0,NULL,NULL,write,arg);
+}
+
+/*............................................................*/
+/* export graph to new format into an open file descriptor */
+
+graphlib_error_t graphlib_exportGraphToFd(int fd, graphlib_format_t format,
+                                          graphlib_graph_p graph)
+{
+  return grlibint_exportSink(format,graph,1,0,NULL,NULL,grlibint_fdSink,
+                             (void*)(intptr_t)fd);
+}
+
+/*............................................................*/
+/* export graph to new format into an open stdio stream */
+
+graphlib_error_t graphlib_exportGraphToFile(FILE *file,
+                                            graphlib_format_t format,
+                                            graphlib_graph_p graph)
+{
+  if (file==NULL)
+    return GRL_INVALID;
+  return grlibint_exportSink(format,graph,1,0,NULL,NULL,grlibint_fileSink,
+                             file);
+}
+
+/*............................................................*/
+/* sink appending to the in-memory stream passed as argument */
+
+graphlib_error_t grlibint_memSink(void *arg, const char *buf, uint64_t len)
+{
+  grlibint_ostream_t *s=(grlibint_ostream_t*)arg;
+
+  grlibint_outBytes(s,buf,len);
+  return s->failed;
+}
+
+/*............................................................*/
+/* export graph to new format into a newly allocated buffer
+   - the export sink collects the output in an in-memory stream,
+     whose buffer is handed to the caller */
+
+graphlib_error_t graphlib_exportGraphToBuffer(graphlib_format_t format,
+                                              graphlib_graph_p graph,
+                                              char **obuf, uint64_t *olen)
+{
+  grlibint_ostream_t s;
+  graphlib_error_t   err;
+
+  err=grlibint_ostreamOpenMem(&s);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  err=grlibint_exportSink(format,graph,1,0,NULL,NULL,grlibint_memSink,&s);
+  if (GRL_IS_FATALERROR(err))
+    {
+      free(s.buf[0]);
+      return err;
+    }
+
+  *obuf=s.buf[0];
+  *olen=s.used[0];
+  return GRL_OK;
+}
+
+/*............................................................*/
+/* number of bytes needed to serialize the graph header */
+
+uint64_t grlibint_serialHeaderLength(graphlib_graph_p igraph, int full_graph)
+{
+  uint64_t len;
+  int      i;
+
+  len=2*sizeof(int);
+
+  if (full_graph==1)
+    {
+      len+=sizeof(int);
+      for (i=0;i<igraph->numannotation;i++)
+        {
+          len+=sizeof(unsigned int);
+          if (igraph->annotations[i]!=NULL)
+            len+=strlen(igraph->annotations[i])+1;
+        }
+    }
+
+  len+=sizeof(int);
+  for (i=0;i<igraph->num_node_attrs;i++)
+    {
+      len+=sizeof(unsigned int);
+      if (igraph->node_attr_keys[i]!=NULL)
+        len+=strlen(igraph->node_attr_keys[i])+1;
+    }
+  len+=sizeof(int);
+  for (i=0;i<igraph->num_edge_attrs;i++)
+    {
+      len+=sizeof(unsigned int);
+      if (igraph->edge_attr_keys[i]!=NULL)
+        len+=strlen(igraph->edge_attr_keys[i])+1;
+    }
+
+  return len;
+}
+
+
+/*............................................................*/
+/* number of bytes needed to serialize one node */
+
+uint64_t grlibint_serialNodeLength(graphlib_graph_p igraph,
+                                   graphlib_nodedata_p node, int full_graph)
+{
+  uint64_t len;
+  int      j;
+
+  len=sizeof(graphlib_node_t)+sizeof(unsigned int);
+  len+=igraph->functions->serialize_node_length(node->attr.label);
+
+  for (j=0;j<igraph->num_node_attrs;j++)
+    {
+      len+=sizeof(unsigned int);
+      len+=igraph->functions->
+        serialize_node_attr_length(igraph->node_attr_keys[j],
+                                   node->attr.attr_values[j]);
+    }
+
+  if (full_graph==1)
+    len+=3*sizeof(graphlib_width_t)+sizeof(graphlib_color_t)+
+      2*sizeof(graphlib_coor_t)+sizeof(graphlib_fontsize_t);
+
+  return len;
+}
+
+
+/*............................................................*/
+/* number of bytes needed to serialize one edge */
+
+uint64_t grlibint_serialEdgeLength(graphlib_graph_p igraph,
+                                   graphlib_edgedata_p edge, int full_graph)
+{
+  uint64_t len;
+  int      j;
+
+  len=2*sizeof(graphlib_node_t)+sizeof(unsigned int);
+  len+=igraph->functions->serialize_edge_length(edge->attr.label);
+
+  for (j=0;j<igraph->num_edge_attrs;j++)
+    {
+      len+=sizeof(unsigned int);
+      len+=igraph->functions->
+        serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                   edge->attr.attr_values[j]);
+    }
+
+  if (full_graph==1)
+    len+=sizeof(graphlib_width_t)+sizeof(graphlib_color_t)+
+      sizeof(graphlib_arc_t)+sizeof(graphlib_block_t)+
+      sizeof(graphlib_fontsize_t);
+
+  return len;
+}
+
+
+/*............................................................*/
+/* number of bytes needed to serialize all nodes of a fragment */
+
+uint64_t grlibint_serialNodeFragLength(graphlib_graph_p igraph,
+                                       graphlib_nodefragment_p nodefrag,
+                                       int full_graph)
+{
+  uint64_t len;
+  int      i;
+
+  len=0;
+  for (i=0;i<nodefrag->count;i++)
+    {
+      if (nodefrag->node[i].full)
+        len+=grlibint_serialNodeLength(igraph,&(nodefrag->node[i].entry.data),
+                                       full_graph);
+    }
+  return len;
+}
+
+
+/*............................................................*/
+/* number of bytes needed to serialize all edges of a fragment */
+
+uint64_t grlibint_serialEdgeFragLength(graphlib_graph_p igraph,
+                                       graphlib_edgefragment_p edgefrag,
+                                       int full_graph)
+{
+  uint64_t len;
+  int      i;
+
+  len=0;
+  for (i=0;i<edgefrag->count;i++)
+    {
+      if (edgefrag->edge[i].full)
+        len+=grlibint_serialEdgeLength(igraph,&(edgefrag->edge[i].entry.data),
+                                       full_graph);
+    }
+  return len;
+}
+
+
+/*............................................................*/
+/* number of bytes needed to serialize a complete graph */
+
+uint64_t grlibint_serialGraphLength(graphlib_graph_p igraph, int full_graph)
+{
+  uint64_t                len;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+
+  len=grlibint_serialHeaderLength(igraph,full_graph);
+
+  nodefrag=igraph->nodes;
+  while (nodefrag!=NULL)
+    {
+      len+=grlibint_serialNodeFragLength(igraph,nodefrag,full_graph);
+      nodefrag=nodefrag->next;
+    }
+
+  edgefrag=igraph->edges;
+  while (edgefrag!=NULL)
+    {
+      len+=grlibint_serialEdgeFragLength(igraph,edgefrag,full_graph);
+      edgefrag=edgefrag->next;
+    }
+
+  return len;
+}
+
+
+/*............................................................*/
+/* append len bytes to a buffer that is known to be large enough
+   - returns the position after the copied data */
+
+char *grlibint_putData(char *dst, const void *src, unsigned int len)
+{
+  memcpy(dst,src,len);
+  return dst+len;
+}
+
+
+/*............................................................*/
+/* append a length prefixed string to a buffer that is known to be
+   large enough */
+
+char *grlibint_putString(char *dst, const char *str)
+{
+  unsigned int label_len;
+
+  if (str!=NULL)
+    label_len=strlen(str)+1;
+  else
+    label_len=0;
+  dst=grlibint_putData(dst,&label_len,sizeof(unsigned int));
+  if (label_len>0)
+    dst=grlibint_putData(dst,str,label_len);
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize the graph header into a buffer of sufficient size
+   - returns the position after the header */
+
+char *grlibint_serializeHeaderToBuf(graphlib_graph_p igraph, int num_nodes,
+                                    int num_edges, int full_graph, char *dst)
+{
+  int i;
+
+  dst=grlibint_putData(dst,&num_nodes,sizeof(int));
+  dst=grlibint_putData(dst,&num_edges,sizeof(int));
+
+  if (full_graph==1)
+    {
+      /* annotations */
+      dst=grlibint_putData(dst,&(igraph->numannotation),sizeof(int));
+      for (i=0;i<igraph->numannotation;i++)
+        dst=grlibint_putString(dst,igraph->annotations[i]);
+    }
+
+  /* attr keys */
+  dst=grlibint_putData(dst,&(igraph->num_node_attrs),sizeof(int));
+  for (i=0;i<igraph->num_node_attrs;i++)
+    dst=grlibint_putString(dst,igraph->node_attr_keys[i]);
+  dst=grlibint_putData(dst,&(igraph->num_edge_attrs),sizeof(int));
+  for (i=0;i<igraph->num_edge_attrs;i++)
+    dst=grlibint_putString(dst,igraph->edge_attr_keys[i]);
+
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize one node into a buffer of sufficient size
+   - labels are serialized in place, no temporary copies
+   - returns the position after the node */
+
+char *grlibint_serializeNodeToBuf(graphlib_graph_p igraph,
+                                  graphlib_nodedata_p node, int full_graph,
+                                  char *dst)
+{
+  unsigned int label_len;
+  int          j;
+
+  /* id */
+  dst=grlibint_putData(dst,&(node->id),sizeof(graphlib_node_t));
+
+  /* label */
+  label_len=igraph->functions->serialize_node_length(node->attr.label);
+  dst=grlibint_putData(dst,&label_len,sizeof(unsigned int));
+  if (label_len!=0)
+    {
+      igraph->functions->serialize_node(dst,node->attr.label);
+      dst+=label_len;
+    }
+
+  /* attrs */
+  for (j=0;j<igraph->num_node_attrs;j++)
+    {
+      label_len=igraph->functions->
+        serialize_node_attr_length(igraph->node_attr_keys[j],
+                                   node->attr.attr_values[j]);
+      dst=grlibint_putData(dst,&label_len,sizeof(unsigned int));
+      if (label_len!=0)
+        {
+          igraph->functions->serialize_node_attr(igraph->node_attr_keys[j],
+                                                 dst,
+                                                 node->attr.attr_values[j]);
+          dst+=label_len;
+        }
+    }
+
+  if (full_graph==1)
+    {
+      dst=grlibint_putData(dst,&(node->attr.width),sizeof(graphlib_width_t));
+      dst=grlibint_putData(dst,&(node->attr.w),sizeof(graphlib_width_t));
+      dst=grlibint_putData(dst,&(node->attr.height),sizeof(graphlib_width_t));
+      dst=grlibint_putData(dst,&(node->attr.color),sizeof(graphlib_color_t));
+      dst=grlibint_putData(dst,&(node->attr.x),sizeof(graphlib_coor_t));
+      dst=grlibint_putData(dst,&(node->attr.y),sizeof(graphlib_coor_t));
+      dst=grlibint_putData(dst,&(node->attr.fontsize),
+                           sizeof(graphlib_fontsize_t));
+    }
+
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize one edge into a buffer of sufficient size
+   - labels are serialized in place, no temporary copies
+   - returns the position after the edge */
+
+char *grlibint_serializeEdgeToBuf(graphlib_graph_p igraph,
+                                  graphlib_edgedata_p edge, int full_graph,
+                                  char *dst)
+{
+  unsigned int label_len;
+  int          j;
+
+  /* from_id, to_id */
+  dst=grlibint_putData(dst,&(edge->node_from),sizeof(graphlib_node_t));
+  dst=grlibint_putData(dst,&(edge->node_to),sizeof(graphlib_node_t));
+
+  /* name */
+  label_len=igraph->functions->serialize_edge_length(edge->attr.label);
+  dst=grlibint_putData(dst,&label_len,sizeof(unsigned int));
+  if (label_len!=0)
+    {
+      igraph->functions->serialize_edge(dst,edge->attr.label);
+      dst+=label_len;
+    }
+
+  /* attrs */
+  for (j=0;j<igraph->num_edge_attrs;j++)
+    {
+      label_len=igraph->functions->
+        serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                   edge->attr.attr_values[j]);
+      dst=grlibint_putData(dst,&label_len,sizeof(unsigned int));
+      if (label_len!=0)
+        {
+          igraph->functions->serialize_edge_attr(igraph->edge_attr_keys[j],
+                                                 dst,
+                                                 edge->attr.attr_values[j]);
+          dst+=label_len;
+        }
+    }
+
+  if (full_graph==1)
+    {
+      dst=grlibint_putData(dst,&(edge->attr.width),sizeof(graphlib_width_t));
+      dst=grlibint_putData(dst,&(edge->attr.color),sizeof(graphlib_color_t));
+      dst=grlibint_putData(dst,&(edge->attr.arcstyle),sizeof(graphlib_arc_t));
+      dst=grlibint_putData(dst,&(edge->attr.block),sizeof(graphlib_block_t));
+      dst=grlibint_putData(dst,&(edge->attr.fontsize),
+                           sizeof(graphlib_fontsize_t));
+    }
+
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize all nodes or edges of a fragment into a buffer of
+   sufficient size
+   - returns the position after the last element */
+
+char *grlibint_serializeNodeFragToBuf(graphlib_graph_p igraph,
+                                      graphlib_nodefragment_p nodefrag,
+                                      int full_graph, char *dst)
+{
+  int i;
+
+  for (i=0;i<nodefrag->count;i++)
+    {
+      if (nodefrag->node[i].full)
+        dst=grlibint_serializeNodeToBuf(igraph,&(nodefrag->node[i].entry.data),
+                                        full_graph,dst);
+    }
+  return dst;
+}
+
+char *grlibint_serializeEdgeFragToBuf(graphlib_graph_p igraph,
+                                      graphlib_edgefragment_p edgefrag,
+                                      int full_graph, char *dst)
+{
+  int i;
+
+  for (i=0;i<edgefrag->count;i++)
+    {
+      if (edgefrag->edge[i].full)
+        dst=grlibint_serializeEdgeToBuf(igraph,&(edgefrag->edge[i].entry.data),
+                                        full_graph,dst);
+    }
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize a graph into a buffer of sufficient size
+   - use grlibint_serialGraphLength to determine the size
+   - returns the position after the graph */
+
+char *grlibint_serializeGraphToBuf(graphlib_graph_p igraph, int full_graph,
+                                   char *dst)
+{
+  int                     num_nodes,num_edges;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+
+  graphlib_nodeCount(igraph,&num_nodes);
+  graphlib_edgeCount(igraph,&num_edges);
+
+  /* write header */
+  dst=grlibint_serializeHeaderToBuf(igraph,num_nodes,num_edges,full_graph,dst);
+
+  /* write nodes */
+  nodefrag=igraph->nodes;
+  while (nodefrag!=NULL)
+    {
+      dst=grlibint_serializeNodeFragToBuf(igraph,nodefrag,full_graph,dst);
+      nodefrag=nodefrag->next;
+    }
+
+  /* write edges */
+  edgefrag=igraph->edges;
+  while (edgefrag!=NULL)
+    {
+      dst=grlibint_serializeEdgeFragToBuf(igraph,edgefrag,full_graph,dst);
+      edgefrag=edgefrag->next;
+    }
+
+  return dst;
+}
+
+
+/*............................................................*/
+/* serialize a graph into a newly allocated byte array
+   - the exact size is computed first, so the array is allocated once */
+
 graphlib_error_t grlibint_serializeGraph(graphlib_graph_p igraph,
                                          char **obyte_array,
-                                         uint64_t *obyte_array_len,
-                                         int full_graph)
+                                         uint64_t *obyte_array_len,
+                                         int full_graph)
+{
+  uint64_t len;
+  char     *temp_array,*end;
+
+  len=grlibint_serialGraphLength(igraph,full_graph);
+
+  temp_array=(char*)malloc(len);
+  if (temp_array==NULL)
+    return GRL_NOMEM;
+
+  end=grlibint_serializeGraphToBuf(igraph,full_graph,temp_array);
+  assert((uint64_t)(end-temp_array)==len);
+
+  *obyte_array=temp_array;
+  *obyte_array_len=len;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* serialize a graph into a caller supplied byte array */
+
+graphlib_error_t grlibint_serializeGraphInto(graphlib_graph_p igraph,
+                                             char *obyte_array,
+                                             uint64_t obyte_array_len,
+                                             uint64_t *oused,
+                                             int full_graph)
+{
+  uint64_t len;
+
+  len=grlibint_serialGraphLength(igraph,full_graph);
+  *oused=len;
+  if (len>obyte_array_len)
+    return GRL_MEMORYERROR;
+
+  grlibint_serializeGraphToBuf(igraph,full_graph,obyte_array);
+  return GRL_OK;
+}
+
+/*............................................................*/
+/* parallel serialization
+   - every node and edge fragment is a unit of work; threads first
+     size contiguous ranges of units, after a prefix sum over the
+     sizes they serialize the same ranges into their final position,
+     so the result is identical to the sequential version */
+
+typedef struct grlibint_serialunit_d
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  uint64_t                len;
+  uint64_t                off;
+} grlibint_serialunit_t;
+
+typedef struct grlibint_serialjob_d
+{
+  graphlib_graph_p      igraph;
+  int                   full_graph;
+  grlibint_serialunit_t *units;
+  int                   first;
+  int                   last;
+  char                  *buf;
+} grlibint_serialjob_t;
+
+
+/*............................................................*/
+/* parallel serialization: size (buf==NULL) or write a range of units */
+
+void *grlibint_serialJob(void *arg)
+{
+  grlibint_serialjob_t  *job=(grlibint_serialjob_t*)arg;
+  grlibint_serialunit_t *unit;
+  int                   u;
+
+  for (u=job->first;u<job->last;u++)
+    {
+      unit=&(job->units[u]);
+      if (job->buf==NULL)
+        {
+          if (unit->nodefrag!=NULL)
+            unit->len=grlibint_serialNodeFragLength(job->igraph,
+                                                    unit->nodefrag,
+                                                    job->full_graph);
+          else
+            unit->len=grlibint_serialEdgeFragLength(job->igraph,
+                                                    unit->edgefrag,
+                                                    job->full_graph);
+        }
+      else if (unit->nodefrag!=NULL)
+        grlibint_serializeNodeFragToBuf(job->igraph,unit->nodefrag,
+                                        job->full_graph,job->buf+unit->off);
+      else
+        grlibint_serializeEdgeFragToBuf(job->igraph,unit->edgefrag,
+                                        job->full_graph,job->buf+unit->off);
+    }
+  return NULL;
+}
+
+
+/*............................................................*/
+/* parallel serialization: run all jobs on the given buffer */
+
+void grlibint_runSerialJobs(grlibint_serialjob_t *jobs, int njobs, char *buf)
+{
+  int j;
+
+  for (j=0;j<njobs;j++)
+    jobs[j].buf=buf;
+  grlibint_runThreads(grlibint_serialJob,jobs,sizeof(grlibint_serialjob_t),
+                      njobs);
+}
+
+
+/*............................................................*/
+/* serialize a graph into a newly allocated byte array using several
+   threads (version 1 stream, identical to grlibint_serializeGraph) */
+
+graphlib_error_t grlibint_serializeGraphParallel(graphlib_graph_p igraph,
+                                                 int nthreads,
+                                                 char **obyte_array,
+                                                 uint64_t *obyte_array_len,
+                                                 int full_graph)
+{
+  grlibint_serialunit_t   *units;
+  grlibint_serialjob_t    *jobs;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  int                     nunits,u,j,per,num_nodes,num_edges;
+  uint64_t                len;
+  char                    *buf;
+
+  if (nthreads<=0)
+    nthreads=sysconf(_SC_NPROCESSORS_ONLN);
+
+  nunits=0;
+  for (nodefrag=igraph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    nunits++;
+  for (edgefrag=igraph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    nunits++;
+  if (nthreads>nunits)
+    nthreads=nunits;
+  if (nthreads<=1)
+    return grlibint_serializeGraph(igraph,obyte_array,obyte_array_len,
+                                   full_graph);
+
+  units=(grlibint_serialunit_t*)calloc(nunits,sizeof(grlibint_serialunit_t));
+  jobs=(grlibint_serialjob_t*)calloc(nthreads,sizeof(grlibint_serialjob_t));
+  if ((units==NULL) || (jobs==NULL))
+    {
+      free(units);
+      free(jobs);
+      return GRL_NOMEM;
+    }
+
+  u=0;
+  for (nodefrag=igraph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    units[u++].nodefrag=nodefrag;
+  for (edgefrag=igraph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    units[u++].edgefrag=edgefrag;
+
+  per=(nunits+nthreads-1)/nthreads;
+  for (j=0;j<nthreads;j++)
+    {
+      jobs[j].igraph=igraph;
+      jobs[j].full_graph=full_graph;
+      jobs[j].units=units;
+      jobs[j].first=(j*per<nunits) ? j*per : nunits;
+      jobs[j].last=((j+1)*per<nunits) ? (j+1)*per : nunits;
+    }
+
+  /* size all units, then place them behind the header */
+
+  grlibint_runSerialJobs(jobs,nthreads,NULL);
+  len=grlibint_serialHeaderLength(igraph,full_graph);
+  for (u=0;u<nunits;u++)
+    {
+      units[u].off=len;
+      len+=units[u].len;
+    }
+
+  buf=(char*)malloc(len);
+  if (buf==NULL)
+    {
+      free(units);
+      free(jobs);
+      return GRL_NOMEM;
+    }
+
+  graphlib_nodeCount(igraph,&num_nodes);
+  graphlib_edgeCount(igraph,&num_edges);
+  grlibint_serializeHeaderToBuf(igraph,num_nodes,num_edges,full_graph,buf);
+  grlibint_runSerialJobs(jobs,nthreads,buf);
+
+  free(units);
+  free(jobs);
+
+  *obyte_array=buf;
+  *obyte_array_len=len;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* label dictionary of GRE_DICT streams
+   - distinct serialized labels and attribute values, hashed by
+     content; refs holds the reference of every label and value of
+     the graph in stream order (0 for empty ones, else entry+1) */
+
+typedef struct grlibint_dict_d
+{
+  char         *heap;
+  uint64_t     heap_len;
+  uint64_t     heap_cap;
+  uint64_t     *pos;
+  unsigned int *len;
+  uint32_t     num;
+  uint32_t     cap;
+  uint32_t     *hash;
+  uint32_t     hash_size;
+  uint32_t     *refs;
+  char         *scratch;
+  unsigned int scratch_cap;
+  uint64_t     node_stride;
+  uint64_t     edge_stride;
+  uint64_t     edge_base;
+} grlibint_dict_t;
+
+
+/*............................................................*/
+/* extended stream writer
+   - with buf==NULL only the required size is counted, so the same
+     code sizes and fills the output */
+
+typedef struct grlibint_writer_d
+{
+  char                *buf;
+  uint64_t            pos;
+  int                 flags;
+  graphlib_node_t     prev_id,prev_from,prev_to;
+  uint64_t            *index;
+  uint64_t            num_chunks;
+  graphlib_nodedata_p *nodes;    /* all nodes of columnar streams */
+  graphlib_edgedata_p *edges;    /* all edges of columnar streams */
+  grlibint_dict_t     *dict;
+  uint64_t            item;      /* node or edge being encoded */
+  int                 fields;    /* GRM_ fields to encode */
+  int                 *node_sel; /* indices of the encoded attributes */
+  int                 num_node_sel;
+  int                 *edge_sel;
+  int                 num_edge_sel;
+} grlibint_writer_t;
+
+
+/*............................................................*/
+/* basic encoders: raw bytes, LEB128 varints, ints (zig-zag varints
+   in compact streams), lengths and counts */
+
+void grlibint_putBytes(grlibint_writer_t *w, const void *src, uint64_t len)
+{
+  if (w->buf!=NULL)
+    memcpy(w->buf+w->pos,src,len);
+  w->pos+=len;
+}
+
+void grlibint_putVarint(grlibint_writer_t *w, uint64_t val)
+{
+  unsigned char byte;
+
+  do
+    {
+      byte=val&0x7f;
+      val>>=7;
+      if (val!=0)
+        byte|=0x80;
+      if (w->buf!=NULL)
+        w->buf[w->pos]=byte;
+      w->pos++;
+    }
+  while (val!=0);
+}
+
+void grlibint_putInt(grlibint_writer_t *w, int64_t val)
+{
+  int fixed;
+
+  if (w->flags & GRE_COMPACT)
+    grlibint_putVarint(w,((uint64_t)val<<1)^(uint64_t)(val>>63));
+  else
+    {
+      fixed=(int)val;
+      grlibint_putBytes(w,&fixed,sizeof(int));
+    }
+}
+
+void grlibint_putLength(grlibint_writer_t *w, unsigned int len)
+{
+  if (w->flags & GRE_COMPACT)
+    grlibint_putVarint(w,len);
+  else
+    grlibint_putBytes(w,&len,sizeof(unsigned int));
+}
+
+void grlibint_putCount(grlibint_writer_t *w, uint64_t count)
+{
+  int fixed;
+
+  if (w->flags & GRE_COMPACT)
+    grlibint_putVarint(w,count);
+  else
+    {
+      fixed=(int)count;
+      grlibint_putBytes(w,&fixed,sizeof(int));
+    }
+}
+
+void grlibint_putAlign(grlibint_writer_t *w)
+{
+  while (w->pos%XS_ALIGN!=0)
+    {
+      if (w->buf!=NULL)
+        w->buf[w->pos]=0;
+      w->pos++;
+    }
+}
+
+
+/*............................................................*/
+/* widths: compact streams store integral values as tagged zig-zag
+   varints and everything else (tag 1) as raw double */
+
+void grlibint_putWidth(grlibint_writer_t *w, graphlib_width_t val)
+{
+  graphlib_width_t back;
+  int64_t          ival;
+
+  if (w->flags & GRE_COMPACT)
+    {
+      if ((val>-XS_MAXINTWIDTH) && (val<XS_MAXINTWIDTH))
+        {
+          ival=(int64_t)val;
+          back=(graphlib_width_t)ival;
+          if (memcmp(&back,&val,sizeof(graphlib_width_t))==0)
+            {
+              grlibint_putVarint(w,(((uint64_t)ival<<1)^
+                                    (uint64_t)(ival>>63))<<1);
+              return;
+            }
+        }
+      grlibint_putVarint(w,1);
+    }
+  grlibint_putBytes(w,&val,sizeof(graphlib_width_t));
+}
+
+
+/*............................................................*/
+/* node ids: delta to the previous id of the same kind in compact
+   streams */
+
+void grlibint_putId(grlibint_writer_t *w, graphlib_node_t id,
+                    graphlib_node_t *prev)
+{
+  if (w->flags & GRE_COMPACT)
+    {
+      grlibint_putInt(w,(int64_t)id-(int64_t)(*prev));
+      *prev=id;
+    }
+  else
+    grlibint_putBytes(w,&id,sizeof(graphlib_node_t));
+}
+
+
+/*............................................................*/
+/* label dictionary: FNV-1a hash of a serialized value */
+
+uint32_t grlibint_dictHash(const char *data, unsigned int len)
+{
+  uint32_t     h=2166136261U;
+  unsigned int i;
+
+  for (i=0;i<len;i++)
+    h=(h^(unsigned char)data[i])*16777619U;
+  return h;
+}
+
+
+/*............................................................*/
+/* label dictionary: double the hash table */
+
+graphlib_error_t grlibint_dictGrow(grlibint_dict_t *dict)
+{
+  uint32_t *hash;
+  uint32_t size,i,h;
+
+  size=(dict->hash_size==0) ? 1024 : dict->hash_size*2;
+  hash=(uint32_t*)calloc(size,sizeof(uint32_t));
+  if (hash==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<dict->num;i++)
+    {
+      h=grlibint_dictHash(dict->heap+dict->pos[i],dict->len[i])&(size-1);
+      while (hash[h]!=0)
+        h=(h+1)&(size-1);
+      hash[h]=i+1;
+    }
+  free(dict->hash);
+  dict->hash=hash;
+  dict->hash_size=size;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* label dictionary: find or add a serialized value, returns its
+   reference in *oref */
+
+graphlib_error_t grlibint_dictAdd(grlibint_dict_t *dict, const char *data,
+                                  unsigned int len, uint32_t *oref)
+{
+  graphlib_error_t err;
+  uint32_t         h,e;
+  void             *p;
+
+  if (len==0)
+    {
+      *oref=0;
+      return GRL_OK;
+    }
+  if ((dict->num+1)*2>dict->hash_size)
+    {
+      err=grlibint_dictGrow(dict);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
+  h=grlibint_dictHash(data,len)&(dict->hash_size-1);
+  while ((e=dict->hash[h])!=0)
+    {
+      if ((dict->len[e-1]==len) &&
+          (memcmp(dict->heap+dict->pos[e-1],data,len)==0))
+        {
+          *oref=e;
+          return GRL_OK;
+        }
+      h=(h+1)&(dict->hash_size-1);
+    }
+
+  if (dict->num==dict->cap)
+    {
+      dict->cap=(dict->cap==0) ? 1024 : dict->cap*2;
+      p=realloc(dict->pos,dict->cap*sizeof(uint64_t));
+      if (p==NULL)
+        return GRL_NOMEM;
+      dict->pos=(uint64_t*)p;
+      p=realloc(dict->len,dict->cap*sizeof(unsigned int));
+      if (p==NULL)
+        return GRL_NOMEM;
+      dict->len=(unsigned int*)p;
+    }
+  if (dict->heap_len+len>dict->heap_cap)
+    {
+      while (dict->heap_len+len>dict->heap_cap)
+        dict->heap_cap=(dict->heap_cap==0) ? 65536 : dict->heap_cap*2;
+      p=realloc(dict->heap,dict->heap_cap);
+      if (p==NULL)
+        return GRL_NOMEM;
+      dict->heap=(char*)p;
+    }
+  memcpy(dict->heap+dict->heap_len,data,len);
+  dict->heap_len+=len;
+
+  dict->pos[dict->num]=dict->heap_len-len;
+  dict->len[dict->num]=len;
+  dict->num++;
+  dict->hash[h]=dict->num;
+  *oref=dict->num;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* label dictionary: serialize the label (j<0) or attribute j of a
+   node or edge and add it */
+
+graphlib_error_t grlibint_dictAddValue(grlibint_dict_t *dict,
+                                       graphlib_graph_p igraph, int is_node,
+                                       int j, void *value, uint32_t *oref)
+{
+  graphlib_functiontable_p f=igraph->functions;
+  unsigned int             len;
+  void                     *p;
+
+  if (is_node)
+    len=(j<0) ? f->serialize_node_length(value) :
+      f->serialize_node_attr_length(igraph->node_attr_keys[j],value);
+  else
+    len=(j<0) ? f->serialize_edge_length(value) :
+      f->serialize_edge_attr_length(igraph->edge_attr_keys[j],value);
+
+  if (len>dict->scratch_cap)
+    {
+      p=realloc(dict->scratch,len);
+      if (p==NULL)
+        return GRL_NOMEM;
+      dict->scratch=(char*)p;
+      dict->scratch_cap=len;
+    }
+  if ((len!=0) && is_node && (j<0))
+    f->serialize_node(dict->scratch,value);
+  else if ((len!=0) && is_node)
+    f->serialize_node_attr(igraph->node_attr_keys[j],dict->scratch,value);
+  else if ((len!=0) && (j<0))
+    f->serialize_edge(dict->scratch,value);
+  else if (len!=0)
+    f->serialize_edge_attr(igraph->edge_attr_keys[j],dict->scratch,value);
+
+  return grlibint_dictAdd(dict,dict->scratch,len,oref);
+}
+
+
+/*............................................................*/
+/* label dictionary: collect the encoded labels and attribute values
+   of all nodes and edges, refs are ordered like the element arrays
+   (the label ref is 0 if labels are not encoded) */
+
+graphlib_error_t grlibint_buildDict(grlibint_dict_t *dict,
+                                    grlibint_writer_t *w,
+                                    graphlib_graph_p igraph,
+                                    int num_nodes, int num_edges)
+{
+  graphlib_error_t err=GRL_OK;
+  uint32_t         *ref;
+  int              i,j,k,labels;
+
+  labels=((w->fields & GRM_LABELS)!=0);
+  dict->node_stride=1+w->num_node_sel;
+  dict->edge_stride=1+w->num_edge_sel;
+  dict->edge_base=num_nodes*dict->node_stride;
+  dict->refs=(uint32_t*)malloc((dict->edge_base+
+                                num_edges*dict->edge_stride+1)*
+                               sizeof(uint32_t));
+  if (dict->refs==NULL)
+    return GRL_NOMEM;
+
+  ref=dict->refs;
+  for (i=0;(i<num_nodes) && GRL_IS_OK(err);i++)
+    {
+      *ref=0;
+      if (labels)
+        err=grlibint_dictAddValue(dict,igraph,1,-1,w->nodes[i]->attr.label,
+                                  ref);
+      ref++;
+      for (j=0;(j<w->num_node_sel) && GRL_IS_OK(err);j++)
+        {
+          k=w->node_sel[j];
+          err=grlibint_dictAddValue(dict,igraph,1,k,
+                                    w->nodes[i]->attr.attr_values[k],ref++);
+        }
+    }
+  for (i=0;(i<num_edges) && GRL_IS_OK(err);i++)
+    {
+      *ref=0;
+      if (labels)
+        err=grlibint_dictAddValue(dict,igraph,0,-1,w->edges[i]->attr.label,
+                                  ref);
+      ref++;
+      for (j=0;(j<w->num_edge_sel) && GRL_IS_OK(err);j++)
+        {
+          k=w->edge_sel[j];
+          err=grlibint_dictAddValue(dict,igraph,0,k,
+                                    w->edges[i]->attr.attr_values[k],ref++);
+        }
+    }
+  return err;
+}
+
+/*............................................................*/
+/* label dictionary: release it */
+
+void grlibint_freeDict(grlibint_dict_t *dict)
+{
+  free(dict->heap);
+  free(dict->pos);
+  free(dict->len);
+  free(dict->hash);
+  free(dict->refs);
+  free(dict->scratch);
+}
+
+
+/*............................................................*/
+/* label dictionary: reference of label (j<0) or the j-th encoded
+   attribute of the i-th node or edge */
+
+uint32_t grlibint_dictRef(grlibint_dict_t *dict, int is_node, uint64_t i,
+                          int j)
+{
+  if (is_node)
+    return dict->refs[i*dict->node_stride+1+j];
+  return dict->refs[dict->edge_base+i*dict->edge_stride+1+j];
+}
+
+
+/*............................................................*/
+/* length prefixed string (keys) */
+
+void grlibint_putKey(grlibint_writer_t *w, const char *str)
+{
+  unsigned int len;
+
+  len=0;
+  if (str!=NULL)
+    len=strlen(str)+1;
+  grlibint_putLength(w,len);
+  if (len>0)
+    grlibint_putBytes(w,str,len);
+}
+
+
+/*............................................................*/
+/* encode the stream header, annotation and attribute keys */
+
+void grlibint_encodeHeader(grlibint_writer_t *w, graphlib_graph_p igraph,
+                           uint64_t num_nodes, uint64_t num_edges)
+{
+  unsigned char xs[XS_HEADERLEN];
+  int           i;
+  uint32_t      e;
+
+  memset(xs,0,XS_HEADERLEN);
+  memcpy(xs,XS_MAGIC,XS_MAGICLEN);
+  xs[XS_MAGICLEN]=XS_VERSION;
+  xs[XS_MAGICLEN+1]=w->flags;
+  if (w->flags & XS_MASK)
+    xs[XS_MAGICLEN+2]=w->fields;
+  grlibint_putBytes(w,xs,XS_HEADERLEN);
+
+  grlibint_putCount(w,num_nodes);
+  grlibint_putCount(w,num_edges);
+
+  if (w->fields & GRM_ANNOTATIONS)
+    {
+      grlibint_putCount(w,igraph->numannotation);
+      for (i=0;i<igraph->numannotation;i++)
+        grlibint_putKey(w,igraph->annotations[i]);
+    }
+
+  /* only the keys of encoded attributes */
+  grlibint_putCount(w,w->num_node_sel);
+  for (i=0;i<w->num_node_sel;i++)
+    grlibint_putKey(w,igraph->node_attr_keys[w->node_sel[i]]);
+  grlibint_putCount(w,w->num_edge_sel);
+  for (i=0;i<w->num_edge_sel;i++)
+    grlibint_putKey(w,igraph->edge_attr_keys[w->edge_sel[i]]);
+
+  /* chunk offsets, known from the sizing pass */
+  if (w->flags & GRE_INDEX)
+    {
+      grlibint_putCount(w,XS_CHUNK);
+      grlibint_putBytes(w,w->index,w->num_chunks*sizeof(uint64_t));
+    }
+
+  /* label dictionary, records refer to its entries */
+  if (w->flags & GRE_DICT)
+    {
+      grlibint_putCount(w,w->dict->num);
+      for (e=0;e<w->dict->num;e++)
+        {
+          grlibint_putLength(w,w->dict->len[e]);
+          grlibint_putBytes(w,w->dict->heap+w->dict->pos[e],w->dict->len[e]);
+        }
+    }
+}
+
+
+/*............................................................*/
+/* start of the n-th node or edge: indexed streams record the offset
+   of every chunk and restart delta coding there, so each chunk can
+   be decoded on its own */
+
+void grlibint_encodeChunk(grlibint_writer_t *w, uint64_t chunk, int is_node)
+{
+  if (w->buf==NULL)
+    w->index[chunk]=w->pos;
+  if (is_node)
+    w->prev_id=0;
+  else
+    w->prev_from=w->prev_to=0;
+}
+
+
+/*............................................................*/
+/* encode one node
+   - label, the selected attributes and the visual fields in w->fields,
+     each only if encoded */
+
+void grlibint_encodeNode(grlibint_writer_t *w, graphlib_graph_p igraph,
+                         graphlib_nodedata_p node)
+{
+  unsigned int len;
+  int          j,k;
+
+  grlibint_putId(w,node->id,&(w->prev_id));
+
+  if (w->dict!=NULL)
+    {
+      j=(w->fields & GRM_LABELS) ? -1 : 0;
+      for (;j<w->num_node_sel;j++)
+        grlibint_putLength(w,grlibint_dictRef(w->dict,1,w->item,j));
+    }
+  else
+    {
+      if (w->fields & GRM_LABELS)
+        {
+          len=igraph->functions->serialize_node_length(node->attr.label);
+          grlibint_putLength(w,len);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->serialize_node(w->buf+w->pos,node->attr.label);
+          w->pos+=len;
+        }
+
+      for (j=0;j<w->num_node_sel;j++)
+        {
+          k=w->node_sel[j];
+          len=igraph->functions->
+            serialize_node_attr_length(igraph->node_attr_keys[k],
+                                       node->attr.attr_values[k]);
+          grlibint_putLength(w,len);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->
+              serialize_node_attr(igraph->node_attr_keys[k],w->buf+w->pos,
+                                  node->attr.attr_values[k]);
+          w->pos+=len;
+        }
+    }
+
+  if (w->fields & GRM_SIZE)
+    {
+      grlibint_putWidth(w,node->attr.width);
+      grlibint_putWidth(w,node->attr.w);
+      grlibint_putWidth(w,node->attr.height);
+    }
+  if (w->fields & GRM_COLOR)
+    grlibint_putInt(w,node->attr.color);
+  if (w->fields & GRM_COORDS)
+    {
+      grlibint_putInt(w,node->attr.x);
+      grlibint_putInt(w,node->attr.y);
+    }
+  if (w->fields & GRM_FONTSIZE)
+    grlibint_putInt(w,node->attr.fontsize);
+}
+
+
+/*............................................................*/
+/* encode one edge, see grlibint_encodeNode */
+
+void grlibint_encodeEdge(grlibint_writer_t *w, graphlib_graph_p igraph,
+                         graphlib_edgedata_p edge)
+{
+  unsigned int len;
+  int          j,k;
+
+  grlibint_putId(w,edge->node_from,&(w->prev_from));
+  grlibint_putId(w,edge->node_to,&(w->prev_to));
+
+  if (w->dict!=NULL)
+    {
+      j=(w->fields & GRM_LABELS) ? -1 : 0;
+      for (;j<w->num_edge_sel;j++)
+        grlibint_putLength(w,grlibint_dictRef(w->dict,0,w->item,j));
+    }
+  else
+    {
+      if (w->fields & GRM_LABELS)
+        {
+          len=igraph->functions->serialize_edge_length(edge->attr.label);
+          grlibint_putLength(w,len);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->serialize_edge(w->buf+w->pos,edge->attr.label);
+          w->pos+=len;
+        }
+
+      for (j=0;j<w->num_edge_sel;j++)
+        {
+          k=w->edge_sel[j];
+          len=igraph->functions->
+            serialize_edge_attr_length(igraph->edge_attr_keys[k],
+                                       edge->attr.attr_values[k]);
+          grlibint_putLength(w,len);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->
+              serialize_edge_attr(igraph->edge_attr_keys[k],w->buf+w->pos,
+                                  edge->attr.attr_values[k]);
+          w->pos+=len;
+        }
+    }
+
+  if (w->fields & GRM_SIZE)
+    grlibint_putWidth(w,edge->attr.width);
+  if (w->fields & GRM_COLOR)
+    grlibint_putInt(w,edge->attr.color);
+  if (w->fields & GRM_STYLE)
+    {
+      grlibint_putInt(w,edge->attr.arcstyle);
+      grlibint_putInt(w,edge->attr.block);
+    }
+  if (w->fields & GRM_FONTSIZE)
+    grlibint_putInt(w,edge->attr.fontsize);
+}
+
+
+/*............................................................*/
+/* encode all nodes of a columnar stream
+   - an aligned block of columns, if there are any nodes: widths, w
+     and heights (GRM_SIZE), then ids, label lengths (GRM_LABELS), one
+     length column per encoded attribute, colors (GRM_COLOR), x and y
+     (GRM_COORDS) and font sizes (GRM_FONTSIZE)
+   - followed by a heap with the label and attributes of each node,
+     which is empty if the lengths are dictionary references */
+
+void grlibint_encodeNodeColumns(grlibint_writer_t *w, graphlib_graph_p igraph,
+                                int num_nodes)
+{
+  graphlib_nodedata_p *nodes=w->nodes;
+  unsigned int        len;
+  int                 i,j,k;
+
+  if (num_nodes==0)
+    return;
+  grlibint_putAlign(w);
+
+  if (w->fields & GRM_SIZE)
+    {
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.width),sizeof(graphlib_width_t));
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.w),sizeof(graphlib_width_t));
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.height),
+                          sizeof(graphlib_width_t));
+    }
+
+  for (i=0;i<num_nodes;i++)
+    grlibint_putBytes(w,&(nodes[i]->id),sizeof(graphlib_node_t));
+  j=(w->fields & GRM_LABELS) ? -1 : 0;
+  for (;j<w->num_node_sel;j++)
+    {
+      k=(j<0) ? -1 : w->node_sel[j];
+      for (i=0;i<num_nodes;i++)
+        {
+          if (w->dict!=NULL)
+            len=grlibint_dictRef(w->dict,1,i,j);
+          else if (k<0)
+            len=igraph->functions->serialize_node_length(nodes[i]->attr.label);
+          else
+            len=igraph->functions->
+              serialize_node_attr_length(igraph->node_attr_keys[k],
+                                         nodes[i]->attr.attr_values[k]);
+          grlibint_putBytes(w,&len,sizeof(unsigned int));
+        }
+    }
+
+  if (w->fields & GRM_COLOR)
+    {
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.color),sizeof(graphlib_color_t));
+    }
+  if (w->fields & GRM_COORDS)
+    {
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.x),sizeof(graphlib_coor_t));
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.y),sizeof(graphlib_coor_t));
+    }
+  if (w->fields & GRM_FONTSIZE)
+    {
+      for (i=0;i<num_nodes;i++)
+        grlibint_putBytes(w,&(nodes[i]->attr.fontsize),
+                          sizeof(graphlib_fontsize_t));
+    }
+
+  for (i=0;(i<num_nodes) && (w->dict==NULL);i++)
+    {
+      if (w->fields & GRM_LABELS)
+        {
+          len=igraph->functions->serialize_node_length(nodes[i]->attr.label);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->serialize_node(w->buf+w->pos,
+                                              nodes[i]->attr.label);
+          w->pos+=len;
+        }
+
+      for (j=0;j<w->num_node_sel;j++)
+        {
+          k=w->node_sel[j];
+          len=igraph->functions->
+            serialize_node_attr_length(igraph->node_attr_keys[k],
+                                       nodes[i]->attr.attr_values[k]);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->
+              serialize_node_attr(igraph->node_attr_keys[k],w->buf+w->pos,
+                                  nodes[i]->attr.attr_values[k]);
+          w->pos+=len;
+        }
+    }
+}
+
+
+/*............................................................*/
+/* encode all edges of a columnar stream
+   - an aligned block of columns, if there are any edges: widths
+     (GRM_SIZE), then sources, targets, label lengths (GRM_LABELS),
+     one length column per encoded attribute, colors (GRM_COLOR), arc
+     styles and blocks (GRM_STYLE) and font sizes (GRM_FONTSIZE)
+   - followed by a heap with the label and attributes of each edge,
+     which is empty if the lengths are dictionary references */
+
+void grlibint_encodeEdgeColumns(grlibint_writer_t *w, graphlib_graph_p igraph,
+                                int num_edges)
+{
+  graphlib_edgedata_p *edges=w->edges;
+  unsigned int        len;
+  int                 i,j,k;
+
+  if (num_edges==0)
+    return;
+  grlibint_putAlign(w);
+
+  if (w->fields & GRM_SIZE)
+    {
+      for (i=0;i<num_edges;i++)
+        grlibint_putBytes(w,&(edges[i]->attr.width),sizeof(graphlib_width_t));
+    }
+
+  for (i=0;i<num_edges;i++)
+    grlibint_putBytes(w,&(edges[i]->node_from),sizeof(graphlib_node_t));
+  for (i=0;i<num_edges;i++)
+    grlibint_putBytes(w,&(edges[i]->node_to),sizeof(graphlib_node_t));
+  j=(w->fields & GRM_LABELS) ? -1 : 0;
+  for (;j<w->num_edge_sel;j++)
+    {
+      k=(j<0) ? -1 : w->edge_sel[j];
+      for (i=0;i<num_edges;i++)
+        {
+          if (w->dict!=NULL)
+            len=grlibint_dictRef(w->dict,0,i,j);
+          else if (k<0)
+            len=igraph->functions->serialize_edge_length(edges[i]->attr.label);
+          else
+            len=igraph->functions->
+              serialize_edge_attr_length(igraph->edge_attr_keys[k],
+                                         edges[i]->attr.attr_values[k]);
+          grlibint_putBytes(w,&len,sizeof(unsigned int));
+        }
+    }
+
+  if (w->fields & GRM_COLOR)
+    {
+      for (i=0;i<num_edges;i++)
+        grlibint_putBytes(w,&(edges[i]->attr.color),sizeof(graphlib_color_t));
+    }
+  if (w->fields & GRM_STYLE)
+    {
+      for (i=0;i<num_edges;i++)
+        grlibint_putBytes(w,&(edges[i]->attr.arcstyle),sizeof(graphlib_arc_t));
+      for (i=0;i<num_edges;i++)
+        grlibint_putBytes(w,&(edges[i]->attr.block),sizeof(graphlib_block_t));
+    }
+  if (w->fields & GRM_FONTSIZE)
+    {
+      for (i=0;i<num_edges;i++)
+        grlibint_putBytes(w,&(edges[i]->attr.fontsize),
+                          sizeof(graphlib_fontsize_t));
+    }
+
+  for (i=0;(i<num_edges) && (w->dict==NULL);i++)
+    {
+      if (w->fields & GRM_LABELS)
+        {
+          len=igraph->functions->serialize_edge_length(edges[i]->attr.label);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->serialize_edge(w->buf+w->pos,
+                                              edges[i]->attr.label);
+          w->pos+=len;
+        }
+
+      for (j=0;j<w->num_edge_sel;j++)
+        {
+          k=w->edge_sel[j];
+          len=igraph->functions->
+            serialize_edge_attr_length(igraph->edge_attr_keys[k],
+                                       edges[i]->attr.attr_values[k]);
+          if ((len!=0) && (w->buf!=NULL))
+            igraph->functions->
+              serialize_edge_attr(igraph->edge_attr_keys[k],w->buf+w->pos,
+                                  edges[i]->attr.attr_values[k]);
+          w->pos+=len;
+        }
+    }
+}
+
+
+/*............................................................*/
+/* collect the nodes and edges of a graph for columnar encoding */
+
+graphlib_error_t grlibint_collectElements(grlibint_writer_t *w,
+                                          graphlib_graph_p igraph,
+                                          int num_nodes, int num_edges)
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  int                     i,n;
+
+  w->nodes=(graphlib_nodedata_p*)malloc((num_nodes+1)*
+                                        sizeof(graphlib_nodedata_p));
+  w->edges=(graphlib_edgedata_p*)malloc((num_edges+1)*
+                                        sizeof(graphlib_edgedata_p));
+  if ((w->nodes==NULL) || (w->edges==NULL))
+    return GRL_NOMEM;
+
+  n=0;
+  for (nodefrag=igraph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (nodefrag->node[i].full)
+            w->nodes[n++]=&(nodefrag->node[i].entry.data);
+        }
+    }
+  n=0;
+  for (edgefrag=igraph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (edgefrag->edge[i].full)
+            w->edges[n++]=&(edgefrag->edge[i].entry.data);
+        }
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* encode a complete graph as extended stream */
+
+void grlibint_encodeGraph(grlibint_writer_t *w, graphlib_graph_p igraph)
+{
+  int                     i,num_nodes,num_edges;
+  uint64_t                n,node_chunks;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+
+  graphlib_nodeCount(igraph,&num_nodes);
+  graphlib_edgeCount(igraph,&num_edges);
+  node_chunks=(num_nodes+XS_CHUNK-1)/XS_CHUNK;
+
+  grlibint_encodeHeader(w,igraph,num_nodes,num_edges);
+
+  if (w->flags & GRE_COLUMNAR)
+    {
+      grlibint_encodeNodeColumns(w,igraph,num_nodes);
+      grlibint_encodeEdgeColumns(w,igraph,num_edges);
+      return;
+    }
+
+  n=0;
+  nodefrag=igraph->nodes;
+  while (nodefrag!=NULL)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (nodefrag->node[i].full)
+            {
+              if ((w->flags & GRE_INDEX) && (n%XS_CHUNK==0))
+                grlibint_encodeChunk(w,n/XS_CHUNK,1);
+              w->item=n;
+              grlibint_encodeNode(w,igraph,&(nodefrag->node[i].entry.data));
+              n++;
+            }
+        }
+      nodefrag=nodefrag->next;
+    }
+
+  n=0;
+  edgefrag=igraph->edges;
+  while (edgefrag!=NULL)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (edgefrag->edge[i].full)
+            {
+              if ((w->flags & GRE_INDEX) && (n%XS_CHUNK==0))
+                grlibint_encodeChunk(w,node_chunks+n/XS_CHUNK,0);
+              w->item=n;
+              grlibint_encodeEdge(w,igraph,&(edgefrag->edge[i].entry.data));
+              n++;
+            }
+        }
+      edgefrag=edgefrag->next;
+    }
+}
+
+
+/*............................................................*/
+/* indices of the attributes named in the NULL terminated list keys,
+   or of all attributes if keys is NULL
+   - GRL_NOATTRIBUTE if a key is not an attribute of the graph */
+
+graphlib_error_t grlibint_selectAttrs(char **keys, char **attr_keys,
+                                      int num_attrs, int **osel,
+                                      int *onum_sel)
+{
+  int i,j,n;
+
+  n=num_attrs;
+  if (keys!=NULL)
+    {
+      for (n=0;keys[n]!=NULL;n++);
+    }
+  *osel=(int*)malloc((n+1)*sizeof(int));
+  if (*osel==NULL)
+    return GRL_NOMEM;
+  *onum_sel=n;
+
+  for (i=0;i<n;i++)
+    {
+      j=i;
+      if (keys!=NULL)
+        {
+          for (j=0;j<num_attrs;j++)
+            {
+              if ((attr_keys[j]!=NULL) && (strcmp(attr_keys[j],keys[i])==0))
+                break;
+            }
+          if (j==num_attrs)
+            return GRL_NOATTRIBUTE;
+        }
+      (*osel)[i]=j;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* serialize the given fields of a graph with the given encoding
+   - without encoding flags, for all or basic fields of all
+     attributes, this is the plain version 1 stream
+   - other field selections are recorded in an extended stream
+   - GRE_COMPRESS wraps the result of the other encodings into a
+     compressed frame
+   - columnar streams are not split into chunks, GRE_INDEX is
+     dropped for them
+   - GRE_DICT collects the distinct labels and attribute values
+     before either pass */
+
+graphlib_error_t grlibint_serializeGraphEncoded(graphlib_graph_p igraph,
+                                                int encoding, int fields,
+                                                char **node_keys,
+                                                char **edge_keys,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len)
+{
+  grlibint_writer_t w;
+  grlibint_dict_t   dict;
+  uint64_t          len;
+  graphlib_error_t  err;
+  char              *raw;
+  int               num_nodes,num_edges;
+
+  if (encoding & GRE_COMPRESS)
+    {
+      err=grlibint_serializeGraphEncoded(igraph,encoding & ~GRE_COMPRESS,
+                                         fields,node_keys,edge_keys,
+                                         &raw,&len);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      err=grlibint_compressFrame(raw,len,obyte_array,obyte_array_len);
+      free(raw);
+      return err;
+    }
+  if ((encoding==GRE_DEFAULT) && (node_keys==NULL) && (edge_keys==NULL) &&
+      ((fields==GRM_ALL) || (fields==GRM_BASIC)))
+    return grlibint_serializeGraph(igraph,obyte_array,obyte_array_len,
+                                   fields==GRM_ALL);
+  if ((encoding & ~XS_ENCODINGS) || (fields & ~GRM_ALL))
+    return GRL_INVALID;
+  if (encoding & GRE_COLUMNAR)
+    encoding&=~GRE_INDEX;
+
+  memset(&w,0,sizeof(grlibint_writer_t));
+  w.flags=encoding;
+  w.fields=fields;
+  if (fields==GRM_ALL)
+    w.flags|=XS_FULL;
+  else if (fields!=GRM_BASIC)
+    w.flags|=XS_MASK;
+  err=GRL_OK;
+  if (fields & GRM_ATTRS)
+    {
+      err=grlibint_selectAttrs(node_keys,igraph->node_attr_keys,
+                               igraph->num_node_attrs,&(w.node_sel),
+                               &(w.num_node_sel));
+      if (GRL_IS_OK(err))
+        err=grlibint_selectAttrs(edge_keys,igraph->edge_attr_keys,
+                                 igraph->num_edge_attrs,&(w.edge_sel),
+                                 &(w.num_edge_sel));
+    }
+  graphlib_nodeCount(igraph,&num_nodes);
+  graphlib_edgeCount(igraph,&num_edges);
+  if (GRL_IS_OK(err) && (encoding & GRE_INDEX))
+    {
+      w.num_chunks=(num_nodes+XS_CHUNK-1)/XS_CHUNK+
+        (num_edges+XS_CHUNK-1)/XS_CHUNK;
+      w.index=(uint64_t*)malloc((w.num_chunks+1)*sizeof(uint64_t));
+      if (w.index==NULL)
+        err=GRL_NOMEM;
+    }
+  memset(&dict,0,sizeof(grlibint_dict_t));
+  if (GRL_IS_OK(err) && (encoding & (GRE_COLUMNAR|GRE_DICT)))
+    {
+      err=grlibint_collectElements(&w,igraph,num_nodes,num_edges);
+      if (GRL_IS_OK(err) && (encoding & GRE_DICT))
+        {
+          w.dict=&dict;
+          err=grlibint_buildDict(&dict,&w,igraph,num_nodes,num_edges);
+        }
+    }
+  if (GRL_IS_OK(err))
+    {
+      grlibint_encodeGraph(&w,igraph);
+      len=w.pos;
+
+      w.buf=(char*)malloc(len);
+      if (w.buf!=NULL)
+        {
+          w.pos=0;
+          w.prev_id=w.prev_from=w.prev_to=0;
+          grlibint_encodeGraph(&w,igraph);
+          assert(w.pos==len);
+        }
+      else
+        err=GRL_NOMEM;
+    }
+  free(w.node_sel);
+  free(w.edge_sel);
+  free(w.index);
+  free(w.nodes);
+  free(w.edges);
+  grlibint_freeDict(&dict);
+  if (GRL_IS_NOTOK(err))
+    return err;
+
+  *obyte_array=w.buf;
+  *obyte_array_len=len;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* scatter/gather serialization state
+   - with iov==NULL only the required sizes are counted */
+
+typedef struct grlibint_iovbuild_d
+{
+  struct iovec *iov;
+  char         *scratch;
+  int          niov;
+  uint64_t     nscratch;
+  uint64_t     total;
+  int          last_scratch;
+} grlibint_iovbuild_t;
+
+
+/*............................................................*/
+/* reserve len bytes in the scratch area, merging with the previous
+   iovec entry if that one ends there
+   - returns NULL when only counting */
+
+char *grlibint_iovReserve(grlibint_iovbuild_t *state, uint64_t len)
+{
+  char *dst=NULL;
+
+  if (len==0)
+    return NULL;
+
+  if (state->iov!=NULL)
+    {
+      dst=state->scratch+state->nscratch;
+      if (state->last_scratch)
+        state->iov[state->niov-1].iov_len+=len;
+      else
+        {
+          state->iov[state->niov].iov_base=dst;
+          state->iov[state->niov].iov_len=len;
+        }
+    }
+  if (!state->last_scratch)
+    state->niov++;
+  state->last_scratch=1;
+  state->nscratch+=len;
+  state->total+=len;
+
+  return dst;
+}
+
+
+/*............................................................*/
+/* copy len bytes into the scratch area */
+
+void grlibint_iovCopy(grlibint_iovbuild_t *state, const void *src,
+                      uint64_t len)
+{
+  char *dst;
+
+  dst=grlibint_iovReserve(state,len);
+  if (dst!=NULL)
+    memcpy(dst,src,len);
+}
+
+
+/*............................................................*/
+/* reference len bytes in place */
+
+void grlibint_iovRef(grlibint_iovbuild_t *state, const void *src,
+                     uint64_t len)
+{
+  if (state->iov!=NULL)
+    {
+      state->iov[state->niov].iov_base=(void*)src;
+      state->iov[state->niov].iov_len=len;
+    }
+  state->niov++;
+  state->last_scratch=0;
+  state->total+=len;
+}
+
+
+/*............................................................*/
+/* add one serialized label: labels using the default character array
+   routines are already in serialized form and can be referenced in
+   place, all others are serialized into the scratch area */
+
+void grlibint_iovLabel(grlibint_iovbuild_t *state, const char *key,
+                       const void *label, unsigned int label_len,
+                       void (*serialize)(char *, const void *),
+                       void (*serialize_attr)(const char *, char *,
+                                              const void *))
+{
+  char *dst;
+
+  if (label_len==0)
+    return;
+
+  if ((label_len>=IOV_MINREF) &&
+      (((serialize!=NULL) && (serialize==grlibint_serialize_node)) ||
+       ((serialize_attr!=NULL) &&
+        (serialize_attr==grlibint_serialize_node_attr))))
+    {
+      grlibint_iovRef(state,label,label_len);
+    }
+  else
+    {
+      dst=grlibint_iovReserve(state,label_len);
+      if (dst!=NULL)
+        {
+          if (serialize!=NULL)
+            serialize(dst,label);
+          else
+            serialize_attr(key,dst,label);
+        }
+    }
+}
+
+
+/*............................................................*/
+/* build (or count) the scatter/gather list for a graph */
+
+void grlibint_iovBuild(graphlib_graph_p igraph, int full_graph,
+                       grlibint_iovbuild_t *state)
+{
+  int                     i,j,num_nodes,num_edges;
+  unsigned int            label_len;
+  char                    *dst;
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  graphlib_nodedata_p     node;
+  graphlib_edgedata_p     edge;
+  graphlib_functiontable_p fct=igraph->functions;
+
+  graphlib_nodeCount(igraph,&num_nodes);
+  graphlib_edgeCount(igraph,&num_edges);
+
+  /* header */
+  dst=grlibint_iovReserve(state,grlibint_serialHeaderLength(igraph,
+                                                            full_graph));
+  if (dst!=NULL)
+    grlibint_serializeHeaderToBuf(igraph,num_nodes,num_edges,full_graph,dst);
+
+  /* nodes */
+  nodefrag=igraph->nodes;
+  while (nodefrag!=NULL)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (nodefrag->node[i].full)
+            {
+              node=&(nodefrag->node[i].entry.data);
+
+              grlibint_iovCopy(state,&(node->id),sizeof(graphlib_node_t));
+              label_len=fct->serialize_node_length(node->attr.label);
+              grlibint_iovCopy(state,&label_len,sizeof(unsigned int));
+              grlibint_iovLabel(state,NULL,node->attr.label,label_len,
+                                fct->serialize_node,NULL);
+
+              for (j=0;j<igraph->num_node_attrs;j++)
+                {
+                  label_len=fct->
+                    serialize_node_attr_length(igraph->node_attr_keys[j],
+                                               node->attr.attr_values[j]);
+                  grlibint_iovCopy(state,&label_len,sizeof(unsigned int));
+                  grlibint_iovLabel(state,igraph->node_attr_keys[j],
+                                    node->attr.attr_values[j],label_len,
+                                    NULL,fct->serialize_node_attr);
+                }
+
+              if (full_graph==1)
+                {
+                  dst=grlibint_iovReserve(state,3*sizeof(graphlib_width_t)+
+                                          sizeof(graphlib_color_t)+
+                                          2*sizeof(graphlib_coor_t)+
+                                          sizeof(graphlib_fontsize_t));
+                  if (dst!=NULL)
+                    {
+                      dst=grlibint_putData(dst,&(node->attr.width),
+                                           sizeof(graphlib_width_t));
+                      dst=grlibint_putData(dst,&(node->attr.w),
+                                           sizeof(graphlib_width_t));
+                      dst=grlibint_putData(dst,&(node->attr.height),
+                                           sizeof(graphlib_width_t));
+                      dst=grlibint_putData(dst,&(node->attr.color),
+                                           sizeof(graphlib_color_t));
+                      dst=grlibint_putData(dst,&(node->attr.x),
+                                           sizeof(graphlib_coor_t));
+                      dst=grlibint_putData(dst,&(node->attr.y),
+                                           sizeof(graphlib_coor_t));
+                      dst=grlibint_putData(dst,&(node->attr.fontsize),
+                                           sizeof(graphlib_fontsize_t));
+                    }
+                }
+            }
+        }
+      nodefrag=nodefrag->next;
+    }
+
+  /* edges */
+  edgefrag=igraph->edges;
+  while (edgefrag!=NULL)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (edgefrag->edge[i].full)
+            {
+              edge=&(edgefrag->edge[i].entry.data);
+
+              grlibint_iovCopy(state,&(edge->node_from),
+                               sizeof(graphlib_node_t));
+              grlibint_iovCopy(state,&(edge->node_to),
+                               sizeof(graphlib_node_t));
+              label_len=fct->serialize_edge_length(edge->attr.label);
+              grlibint_iovCopy(state,&label_len,sizeof(unsigned int));
+              grlibint_iovLabel(state,NULL,edge->attr.label,label_len,
+                                fct->serialize_edge,NULL);
+
+              for (j=0;j<igraph->num_edge_attrs;j++)
+                {
+                  label_len=fct->
+                    serialize_edge_attr_length(igraph->edge_attr_keys[j],
+                                               edge->attr.attr_values[j]);
+                  grlibint_iovCopy(state,&label_len,sizeof(unsigned int));
+                  grlibint_iovLabel(state,igraph->edge_attr_keys[j],
+                                    edge->attr.attr_values[j],label_len,
+                                    NULL,fct->serialize_edge_attr);
+                }
+
+              if (full_graph==1)
+                {
+                  dst=grlibint_iovReserve(state,sizeof(graphlib_width_t)+
+                                          sizeof(graphlib_color_t)+
+                                          sizeof(graphlib_arc_t)+
+                                          sizeof(graphlib_block_t)+
+                                          sizeof(graphlib_fontsize_t));
+                  if (dst!=NULL)
+                    {
+                      dst=grlibint_putData(dst,&(edge->attr.width),
+                                           sizeof(graphlib_width_t));
+                      dst=grlibint_putData(dst,&(edge->attr.color),
+                                           sizeof(graphlib_color_t));
+                      dst=grlibint_putData(dst,&(edge->attr.arcstyle),
+                                           sizeof(graphlib_arc_t));
+                      dst=grlibint_putData(dst,&(edge->attr.block),
+                                           sizeof(graphlib_block_t));
+                      dst=grlibint_putData(dst,&(edge->attr.fontsize),
+                                           sizeof(graphlib_fontsize_t));
+                    }
+                }
+            }
+        }
+      edgefrag=edgefrag->next;
+    }
+}
+
+
+/*............................................................*/
+/* serialize a graph into a scatter/gather list
+   - the iovec array and the scratch area holding all fixed layout
+     data are allocated in one block, so one free() releases both */
+
+graphlib_error_t grlibint_serializeGraphIov(graphlib_graph_p igraph,
+                                            struct iovec **oiov,
+                                            int *oiovcnt,
+                                            uint64_t *obyte_array_len,
+                                            int full_graph)
+{
+  grlibint_iovbuild_t state;
+  int                 niov;
+
+  memset(&state,0,sizeof(grlibint_iovbuild_t));
+  grlibint_iovBuild(igraph,full_graph,&state);
+
+  niov=state.niov;
+  state.iov=(struct iovec*)malloc(niov*sizeof(struct iovec)+state.nscratch);
+  if (state.iov==NULL)
+    return GRL_NOMEM;
+  state.scratch=(char*)(state.iov+niov);
+  state.niov=0;
+  state.nscratch=0;
+  state.total=0;
+  state.last_scratch=0;
+  grlibint_iovBuild(igraph,full_graph,&state);
+  assert(state.niov==niov);
+
+  *oiov=state.iov;
+  *oiovcnt=state.niov;
+  *obyte_array_len=state.total;
+  return GRL_OK;
+}
+
+
+graphlib_error_t graphlib_serializeGraph(graphlib_graph_p igraph,
+                                         char **obyte_array,
+                                         uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraph(igraph, obyte_array, obyte_array_len, 1);
+}
+
+graphlib_error_t graphlib_serializeBasicGraph(graphlib_graph_p igraph,
+                                              char **obyte_array,
+                                              uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraph(igraph, obyte_array, obyte_array_len, 0);
+}
+
+graphlib_error_t graphlib_serializeGraphParallel(graphlib_graph_p igraph,
+                                                 int nthreads,
+                                                 char **obyte_array,
+                                                 uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphParallel(igraph, nthreads, obyte_array,
+                                         obyte_array_len, 1);
+}
+
+graphlib_error_t graphlib_serializeBasicGraphParallel(graphlib_graph_p igraph,
+                                                      int nthreads,
+                                                      char **obyte_array,
+                                                      uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphParallel(igraph, nthreads, obyte_array,
+                                         obyte_array_len, 0);
+}
+
+graphlib_error_t graphlib_serializeGraphEncoded(graphlib_graph_p igraph,
+                                                int encoding,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphEncoded(igraph, encoding,
+                                        GRM_ALL, NULL, NULL,
+                                        obyte_array, obyte_array_len);
+}
+
+graphlib_error_t graphlib_serializeBasicGraphEncoded(graphlib_graph_p igraph,
+                                                     int encoding,
+                                                     char **obyte_array,
+                                                     uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphEncoded(igraph, encoding,
+                                        GRM_BASIC, NULL, NULL,
+                                        obyte_array, obyte_array_len);
+}
+
+graphlib_error_t graphlib_serializeGraphMask(graphlib_graph_p igraph,
+                                             int encoding, int mask,
+                                             char **node_keys,
+                                             char **edge_keys,
+                                             char **obyte_array,
+                                             uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphEncoded(igraph, encoding, mask, node_keys,
+                                        edge_keys, obyte_array,
+                                        obyte_array_len);
+}
+
+graphlib_error_t graphlib_serializeGraphIov(graphlib_graph_p igraph,
+                                            struct iovec **oiov,
+                                            int *oiovcnt,
+                                            uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphIov(igraph, oiov, oiovcnt, obyte_array_len, 1);
+}
+
+graphlib_error_t graphlib_serializeBasicGraphIov(graphlib_graph_p igraph,
+                                                 struct iovec **oiov,
+                                                 int *oiovcnt,
+                                                 uint64_t *obyte_array_len)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphIov(igraph, oiov, oiovcnt, obyte_array_len, 0);
+}
+
+graphlib_error_t graphlib_serializedGraphLength(graphlib_graph_p igraph,
+                                                uint64_t *olen)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  *olen=grlibint_serialGraphLength(igraph,1);
+  return GRL_OK;
+}
+
+graphlib_error_t graphlib_serializedBasicGraphLength(graphlib_graph_p igraph,
+                                                     uint64_t *olen)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  *olen=grlibint_serialGraphLength(igraph,0);
+  return GRL_OK;
+}
+
+graphlib_error_t graphlib_serializeGraphInto(graphlib_graph_p igraph,
+                                             char *obyte_array,
+                                             uint64_t obyte_array_len,
+                                             uint64_t *oused)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphInto(igraph, obyte_array, obyte_array_len,
+                                     oused, 1);
+}
+
+graphlib_error_t graphlib_serializeBasicGraphInto(graphlib_graph_p igraph,
+                                                  char *obyte_array,
+                                                  uint64_t obyte_array_len,
+                                                  uint64_t *oused)
+{
+  graphlib_error_t err;
+
+  err=grlibint_lazyLoadAll(igraph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return grlibint_serializeGraphInto(igraph, obyte_array, obyte_array_len,
+                                     oused, 0);
+}
+
+/*............................................................*/
+/* stream reader, used for version 1 and extended streams
+   - running out of data yields GRL_MEMORYERROR */
+
+typedef struct grlibint_dictentry_d
+{
+  uint64_t     pos;
+  unsigned int len;
+} grlibint_dictentry_t;
+
+typedef struct grlibint_reader_d
+{
+  const char           *buf;
+  uint64_t             len;
+  uint64_t             pos;
+  int                  flags;
+  int                  fields;       /* GRM_ fields in the stream */
+  graphlib_node_t      prev_id,prev_from,prev_to;
+  int                  chunk;
+  uint64_t             index_pos;
+  int                  borrow;
+  int                  num_nodes,num_edges;
+  uint64_t             col_pos;      /* column block of a columnar stream */
+  uint64_t             col_num;
+  int                  col_doubles;
+  uint64_t             col_item;
+  grlibint_dictentry_t *dict;        /* label dictionary, owned by caller */
+  int                  dict_num;
+} grlibint_reader_t;
+
+
+/*............................................................*/
+/* basic decoders, counterparts of the grlibint_put* routines */
+
+graphlib_error_t grlibint_getBytes(grlibint_reader_t *r, const char **odata,
+                                   uint64_t len)
+{
+  if (len>r->len-r->pos)
+    return GRL_MEMORYERROR;
+  *odata=r->buf+r->pos;
+  r->pos+=len;
+  return GRL_OK;
+}
+
+graphlib_error_t grlibint_getData(grlibint_reader_t *r, void *dst,
+                                  uint64_t len)
+{
+  if (len>r->len-r->pos)
+    return GRL_MEMORYERROR;
+  memcpy(dst,r->buf+r->pos,len);
+  r->pos+=len;
+  return GRL_OK;
+}
+
+graphlib_error_t grlibint_getVarint(grlibint_reader_t *r, uint64_t *oval)
+{
+  uint64_t      val;
+  unsigned char byte;
+  int           shift;
+
+  val=0;
+  for (shift=0;shift<64;shift+=7)
+    {
+      if (r->pos>=r->len)
+        return GRL_MEMORYERROR;
+      byte=r->buf[r->pos++];
+      val|=(uint64_t)(byte&0x7f)<<shift;
+      if ((byte&0x80)==0)
+        {
+          *oval=val;
+          return GRL_OK;
+        }
+    }
+  return GRL_UNKNOWNFORMAT;
+}
+
+graphlib_error_t grlibint_getInt(grlibint_reader_t *r, int64_t *oval)
+{
+  graphlib_error_t err;
+  uint64_t         val;
+  int              fixed;
+
+  if (r->flags & GRE_COMPACT)
+    {
+      err=grlibint_getVarint(r,&val);
+      *oval=(int64_t)(val>>1)^-(int64_t)(val&1);
+    }
+  else
+    {
+      err=grlibint_getData(r,&fixed,sizeof(int));
+      *oval=fixed;
+    }
+  return err;
+}
+
+graphlib_error_t grlibint_getInt32(grlibint_reader_t *r, int *oval)
+{
+  graphlib_error_t err;
+  int64_t          val;
+
+  err=grlibint_getInt(r,&val);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if ((val<INT_MIN) || (val>INT_MAX))
+    return GRL_UNKNOWNFORMAT;
+  *oval=(int)val;
+  return GRL_OK;
+}
+
+graphlib_error_t grlibint_getLength(grlibint_reader_t *r, unsigned int *olen)
+{
+  graphlib_error_t err;
+  uint64_t         val;
+
+  if (r->flags & GRE_COMPACT)
+    {
+      err=grlibint_getVarint(r,&val);
+      if (GRL_IS_OK(err) && (val>UINT_MAX))
+        err=GRL_UNKNOWNFORMAT;
+      *olen=(unsigned int)val;
+      return err;
+    }
+  return grlibint_getData(r,olen,sizeof(unsigned int));
+}
+
+graphlib_error_t grlibint_getCount(grlibint_reader_t *r, int *ocount)
+{
+  graphlib_error_t err;
+  uint64_t         val;
+
+  if (r->flags & GRE_COMPACT)
+    {
+      err=grlibint_getVarint(r,&val);
+      if (GRL_IS_OK(err) && (val>INT_MAX))
+        err=GRL_UNKNOWNFORMAT;
+      if (GRL_IS_OK(err))
+        *ocount=(int)val;
+      return err;
+    }
+  err=grlibint_getData(r,ocount,sizeof(int));
+  if (GRL_IS_OK(err) && (*ocount<0))
+    err=GRL_UNKNOWNFORMAT;
+  return err;
+}
+
+graphlib_error_t grlibint_getWidth(grlibint_reader_t *r,
+                                   graphlib_width_t *oval)
+{
+  graphlib_error_t err;
+  uint64_t         val;
+
+  if (r->flags & GRE_COMPACT)
+    {
+      err=grlibint_getVarint(r,&val);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      if ((val&1)==0)
+        {
+          val>>=1;
+          *oval=(graphlib_width_t)((int64_t)(val>>1)^-(int64_t)(val&1));
+          return GRL_OK;
+        }
+    }
+  return grlibint_getData(r,oval,sizeof(graphlib_width_t));
+}
+
+graphlib_error_t grlibint_getId(grlibint_reader_t *r, graphlib_node_t *oid,
+                                graphlib_node_t *prev)
+{
+  graphlib_error_t err;
+  int64_t          delta;
+
+  if (r->flags & GRE_COMPACT)
+    {
+      err=grlibint_getInt(r,&delta);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      delta+=*prev;
+      if ((delta<INT_MIN) || (delta>INT_MAX))
+        return GRL_UNKNOWNFORMAT;
+      *oid=(graphlib_node_t)delta;
+      *prev=*oid;
+      return GRL_OK;
+    }
+  return grlibint_getData(r,oid,sizeof(graphlib_node_t));
+}
+
+
+/*............................................................*/
+/* read a key array (count followed by length prefixed strings) */
+
+graphlib_error_t grlibint_getKeys(grlibint_reader_t *r, int *onum,
+                                  char ***okeys)
+{
+  graphlib_error_t err;
+  const char       *data;
+  unsigned int     len;
+  int              i;
+
+  err=grlibint_getCount(r,onum);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if (*onum==0)
+    return GRL_OK;
+
+  *okeys=(char**)calloc(*onum,sizeof(char*));
+  if (*okeys==NULL)
+    {
+      *onum=0;
+      return GRL_NOMEM;
+    }
+  for (i=0;i<*onum;i++)
+    {
+      err=grlibint_getLength(r,&len);
+      if (GRL_IS_OK(err))
+        err=grlibint_getBytes(r,&data,len);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      if (len>0)
+        {
+          (*okeys)[i]=(char*)malloc(len);
+          if ((*okeys)[i]==NULL)
+            return GRL_NOMEM;
+          memcpy((*okeys)[i],data,len);
+        }
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* chunk size and offset index of an indexed stream
+   - the offsets stay in the buffer, grlibint_getChunkOffset reads
+     them */
+
+graphlib_error_t grlibint_getIndex(grlibint_reader_t *r, int num_nodes,
+                                   int num_edges)
+{
+  graphlib_error_t err;
+  const char       *data;
+  uint64_t         num_chunks;
+
+  err=grlibint_getCount(r,&(r->chunk));
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if (r->chunk<=0)
+    return GRL_UNKNOWNFORMAT;
+  num_chunks=((uint64_t)num_nodes+r->chunk-1)/r->chunk+
+    ((uint64_t)num_edges+r->chunk-1)/r->chunk;
+  r->index_pos=r->pos;
+  return grlibint_getBytes(r,&data,num_chunks*sizeof(uint64_t));
+}
+
+uint64_t grlibint_getChunkOffset(grlibint_reader_t *r, uint64_t chunk)
+{
+  uint64_t off;
+
+  memcpy(&off,r->buf+r->index_pos+chunk*sizeof(uint64_t),sizeof(uint64_t));
+  return off;
+}
+
+
+/*............................................................*/
+/* label dictionary of a GRE_DICT stream
+   - only the position of each entry is recorded, the values stay in
+     the buffer */
+
+graphlib_error_t grlibint_getDict(grlibint_reader_t *r)
+{
+  graphlib_error_t err;
+  const char       *data;
+  int              i;
+
+  err=grlibint_getCount(r,&(r->dict_num));
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if ((r->dict_num<0) || ((uint64_t)r->dict_num>r->len-r->pos))
+    return GRL_MEMORYERROR;
+  r->dict=(grlibint_dictentry_t*)malloc((r->dict_num+1)*
+                                        sizeof(grlibint_dictentry_t));
+  if (r->dict==NULL)
+    return GRL_NOMEM;
+
+  for (i=0;i<r->dict_num;i++)
+    {
+      err=grlibint_getLength(r,&(r->dict[i].len));
+      if (GRL_IS_OK(err))
+        {
+          r->dict[i].pos=r->pos;
+          err=grlibint_getBytes(r,&data,r->dict[i].len);
+        }
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* decode the stream header into a new graph
+   - an extended stream header, if present, has been consumed and
+     sets the reader flags */
+
+graphlib_error_t grlibint_decodeHeader(grlibint_reader_t *r,
+                                       graphlib_graph_p graph,
+                                       int *onum_nodes, int *onum_edges)
+{
+  graphlib_error_t err;
+
+  err=grlibint_getCount(r,onum_nodes);
+  if (GRL_IS_OK(err))
+    err=grlibint_getCount(r,onum_edges);
+  if (GRL_IS_OK(err) && (r->fields & GRM_ANNOTATIONS))
+    err=grlibint_getKeys(r,&(graph->numannotation),&(graph->annotations));
+  if (GRL_IS_OK(err))
+    err=grlibint_getKeys(r,&(graph->num_node_attrs),&(graph->node_attr_keys));
+  if (GRL_IS_OK(err))
+    err=grlibint_getKeys(r,&(graph->num_edge_attrs),&(graph->edge_attr_keys));
+  if (GRL_IS_OK(err) && (r->flags & GRE_INDEX))
+    err=grlibint_getIndex(r,*onum_nodes,*onum_edges);
+  if (GRL_IS_OK(err) && (r->flags & GRE_DICT))
+    err=grlibint_getDict(r);
+  r->num_nodes=*onum_nodes;
+  r->num_edges=*onum_edges;
+  return err;
+}
+
+
+/*............................................................*/
+/* column block of a columnar stream
+   - widths come first, followed by int columns; the heap behind
+     the block is read sequentially */
+
+graphlib_error_t grlibint_getColumns(grlibint_reader_t *r,
+                                     graphlib_graph_p graph, int is_node)
+{
+  graphlib_error_t err;
+  const char       *data;
+  uint64_t         ints;
+
+  err=grlibint_getBytes(r,&data,(XS_ALIGN-r->pos%XS_ALIGN)%XS_ALIGN);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  r->col_pos=r->pos;
+  r->col_item=0;
+  if (is_node)
+    {
+      r->col_num=r->num_nodes;
+      r->col_doubles=(r->fields & GRM_SIZE) ? 3 : 0;
+      ints=1+graph->num_node_attrs+((r->fields & GRM_COORDS) ? 2 : 0);
+    }
+  else
+    {
+      r->col_num=r->num_edges;
+      r->col_doubles=(r->fields & GRM_SIZE) ? 1 : 0;
+      ints=2+graph->num_edge_attrs+((r->fields & GRM_STYLE) ? 2 : 0);
+    }
+  if (r->fields & GRM_LABELS)
+    ints++;
+  if (r->fields & GRM_COLOR)
+    ints++;
+  if (r->fields & GRM_FONTSIZE)
+    ints++;
+  return grlibint_getBytes(r,&data,r->col_num*
+                           (r->col_doubles*sizeof(graphlib_width_t)+
+                            ints*sizeof(int)));
+}
+
+int grlibint_colInt(grlibint_reader_t *r, int col)
+{
+  int val;
+
+  memcpy(&val,r->buf+r->col_pos+
+         r->col_doubles*r->col_num*sizeof(graphlib_width_t)+
+         (col*r->col_num+r->col_item)*sizeof(int),sizeof(int));
+  return val;
+}
+
+graphlib_width_t grlibint_colWidth(grlibint_reader_t *r, int col)
+{
+  graphlib_width_t val;
+
+  memcpy(&val,r->buf+r->col_pos+
+         (col*r->col_num+r->col_item)*sizeof(graphlib_width_t),
+         sizeof(graphlib_width_t));
+  return val;
+}
+
+
+/*............................................................*/
+/* start of the n-th node or edge
+   - delta coding restarts with every chunk of an indexed stream
+   - the first node or edge of a columnar stream reads the column
+     block, the others select their row */
+
+graphlib_error_t grlibint_decodeChunk(grlibint_reader_t *r,
+                                      graphlib_graph_p graph, uint64_t n,
+                                      int is_node)
+{
+  if ((r->flags & GRE_INDEX) && (n%r->chunk==0))
+    {
+      if (is_node)
+        r->prev_id=0;
+      else
+        r->prev_from=r->prev_to=0;
+    }
+  if (r->flags & GRE_COLUMNAR)
+    {
+      if (n==0)
+        return grlibint_getColumns(r,graph,is_node);
+      r->col_item=n;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* serialized label (j<0) or attribute value
+   - the length is taken from the column block in columnar streams,
+     where the label column is missing if labels are not encoded
+   - in dictionary streams the length is a reference to an entry,
+     0 for an empty value */
+
+graphlib_error_t grlibint_getLabelData(grlibint_reader_t *r, int is_node,
+                                       int j, const char **odata,
+                                       unsigned int *olen)
+{
+  graphlib_error_t err;
+  unsigned int     len;
+
+  if (r->flags & GRE_COLUMNAR)
+    {
+      len=(unsigned int)grlibint_colInt(r,(is_node ? 1 : 2)+j+
+                                        ((r->fields & GRM_LABELS) ? 1 : 0));
+      err=GRL_OK;
+    }
+  else
+    err=grlibint_getLength(r,&len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  if (!(r->flags & GRE_DICT))
+    {
+      *olen=len;
+      return grlibint_getBytes(r,odata,len);
+    }
+  if (len>(unsigned int)r->dict_num)
+    return GRL_UNKNOWNFORMAT;
+  if (len==0)
+    {
+      *olen=0;
+      *odata=r->buf+r->pos;
+      return GRL_OK;
+    }
+  *olen=r->dict[len-1].len;
+  *odata=r->buf+r->dict[len-1].pos;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* read a serialized label and its attributes
+   - the values are created with the deserialize routines, the
+     caller frees them once they have been copied */
+
+graphlib_error_t grlibint_decodeLabels(grlibint_reader_t *r,
+                                       graphlib_graph_p graph, int is_node,
+                                       void **olabel, void ***oattr_values)
+{
+  graphlib_error_t err;
+  const char       *data;
+  unsigned int     len;
+  int              j,num_attrs;
+
+  *olabel=NULL;
+  num_attrs=is_node ? graph->num_node_attrs : graph->num_edge_attrs;
+  *oattr_values=(void **)calloc(1,num_attrs*sizeof(void *));
+  if (*oattr_values==NULL)
+    return GRL_NOMEM;
+
+  len=0;
+  if (r->fields & GRM_LABELS)
+    err=grlibint_getLabelData(r,is_node,-1,&data,&len);
+  else
+    err=GRL_OK;
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if ((len!=0) && r->borrow)
+    {
+      if (data[len-1]!='\0')
+        return GRL_UNKNOWNFORMAT;
+      *olabel=(void*)data;
+    }
+  else if (len!=0)
+    {
+      if (is_node)
+        graph->functions->deserialize_node(olabel,data,len);
+      else
+        graph->functions->deserialize_edge(olabel,data,len);
+    }
+
+  for (j=0;j<num_attrs;j++)
+    {
+      err=grlibint_getLabelData(r,is_node,j,&data,&len);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      if (len==0)
+        continue;
+      if (r->borrow)
+        {
+          if (data[len-1]!='\0')
+            return GRL_UNKNOWNFORMAT;
+          (*oattr_values)[j]=(void*)data;
+        }
+      else if (is_node)
+        graph->functions->deserialize_node_attr(graph->node_attr_keys[j],
+                                                &((*oattr_values)[j]),
+                                                data,len);
+      else
+        graph->functions->deserialize_edge_attr(graph->edge_attr_keys[j],
+                                                &((*oattr_values)[j]),
+                                                data,len);
+    }
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* free values created by grlibint_decodeLabels */
+
+void grlibint_freeLabels(graphlib_graph_p graph, int is_node, void *label,
+                         void **attr_values)
+{
+  int j;
+
+  if (is_node)
+    {
+      if (label!=NULL)
+        graph->functions->free_node(label);
+      if (attr_values!=NULL)
+        {
+          for (j=0;j<graph->num_node_attrs;j++)
+            graph->functions->free_node_attr(graph->node_attr_keys[j],
+                                             attr_values[j]);
+          free(attr_values);
+        }
+    }
+  else
+    {
+      if (label!=NULL)
+        graph->functions->free_edge(label);
+      if (attr_values!=NULL)
+        {
+          for (j=0;j<graph->num_edge_attrs;j++)
+            graph->functions->free_edge_attr(graph->edge_attr_keys[j],
+                                             attr_values[j]);
+          free(attr_values);
+        }
+    }
+}
+
+
+/*............................................................*/
+/* decode one node
+   - on success the caller owns label and attribute values, on error
+     nothing is left allocated */
+
+graphlib_error_t grlibint_decodeNodeData(grlibint_reader_t *r,
+                                         graphlib_graph_p graph,
+                                         graphlib_node_t *oid,
+                                         graphlib_nodeattr_t *node_attr)
+{
+  graphlib_error_t    err;
+  graphlib_nodeattr_t defattr = {0,0,0,0,0,0,NULL,14,NULL};
+  int                 k;
+
+  *node_attr=defattr;
+  if (r->flags & GRE_COLUMNAR)
+    *oid=grlibint_colInt(r,0);
+  else
+    {
+      err=grlibint_getId(r,oid,&(r->prev_id));
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
+  err=grlibint_decodeLabels(r,graph,1,&(node_attr->label),
+                            &(node_attr->attr_values));
+
+  /* visual fields follow the id, label and attribute columns */
+  k=1+graph->num_node_attrs+((r->fields & GRM_LABELS) ? 1 : 0);
+  if (GRL_IS_OK(err) && (r->flags & GRE_COLUMNAR))
+    {
+      if (r->fields & GRM_SIZE)
+        {
+          node_attr->width=grlibint_colWidth(r,0);
+          node_attr->w=grlibint_colWidth(r,1);
+          node_attr->height=grlibint_colWidth(r,2);
+        }
+      if (r->fields & GRM_COLOR)
+        node_attr->color=grlibint_colInt(r,k++);
+      if (r->fields & GRM_COORDS)
+        {
+          node_attr->x=grlibint_colInt(r,k++);
+          node_attr->y=grlibint_colInt(r,k++);
+        }
+      if (r->fields & GRM_FONTSIZE)
+        node_attr->fontsize=grlibint_colInt(r,k);
+    }
+  else
+    {
+      if (GRL_IS_OK(err) && (r->fields & GRM_SIZE))
+        {
+          err=grlibint_getWidth(r,&(node_attr->width));
+          if (GRL_IS_OK(err))
+            err=grlibint_getWidth(r,&(node_attr->w));
+          if (GRL_IS_OK(err))
+            err=grlibint_getWidth(r,&(node_attr->height));
+        }
+      if (GRL_IS_OK(err) && (r->fields & GRM_COLOR))
+        err=grlibint_getInt32(r,&(node_attr->color));
+      if (GRL_IS_OK(err) && (r->fields & GRM_COORDS))
+        {
+          err=grlibint_getInt32(r,&(node_attr->x));
+          if (GRL_IS_OK(err))
+            err=grlibint_getInt32(r,&(node_attr->y));
+        }
+      if (GRL_IS_OK(err) && (r->fields & GRM_FONTSIZE))
+        err=grlibint_getInt32(r,&(node_attr->fontsize));
+    }
+
+  if (GRL_IS_NOTOK(err))
+    grlibint_freeLabels(graph,1,node_attr->label,node_attr->attr_values);
+  return err;
+}
+
+
+/*............................................................*/
+/* decode one node and add it to the graph */
+
+graphlib_error_t grlibint_decodeNode(grlibint_reader_t *r,
+                                     graphlib_graph_p graph)
+{
+  graphlib_error_t    err;
+  graphlib_nodeattr_t node_attr;
+  graphlib_node_t     id;
+
+  err=grlibint_decodeNodeData(r,graph,&id,&node_attr);
+  if (GRL_IS_NOTOK(err))
+    return err;
+
+  err=graphlib_addNode(graph,id,&node_attr);
+
+  grlibint_freeLabels(graph,1,node_attr.label,node_attr.attr_values);
+  return err;
+}
+
+
+/*............................................................*/
+/* decode one edge
+   - on success the caller owns label and attribute values, on error
+     nothing is left allocated */
+
+graphlib_error_t grlibint_decodeEdgeData(grlibint_reader_t *r,
+                                         graphlib_graph_p graph,
+                                         graphlib_node_t *ofrom,
+                                         graphlib_node_t *oto,
+                                         graphlib_edgeattr_t *edge_attr)
+{
+  graphlib_error_t    err;
+  graphlib_edgeattr_t defattr = {1,0,NULL,0,0,14,NULL};
+  int                 k;
+
+  *edge_attr=defattr;
+  if (r->flags & GRE_COLUMNAR)
+    {
+      *ofrom=grlibint_colInt(r,0);
+      *oto=grlibint_colInt(r,1);
+    }
+  else
+    {
+      err=grlibint_getId(r,ofrom,&(r->prev_from));
+      if (GRL_IS_OK(err))
+        err=grlibint_getId(r,oto,&(r->prev_to));
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
+  err=grlibint_decodeLabels(r,graph,0,&(edge_attr->label),
+                            &(edge_attr->attr_values));
+
+  /* visual fields follow the ids, label and attribute columns */
+  k=2+graph->num_edge_attrs+((r->fields & GRM_LABELS) ? 1 : 0);
+  if (GRL_IS_OK(err) && (r->flags & GRE_COLUMNAR))
+    {
+      if (r->fields & GRM_SIZE)
+        edge_attr->width=grlibint_colWidth(r,0);
+      if (r->fields & GRM_COLOR)
+        edge_attr->color=grlibint_colInt(r,k++);
+      if (r->fields & GRM_STYLE)
+        {
+          edge_attr->arcstyle=grlibint_colInt(r,k++);
+          edge_attr->block=grlibint_colInt(r,k++);
+        }
+      if (r->fields & GRM_FONTSIZE)
+        edge_attr->fontsize=grlibint_colInt(r,k);
+    }
+  else
+    {
+      if (GRL_IS_OK(err) && (r->fields & GRM_SIZE))
+        err=grlibint_getWidth(r,&(edge_attr->width));
+      if (GRL_IS_OK(err) && (r->fields & GRM_COLOR))
+        err=grlibint_getInt32(r,&(edge_attr->color));
+      if (GRL_IS_OK(err) && (r->fields & GRM_STYLE))
+        {
+          err=grlibint_getInt32(r,&(edge_attr->arcstyle));
+          if (GRL_IS_OK(err))
+            err=grlibint_getInt32(r,&(edge_attr->block));
+        }
+      if (GRL_IS_OK(err) && (r->fields & GRM_FONTSIZE))
+        err=grlibint_getInt32(r,&(edge_attr->fontsize));
+    }
+
+  if (GRL_IS_NOTOK(err))
+    grlibint_freeLabels(graph,0,edge_attr->label,edge_attr->attr_values);
+  return err;
+}
+
+
+/*............................................................*/
+/* decode one edge and add it to the graph */
+
+graphlib_error_t grlibint_decodeEdge(grlibint_reader_t *r,
+                                     graphlib_graph_p graph)
+{
+  graphlib_error_t    err;
+  graphlib_edgeattr_t edge_attr;
+  graphlib_node_t     from_id,to_id;
+
+  err=grlibint_decodeEdgeData(r,graph,&from_id,&to_id,&edge_attr);
+  if (GRL_IS_NOTOK(err))
+    return err;
+
+  /* edges to unknown nodes are dropped (GRL_NONODE is a warning) */
+  err=graphlib_addDirectedEdge(graph,from_id,to_id,&edge_attr);
+
+  grlibint_freeLabels(graph,0,edge_attr.label,edge_attr.attr_values);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* set up a reader for a serialized buffer
+   - extended streams carry their flags, version 1 streams get them
+     from the caller */
+
+graphlib_error_t grlibint_openReader(grlibint_reader_t *r,
+                                     const char *ibyte_array,
+                                     uint64_t ibyte_array_len,
+                                     int full_graph)
+{
+  memset(r,0,sizeof(grlibint_reader_t));
+  r->buf=ibyte_array;
+  r->len=ibyte_array_len;
+
+  if ((ibyte_array_len>=XS_MAGICLEN) &&
+      (memcmp(ibyte_array,XS_MAGIC,XS_MAGICLEN)==0))
+    {
+      if (ibyte_array_len<XS_HEADERLEN)
+        return GRL_MEMORYERROR;
+      if (ibyte_array[XS_MAGICLEN]!=XS_VERSION)
+        return GRL_UNKNOWNFORMAT;
+      r->flags=(unsigned char)ibyte_array[XS_MAGICLEN+1];
+      if ((r->flags & ~(XS_ENCODINGS|XS_FULL|XS_MASK)) ||
+          ((r->flags & XS_FULL) && (r->flags & XS_MASK)))
+        return GRL_UNKNOWNFORMAT;
+      r->pos=XS_HEADERLEN;
+    }
+  else if (full_graph==1)
+    r->flags=XS_FULL;
+
+  if (r->flags & XS_MASK)
+    r->fields=(unsigned char)ibyte_array[XS_MAGICLEN+2];
+  else if (r->flags & XS_FULL)
+    r->fields=GRM_ALL;
+  else
+    r->fields=GRM_BASIC;
+
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy graph from an uncompressed serialized buffer, adding every
+   element with graphlib_addNode/graphlib_addDirectedEdge
+   - slow, but merges duplicate nodes */
+
+graphlib_error_t grlibint_deserializeGraphChecked(graphlib_graph_p *ograph,
+                                                  graphlib_functiontable_p
+                                                    functions,
+                                                  char *ibyte_array,
+                                                  uint64_t ibyte_array_len,
+                                                  int full_graph)
+{
+  graphlib_error_t  err;
+  graphlib_graph_p  graph;
+  grlibint_reader_t r;
+  int               num_nodes,num_edges,i;
+
+  err=grlibint_openReader(&r,ibyte_array,ibyte_array_len,full_graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  err=graphlib_newGraph(&graph,functions);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  err=grlibint_decodeHeader(&r,graph,&num_nodes,&num_edges);
+  for (i=0;(i<num_nodes) && GRL_IS_OK(err);i++)
+    {
+      err=grlibint_decodeChunk(&r,graph,i,1);
+      if (GRL_IS_OK(err))
+        err=grlibint_decodeNode(&r,graph);
+    }
+  for (i=0;(i<num_edges) && GRL_IS_OK(err);i++)
+    {
+      err=grlibint_decodeChunk(&r,graph,i,0);
+      if (GRL_IS_OK(err))
+        err=grlibint_decodeEdge(&r,graph);
+    }
+  free(r.dict);
+
+  if (GRL_IS_NOTOK(err))
+    {
+      graphlib_delGraph(graph);
+      return err;
+    }
+
+  *ograph=graph;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* bulk build
+   - serialized graphs come from a graph, so the elements are placed
+     straight into preallocated fragments and keep the decoded labels
+     instead of going through graphlib_addNode
+   - edges find their nodes through a table sorted by id instead of
+     a search through the graph
+   - in an indexed stream every chunk of nodes or edges can be
+     decoded on its own, so threads decode contiguous ranges of
+     chunks */
+
+typedef struct grlibint_noderef_d
+{
+  graphlib_node_t      id;
+  graphlib_nodeentry_p entry;
+} grlibint_noderef_t;
+
+typedef struct grlibint_deserjob_d
+{
+  graphlib_graph_p        graph;
+  grlibint_reader_t       r;
+  int                     is_node;
+  graphlib_nodefragment_p *nodefrags;
+  graphlib_edgefragment_p *edgefrags;
+  grlibint_noderef_t      *refs;
+  int                     num_refs;
+  int                     count;
+  uint64_t                base;
+  uint64_t                num_chunks;
+  uint64_t                first;
+  uint64_t                last;
+  graphlib_error_t        err;
+} grlibint_deserjob_t;
+
+
+/*............................................................*/
+/* decode one node into a preallocated entry
+   - takes over the decoded label and attribute values */
+
+graphlib_error_t grlibint_decodeNodeInto(grlibint_reader_t *r,
+                                         graphlib_graph_p graph,
+                                         graphlib_nodeentry_p entry)
+{
+  graphlib_error_t    err;
+  graphlib_nodeattr_t node_attr;
+  graphlib_node_t     id;
+
+  err=grlibint_decodeNodeData(r,graph,&id,&node_attr);
+  if (GRL_IS_NOTOK(err))
+    return err;
+
+  /* same as graphlib_addNode for a new node */
+  node_attr.w=node_attr.width;
+  entry->entry.data.id=id;
+  entry->entry.data.attr=node_attr;
+  entry->full=1;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* find a node in the sorted reference table */
+
+graphlib_nodeentry_p grlibint_findNodeRef(grlibint_noderef_t *refs,
+                                          int num_refs, graphlib_node_t id)
+{
+  int lo,hi,mid;
+
+  lo=0;
+  hi=num_refs;
+  while (lo<hi)
+    {
+      mid=lo+(hi-lo)/2;
+      if (refs[mid].id<id)
+        lo=mid+1;
+      else
+        hi=mid;
+    }
+  if ((lo<num_refs) && (refs[lo].id==id))
+    return refs[lo].entry;
+  return NULL;
+}
+
+
+/*............................................................*/
+/* decode one edge into a preallocated entry
+   - edges to unknown nodes are dropped, their entry stays empty */
+
+graphlib_error_t grlibint_decodeEdgeInto(grlibint_reader_t *r,
+                                         graphlib_graph_p graph,
+                                         graphlib_edgeentry_p entry,
+                                         grlibint_noderef_t *refs,
+                                         int num_refs)
+{
+  graphlib_error_t     err;
+  graphlib_edgeattr_t  edge_attr;
+  graphlib_node_t      from_id,to_id;
+  graphlib_nodeentry_p ref_from,ref_to;
+
+  err=grlibint_decodeEdgeData(r,graph,&from_id,&to_id,&edge_attr);
+  if (GRL_IS_NOTOK(err))
+    return err;
+
+  ref_from=grlibint_findNodeRef(refs,num_refs,from_id);
+  ref_to=grlibint_findNodeRef(refs,num_refs,to_id);
+  if ((ref_from==NULL) || (ref_to==NULL))
+    {
+      grlibint_freeLabels(graph,0,edge_attr.label,edge_attr.attr_values);
+      return GRL_OK;
+    }
+
+  entry->entry.data.node_from=from_id;
+  entry->entry.data.node_to=to_id;
+  entry->entry.data.ref_from=ref_from;
+  entry->entry.data.ref_to=ref_to;
+  entry->entry.data.attr=edge_attr;
+  entry->full=1;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* bulk build: decode the elements first to last-1 of a job */
+
+graphlib_error_t grlibint_deserRange(grlibint_deserjob_t *job, int first,
+                                     int last)
+{
+  grlibint_reader_t *r=&(job->r);
+  graphlib_error_t  err=GRL_OK;
+  int               i;
+
+  for (i=first;(i<last) && GRL_IS_OK(err);i++)
+    {
+      err=grlibint_decodeChunk(r,job->graph,i,job->is_node);
+      if (GRL_IS_NOTOK(err))
+        break;
+      if (job->is_node)
+        err=grlibint_decodeNodeInto(r,job->graph,
+              &(job->nodefrags[i/NODEFRAGSIZE]->node[i%NODEFRAGSIZE]));
+      else
+        err=grlibint_decodeEdgeInto(r,job->graph,
+              &(job->edgefrags[i/EDGEFRAGSIZE]->edge[i%EDGEFRAGSIZE]),
+              job->refs,job->num_refs);
+    }
+  return err;
+}
+
+
+/*............................................................*/
+/* bulk build: decode a range of chunks
+   - every chunk has to end exactly where the next one starts */
+
+void *grlibint_deserJob(void *arg)
+{
+  grlibint_deserjob_t *job=(grlibint_deserjob_t*)arg;
+  grlibint_reader_t   *r=&(job->r);
+  graphlib_error_t    err=GRL_OK;
+  uint64_t            c,end;
+  int                 last;
+
+  for (c=job->first;(c<job->last) && GRL_IS_OK(err);c++)
+    {
+      r->pos=grlibint_getChunkOffset(r,job->base+c);
+      if ((r->pos<r->index_pos) || (r->pos>r->len))
+        {
+          err=GRL_UNKNOWNFORMAT;
+          break;
+        }
+
+      last=(c+1)*r->chunk;
+      if (last>job->count)
+        last=job->count;
+      err=grlibint_deserRange(job,c*r->chunk,last);
+
+      if (GRL_IS_OK(err) && (job->base+c+1<job->num_chunks))
+        {
+          end=grlibint_getChunkOffset(r,job->base+c+1);
+          if (r->pos!=end)
+            err=GRL_UNKNOWNFORMAT;
+        }
+    }
+
+  job->err=err;
+  return NULL;
+}
+
+
+/*............................................................*/
+/* bulk build: decode all nodes or all edges
+   - without an index the elements are decoded in order by the
+     calling thread, which leaves the reader behind them */
+
+graphlib_error_t grlibint_runDeserJobs(grlibint_deserjob_t *proto,
+                                       int nthreads)
+{
+  grlibint_deserjob_t *jobs;
+  graphlib_error_t    err;
+  uint64_t            chunks,per;
+  int                 j;
+
+  if (!(proto->r.flags & GRE_INDEX))
+    return grlibint_deserRange(proto,0,proto->count);
+
+  chunks=((uint64_t)proto->count+proto->r.chunk-1)/proto->r.chunk;
+  if (chunks==0)
+    return GRL_OK;
+  if ((uint64_t)nthreads>chunks)
+    nthreads=chunks;
+
+  jobs=(grlibint_deserjob_t*)calloc(nthreads,sizeof(grlibint_deserjob_t));
+  if (jobs==NULL)
+    return GRL_NOMEM;
+
+  per=(chunks+nthreads-1)/nthreads;
+  for (j=0;j<nthreads;j++)
+    {
+      jobs[j]=*proto;
+      jobs[j].first=(j*per<chunks) ? j*per : chunks;
+      jobs[j].last=((j+1)*per<chunks) ? (j+1)*per : chunks;
+    }
+  grlibint_runThreads(grlibint_deserJob,jobs,sizeof(grlibint_deserjob_t),
+                      nthreads);
+
+  err=GRL_OK;
+  for (j=0;(j<nthreads) && GRL_IS_OK(err);j++)
+    err=jobs[j].err;
+  free(jobs);
+  return err;
+}
+
+
+/*............................................................*/
+/* order node references by id */
+
+int grlibint_cmpNodeRef(const void *a, const void *b)
+{
+  const grlibint_noderef_t *ra=(const grlibint_noderef_t*)a;
+  const grlibint_noderef_t *rb=(const grlibint_noderef_t*)b;
+
+  if (ra->id<rb->id)
+    return -1;
+  if (ra->id>rb->id)
+    return 1;
+  return 0;
+}
+
+
+/*............................................................*/
+/* close the gaps left by dropped edges
+   - graphlib_addDirectedEdge never stores them, so the remaining
+     edges are moved down to give the same fragments as the
+     sequential version */
+
+void grlibint_packEdgeFrags(graphlib_graph_p graph,
+                            graphlib_edgefragment_p *frags, int num)
+{
+  graphlib_edgeentry_p from,to;
+  int                  i,used,nfrags,k;
+
+  used=0;
+  for (i=0;i<num;i++)
+    {
+      from=&(frags[i/EDGEFRAGSIZE]->edge[i%EDGEFRAGSIZE]);
+      if (!from->full)
+        continue;
+      if (used!=i)
+        {
+          to=&(frags[used/EDGEFRAGSIZE]->edge[used%EDGEFRAGSIZE]);
+          *to=*from;
+          from->full=0;
+        }
+      used++;
+    }
+  if (used==num)
+    {
+      graph->directed=(num>0);
+      return;
+    }
+
+  nfrags=(num+EDGEFRAGSIZE-1)/EDGEFRAGSIZE;
+  k=(used+EDGEFRAGSIZE-1)/EDGEFRAGSIZE;
+  graph->edges=(k>0) ? frags[k-1] : NULL;
+  if (k>0)
+    frags[k-1]->count=used-(k-1)*EDGEFRAGSIZE;
+  for (;k<nfrags;k++)
+    free(frags[k]);
+  graph->directed=(used>0);
+}
+
+
+/*............................................................*/
+/* check whether labels can be borrowed: only the default routines
+   store them as terminated strings that can be used in place */
+
+int grlibint_canBorrow(graphlib_functiontable_p functions)
+{
+  return ((functions->deserialize_node==grlibint_deserialize_node) &&
+          (functions->deserialize_edge==grlibint_deserialize_node) &&
+          (functions->deserialize_node_attr==
+             grlibint_deserialize_node_attr) &&
+          (functions->deserialize_edge_attr==
+             grlibint_deserialize_node_attr));
+}
+
+
+/*............................................................*/
+/* switch a new graph to borrowed labels
+   - the graph gets a private copy of its function table that does
+     not free labels, the caller's table is kept in borrowed */
+
+graphlib_error_t grlibint_borrowLabels(graphlib_graph_p graph)
+{
+  graphlib_functiontable_p table;
+
+  table=(graphlib_functiontable_p)malloc(sizeof(graphlib_functiontable_t));
+  if (table==NULL)
+    return GRL_NOMEM;
+
+  *table=*(graph->functions);
+  table->free_node=grlibint_free_borrowed;
+  table->free_edge=grlibint_free_borrowed;
+  table->free_node_attr=grlibint_free_borrowed_attr;
+  table->free_edge_attr=grlibint_free_borrowed_attr;
+
+  graph->borrowed=graph->functions;
+  graph->functions=table;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy graph from a serialized buffer
+   - compressed frames are expanded first, their labels can not be
+     borrowed
+   - indexed streams are decoded by up to nthreads threads
+   - streams with duplicate node ids are handed to the checked
+     version, which always copies labels */
+
+graphlib_error_t grlibint_deserializeGraphParallel(graphlib_graph_p *ograph,
+                                                   graphlib_functiontable_p
+                                                     functions,
+                                                   char *ibyte_array,
+                                                   uint64_t ibyte_array_len,
+                                                   int nthreads,
+                                                   int full_graph,
+                                                   int flags)
+{
+  graphlib_error_t    err;
+  graphlib_graph_p    graph;
+  grlibint_reader_t   r;
+  grlibint_deserjob_t proto;
+  int                 num_nodes,num_edges,i;
+  char                *raw;
+  uint64_t            len;
+
+  if (grlibint_isCompressed(ibyte_array,ibyte_array_len))
+    {
+      err=grlibint_decompressFrame(ibyte_array,ibyte_array_len,&raw,&len);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      err=grlibint_deserializeGraphParallel(ograph,functions,raw,len,
+                                            nthreads,full_graph,
+                                            flags & ~GRD_BORROW);
+      free(raw);
+      return err;
+    }
+
+  if (nthreads<=0)
+    nthreads=sysconf(_SC_NPROCESSORS_ONLN);
+
+  err=grlibint_openReader(&r,ibyte_array,ibyte_array_len,full_graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  err=graphlib_newGraph(&graph,functions);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  memset(&proto,0,sizeof(grlibint_deserjob_t));
+  if ((flags & GRD_BORROW) && grlibint_canBorrow(graph->functions))
+    {
+      err=grlibint_borrowLabels(graph);
+      r.borrow=1;
+    }
+  if (GRL_IS_OK(err))
+    err=grlibint_decodeHeader(&r,graph,&num_nodes,&num_edges);
+
+  /* every item takes at least one byte, this bounds the allocation */
+  if (GRL_IS_OK(err) &&
+      ((uint64_t)num_nodes+num_edges>r.len-r.pos))
+    err=GRL_UNKNOWNFORMAT;
+
+  if (GRL_IS_OK(err))
+    err=grlibint_allocNodeFrags(graph,num_nodes,&(proto.nodefrags));
+  if (GRL_IS_OK(err))
+    err=grlibint_allocEdgeFrags(graph,num_edges,&(proto.edgefrags));
+
+  /* nodes */
+
+  if (GRL_IS_OK(err))
+    {
+      proto.graph=graph;
+      proto.r=r;
+      if (r.flags & GRE_INDEX)
+        proto.num_chunks=((uint64_t)num_nodes+r.chunk-1)/r.chunk+
+          ((uint64_t)num_edges+r.chunk-1)/r.chunk;
+      proto.is_node=1;
+      proto.count=num_nodes;
+      proto.base=0;
+      err=grlibint_runDeserJobs(&proto,nthreads);
+    }
+
+  if (GRL_IS_OK(err) && (num_nodes>0))
+    {
+      proto.refs=(grlibint_noderef_t*)malloc(num_nodes*
+                                             sizeof(grlibint_noderef_t));
+      if (proto.refs==NULL)
+        err=GRL_NOMEM;
+    }
+  if (GRL_IS_OK(err) && (num_nodes>0))
+    {
+      for (i=0;i<num_nodes;i++)
+        {
+          proto.refs[i].entry=
+            &(proto.nodefrags[i/NODEFRAGSIZE]->node[i%NODEFRAGSIZE]);
+          proto.refs[i].id=proto.refs[i].entry->entry.data.id;
+        }
+      qsort(proto.refs,num_nodes,sizeof(grlibint_noderef_t),
+            grlibint_cmpNodeRef);
+      proto.num_refs=num_nodes;
+      for (i=1;i<num_nodes;i++)
+        {
+          if (proto.refs[i].id==proto.refs[i-1].id)
+            break;
+        }
+      if (i<num_nodes)
+        {
+          /* duplicates have to be merged by graphlib_addNode */
+          free(proto.refs);
+          free(proto.nodefrags);
+          free(proto.edgefrags);
+          free(r.dict);
+          graphlib_delGraph(graph);
+          return grlibint_deserializeGraphChecked(ograph,functions,
+                                                  ibyte_array,
+                                                  ibyte_array_len,
+                                                  full_graph);
+        }
+    }
+
+  /* edges */
+
+  if (GRL_IS_OK(err))
+    {
+      proto.is_node=0;
+      proto.count=num_edges;
+      if (r.flags & GRE_INDEX)
+        proto.base=((uint64_t)num_nodes+r.chunk-1)/r.chunk;
+      err=grlibint_runDeserJobs(&proto,nthreads);
+    }
+
+  if (GRL_IS_OK(err))
+    grlibint_packEdgeFrags(graph,proto.edgefrags,num_edges);
+
+  free(proto.refs);
+  free(proto.nodefrags);
+  free(proto.edgefrags);
+  free(r.dict);
+
+  if (GRL_IS_NOTOK(err))
+    {
+      graphlib_delGraph(graph);
+      return err;
+    }
+
+  *ograph=graph;
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy graph from a serialized buffer on the calling thread */
+
+graphlib_error_t grlibint_deserializeGraph(graphlib_graph_p *ograph,
+                                           graphlib_functiontable_p functions,
+                                           char *ibyte_array,
+                                           uint64_t ibyte_array_len,
+                                           int full_graph)
+{
+  return grlibint_deserializeGraphParallel(ograph,functions,ibyte_array,
+                                           ibyte_array_len,1,full_graph,
+                                           GRD_DEFAULT);
+}
+
+
+graphlib_error_t graphlib_deserializeGraph(graphlib_graph_p *ograph,
+                                           graphlib_functiontable_p functions,
+                                           char *ibyte_array,
+                                           uint64_t ibyte_array_len)
 {
-  graphlib_error_t err;
-  char                    *temp_array=NULL,*temp=NULL,term='\0';
-  int                     cur_idx,num_nodes,num_edges;
-  int                     temp_array_len=0,i,j;
-  unsigned int            label_len;
-  graphlib_nodefragment_p nodefrag;
-  graphlib_edgefragment_p edgefrag;
-  graphlib_nodedata_p     node;
-  graphlib_edgedata_p     edge;
+  return grlibint_deserializeGraph(ograph,functions,ibyte_array,
+                                   ibyte_array_len,1);
+}
 
-  err = graphlib_nodeCount(igraph,&num_nodes);
-  err = graphlib_edgeCount(igraph,&num_edges);
+graphlib_error_t graphlib_deserializeBasicGraph(graphlib_graph_p *ograph,
+                                                graphlib_functiontable_p
+                                                  functions,
+                                                char *ibyte_array,
+                                                uint64_t ibyte_array_len)
+{
+  return grlibint_deserializeGraph(ograph,functions,ibyte_array,
+                                   ibyte_array_len,0);
+}
 
-  cur_idx = 0;
-  *obyte_array_len = 0;
+graphlib_error_t graphlib_deserializeGraphParallel(graphlib_graph_p *ograph,
+                                                   graphlib_functiontable_p
+                                                     functions,
+                                                   char *ibyte_array,
+                                                   uint64_t ibyte_array_len,
+                                                   int nthreads)
+{
+  return grlibint_deserializeGraphParallel(ograph,functions,ibyte_array,
+                                           ibyte_array_len,nthreads,1,
+                                           GRD_DEFAULT);
+}
 
-  /* write header */
-  grlibint_copyDataToBuf(&cur_idx,(const char*)&num_nodes,sizeof(int),
-                         &temp_array,&temp_array_len);
-  *obyte_array_len+=sizeof(int);
-  grlibint_copyDataToBuf(&cur_idx,(const char *)&num_edges,sizeof(int),
-                         &temp_array,&temp_array_len);
-  *obyte_array_len+=sizeof(int);
+graphlib_error_t graphlib_deserializeBasicGraphParallel(graphlib_graph_p
+                                                          *ograph,
+                                                        graphlib_functiontable_p
+                                                          functions,
+                                                        char *ibyte_array,
+                                                        uint64_t
+                                                          ibyte_array_len,
+                                                        int nthreads)
+{
+  return grlibint_deserializeGraphParallel(ograph,functions,ibyte_array,
+                                           ibyte_array_len,nthreads,0,
+                                           GRD_DEFAULT);
+}
 
-  if (full_graph==1)
-    {
-      /* write annotations */
-      grlibint_copyDataToBuf(&cur_idx,(const char *)&igraph->numannotation,
-                             sizeof(int),&temp_array,&temp_array_len);
-      *obyte_array_len+=sizeof(int);
-      for (i=0;i<igraph->numannotation;i++)
-        {
-          if (igraph->annotations[i]!=NULL)
-            label_len=strlen(igraph->annotations[i])+1;
-          else
-            label_len=0;
-          grlibint_copyDataToBuf(&cur_idx,(const char *)&label_len,
-                                 sizeof(unsigned int),&temp_array,
-                                 &temp_array_len);
-          *obyte_array_len+=sizeof(int);
-          if (label_len>0)
-            {
-              grlibint_copyDataToBuf(&cur_idx,igraph->annotations[i],label_len,
-                                     &temp_array,&temp_array_len);
-              *obyte_array_len+=label_len;
-            }
-        }
-    }
+graphlib_error_t graphlib_deserializeGraphFlags(graphlib_graph_p *ograph,
+                                                graphlib_functiontable_p
+                                                  functions,
+                                                char *ibyte_array,
+                                                uint64_t ibyte_array_len,
+                                                int flags)
+{
+  return grlibint_deserializeGraphParallel(ograph,functions,ibyte_array,
+                                           ibyte_array_len,1,1,flags);
+}
 
-  /* write attr keys */
-  grlibint_copyDataToBuf(&cur_idx,(const char *)&igraph->num_node_attrs,
-                         sizeof(int),&temp_array,&temp_array_len);
-  *obyte_array_len+=sizeof(int);
-  for (i=0;i<igraph->num_node_attrs;i++)
-    {
-      if (igraph->node_attr_keys[i]!=NULL)
-        label_len=strlen(igraph->node_attr_keys[i])+1;
-      else
-        label_len=0;
-      grlibint_copyDataToBuf(&cur_idx,(const char *)&label_len,
-                             sizeof(unsigned int),&temp_array,
-                             &temp_array_len);
-      *obyte_array_len+=sizeof(int);
-      if (label_len>0)
-        {
-          grlibint_copyDataToBuf(&cur_idx,igraph->node_attr_keys[i],label_len,
-                                 &temp_array,&temp_array_len);
-          *obyte_array_len+=label_len;
-        }
-    }
-  grlibint_copyDataToBuf(&cur_idx,(const char *)&igraph->num_edge_attrs,
-                         sizeof(int),&temp_array,&temp_array_len);
-  *obyte_array_len+=sizeof(int);
-  for (i=0;i<igraph->num_edge_attrs;i++)
-    {
-      if (igraph->edge_attr_keys[i]!=NULL)
-        label_len=strlen(igraph->edge_attr_keys[i])+1;
-      else
-        label_len=0;
-      grlibint_copyDataToBuf(&cur_idx,(const char *)&label_len,
-                             sizeof(unsigned int),&temp_array,
-                             &temp_array_len);
-      *obyte_array_len+=sizeof(int);
-      if (label_len>0)
-        {
-          grlibint_copyDataToBuf(&cur_idx,igraph->edge_attr_keys[i],label_len,
-                                 &temp_array,&temp_array_len);
-          *obyte_array_len+=label_len;
-        }
-    }
+graphlib_error_t graphlib_deserializeBasicGraphFlags(graphlib_graph_p *ograph,
+                                                     graphlib_functiontable_p
+                                                       functions,
+                                                     char *ibyte_array,
+                                                     uint64_t ibyte_array_len,
+                                                     int flags)
+{
+  return grlibint_deserializeGraphParallel(ograph,functions,ibyte_array,
+                                           ibyte_array_len,1,0,flags);
+}
 
-  /* write nodes */
-  nodefrag=igraph->nodes;
-  while (nodefrag!=NULL)
-    {
-      for (i=0;i<nodefrag->count;i++)
-        {
-          if (nodefrag->node[i].full)
-            {
-              /* write one node */
-              node=&(nodefrag->node[i].entry.data);
 
-              /* id */
-              grlibint_copyDataToBuf(&cur_idx,(const char *)&(node->id),
-                                     sizeof(graphlib_node_t), &temp_array,
-                                     &temp_array_len);
-              *obyte_array_len+=sizeof(graphlib_node_t);
-
-              /* label */
-              label_len=igraph->functions->
-                serialize_node_length(node->attr.label);
-              grlibint_copyDataToBuf(&cur_idx,(const char *)&(label_len),
-                                     sizeof(unsigned int),&temp_array,
-                                     &temp_array_len);
-              *obyte_array_len+=sizeof(unsigned int);
-              if (label_len!=0)
-                {
-                  temp=(char*)malloc(label_len);
-                  if (temp==NULL)
-                    return GRL_NOMEM;
-                  igraph->functions->serialize_node(temp, node->attr.label);
-                  grlibint_copyDataToBuf(&cur_idx,temp,label_len,&temp_array,
-                                         &temp_array_len);
-                  free(temp);
-                  *obyte_array_len+=label_len;
-                }
+/*............................................................*/
+/* replace borrowed labels by copies owned by the graph */
 
-              /* attrs */
-              for (j=0;j<igraph->num_node_attrs;j++)
-                {
-                  label_len=igraph->functions->
-                    serialize_node_attr_length(igraph->node_attr_keys[j],
-                                               node->attr.attr_values[j]);
-                  grlibint_copyDataToBuf(&cur_idx,(const char *)&(label_len),
-                                         sizeof(unsigned int),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(unsigned int);
-                  if (label_len!=0)
-                    {
-                      temp=(char*)malloc(label_len);
-                      if (temp==NULL)
-                        return GRL_NOMEM;
-                      igraph->functions->serialize_node_attr(igraph->node_attr_keys[j],
-                                                             temp,
-                                                             node->attr.attr_values[j]);
-                      grlibint_copyDataToBuf(&cur_idx,temp,label_len,&temp_array,
-                                             &temp_array_len);
-                      free(temp);
-                      *obyte_array_len+=label_len;
-                    }
-                }
+graphlib_error_t graphlib_materializeLabels(graphlib_graph_p graph)
+{
+  graphlib_functiontable_p functions=graph->borrowed;
+  graphlib_nodefragment_p  nodefrag;
+  graphlib_edgefragment_p  edgefrag;
+  graphlib_nodeattr_p      node_attr;
+  graphlib_edgeattr_p      edge_attr;
+  graphlib_error_t         err;
+  int                      i,j;
 
-              if (full_graph == 1)
-                {
-                  /* width */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.width),
-                                         sizeof(graphlib_width_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_width_t);
-                  /* w */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.w),
-                                         sizeof(graphlib_width_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_width_t);
-                  /* height */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.height),
-                                         sizeof(graphlib_width_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_width_t);
-                  /* color */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.color),
-                                         sizeof(graphlib_color_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_color_t);
-                  /* x */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.x),
-                                         sizeof(graphlib_coor_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_coor_t);
-                  /* y */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.y),
-                                         sizeof(graphlib_coor_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_coor_t);
-                  /* fontsize */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(node->attr.fontsize),
-                                         sizeof(graphlib_fontsize_t),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(graphlib_fontsize_t);
-                }
-            }
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+  if (functions==NULL)
+    return GRL_OK;
+
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (!nodefrag->node[i].full)
+            continue;
+          node_attr=&(nodefrag->node[i].entry.data.attr);
+          node_attr->label=functions->copy_node(node_attr->label);
+          for (j=0;j<graph->num_node_attrs;j++)
+            node_attr->attr_values[j]=
+              functions->copy_node_attr(graph->node_attr_keys[j],
+                                        node_attr->attr_values[j]);
         }
-      nodefrag=nodefrag->next;
     }
-
-  /* write edges */
-  edgefrag=igraph->edges;
-  while (edgefrag!=NULL)
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
     {
       for (i=0;i<edgefrag->count;i++)
         {
-          if (edgefrag->edge[i].full)
-            {
-              /* write one edge */
-              edge=&(edgefrag->edge[i].entry.data);
-
-              /* from_id */
-              grlibint_copyDataToBuf(&cur_idx,(const char *)&(edge->node_from),
-                                     sizeof(graphlib_node_t),&temp_array,
-                                     &temp_array_len);
-              *obyte_array_len += sizeof(graphlib_node_t);
-
-              /* to_id */
-              grlibint_copyDataToBuf(&cur_idx,(const char *)&(edge->node_to),
-                                     sizeof(graphlib_node_t),&temp_array,
-                                     &temp_array_len);
-              *obyte_array_len+=sizeof(graphlib_node_t);
-
-              /* name */
-              label_len=igraph->functions->serialize_edge_length(edge->attr.
-                                                                   label);
-              grlibint_copyDataToBuf(&cur_idx,(const char *)&(label_len),
-                                     sizeof(unsigned int),&temp_array,
-                                     &temp_array_len);
-              *obyte_array_len+=sizeof(unsigned int);
-              if (label_len!=0)
-                {
-                  temp=(char*)malloc(label_len);
-                  if (temp==NULL)
-                    return GRL_NOMEM;
-                  igraph->functions->serialize_edge(temp,edge->attr.label);
-                  grlibint_copyDataToBuf(&cur_idx,temp,label_len,&temp_array,
-                                         &temp_array_len);
-                  free(temp);
-                  *obyte_array_len+=label_len;
-                }
-
-              /* attrs */
-              for (j=0;j<igraph->num_edge_attrs;j++)
-                {
-                  label_len=igraph->functions->
-                    serialize_edge_attr_length(igraph->edge_attr_keys[j],
-                                               edge->attr.attr_values[j]);
-                  grlibint_copyDataToBuf(&cur_idx,(const char *)&(label_len),
-                                         sizeof(unsigned int),&temp_array,
-                                         &temp_array_len);
-                  *obyte_array_len+=sizeof(unsigned int);
-                  if (label_len!=0)
-                    {
-                      temp=(char*)malloc(label_len);
-                      if (temp==NULL)
-                        return GRL_NOMEM;
-                      igraph->functions->
-                        serialize_edge_attr(igraph->edge_attr_keys[j],
-                                              temp,
-                                              edge->attr.attr_values[j]);
-                      grlibint_copyDataToBuf(&cur_idx,temp,label_len,&temp_array,
-                                             &temp_array_len);
-                      free(temp);
-                      *obyte_array_len+=label_len;
-                    }
-                }
-
-              if (full_graph==1)
-                {
-                  /* width */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(edge->attr.width),
-                                         sizeof(graphlib_width_t),&temp_array,
-                                         &temp_array_len );
-                  *obyte_array_len+=sizeof(graphlib_width_t);
-                  /* color */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(edge->attr.color),
-                                         sizeof(graphlib_color_t),&temp_array,
-                                         &temp_array_len );
-                  *obyte_array_len+=sizeof(graphlib_color_t);
-                  /* arcstyle */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(edge->attr.arcstyle),
-                                         sizeof(graphlib_arc_t),&temp_array,
-                                         &temp_array_len );
-                  *obyte_array_len+=sizeof(graphlib_arc_t);
-                  /* block */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(edge->attr.block),
-                                         sizeof(graphlib_block_t),&temp_array,
-                                         &temp_array_len );
-                  *obyte_array_len+=sizeof(graphlib_block_t);
-                  /* fontsize */
-                  grlibint_copyDataToBuf(&cur_idx,
-                                         (const char *)&(edge->attr.fontsize),
-                                         sizeof(graphlib_fontsize_t),
-                                         &temp_array,
-                                         &temp_array_len );
-                  *obyte_array_len+=sizeof(graphlib_fontsize_t);
-                }
-            }
+          if (!edgefrag->edge[i].full)
+            continue;
+          edge_attr=&(edgefrag->edge[i].entry.data.attr);
+          edge_attr->label=functions->copy_edge(edge_attr->label);
+          for (j=0;j<graph->num_edge_attrs;j++)
+            edge_attr->attr_values[j]=
+              functions->copy_edge_attr(graph->edge_attr_keys[j],
+                                        edge_attr->attr_values[j]);
         }
-      edgefrag=edgefrag->next;
     }
 
-  *obyte_array = temp_array;
+  if (graph->textcache!=NULL)
+    grlibint_textForget(graph->textcache,NULL);
+  free(graph->functions);
+  graph->functions=functions;
+  graph->borrowed=NULL;
   return GRL_OK;
 }
 
-graphlib_error_t graphlib_serializeGraph(graphlib_graph_p igraph,
-                                         char **obyte_array,
-                                         uint64_t *obyte_array_len)
+/*............................................................*/
+/* incremental decoder state
+   - compressed input is collected per block in frame, decoded bytes
+     that do not yet form a complete item wait in pending */
+
+typedef struct graphlib_decoder_d
 {
-  return grlibint_serializeGraph(igraph, obyte_array, obyte_array_len, 1);
-}
+  graphlib_functiontable_p functions;
+  graphlib_graph_p         graph;
+  int                      full_graph;
+  int                      mode;
+  char                     head[XZ_MAGICLEN];
+  uint64_t                 head_len;
+  int                      state;
+  int                      num_nodes;
+  int                      num_edges;
+  int                      count;
+  grlibint_reader_t        r;
+  char                     *pending;
+  uint64_t                 pending_len;
+  uint64_t                 pending_cap;
+  char                     *frame;
+  uint64_t                 frame_len;
+  uint64_t                 frame_cap;
+  int                      frame_started;
+  int                      frame_done;
+  graphlib_error_t         err;
+} graphlib_decoder_t;
 
-graphlib_error_t graphlib_serializeBasicGraph(graphlib_graph_p igraph,
-                                              char **obyte_array,
-                                              uint64_t *obyte_array_len)
+
+/*............................................................*/
+/* incremental decoder: append bytes to a growing buffer */
+
+graphlib_error_t grlibint_appendBytes(char **buf, uint64_t *len,
+                                      uint64_t *cap, const char *data,
+                                      uint64_t datalen)
 {
-  return grlibint_serializeGraph(igraph, obyte_array, obyte_array_len, 0);
+  char     *nbuf;
+  uint64_t ncap;
+
+  if (*len+datalen>*cap)
+    {
+      ncap=(*cap<XD_CHUNK) ? XD_CHUNK : *cap;
+      while (ncap<*len+datalen)
+        ncap*=2;
+      nbuf=(char*)realloc(*buf,ncap);
+      if (nbuf==NULL)
+        return GRL_NOMEM;
+      *buf=nbuf;
+      *cap=ncap;
+    }
+  memcpy(*buf+*len,data,datalen);
+  *len+=datalen;
+  return GRL_OK;
 }
 
+
 /*............................................................*/
-/* copy graph from a serialized buffer */
+/* incremental decoder: decode as many complete items as possible
+   - an item that runs out of data has no side effects and is
+     decoded again once more data arrived; only the unconsumed tail
+     of the input is kept */
 
-graphlib_error_t grlibint_deserializeGraph(graphlib_graph_p *ograph,
-                                           graphlib_functiontable_p functions,
-                                           char *ibyte_array,
-                                           uint64_t ibyte_array_len,
-                                           int full_graph)
+graphlib_error_t grlibint_decoderPush(graphlib_decoder_p dec,
+                                      const char *data, uint64_t len)
 {
-  graphlib_error_t    err;
-  graphlib_nodeattr_t node_attr = {0,0,0,0,0,0,NULL,14,NULL};
-  graphlib_edgeattr_t edge_attr = {1,0,NULL,0,0,14,NULL};
-  int                 num_nodes,num_edges,i,j,id=0,from_id=0,to_id=0;
-  int                 cur_idx;
-  unsigned int        label_len;
+  graphlib_error_t  err;
+  grlibint_reader_t r,save;
+  const char        *src;
+  uint64_t          srclen;
 
-  err=graphlib_newGraph(ograph,functions);
-  if (GRL_IS_FATALERROR(err))
-    return err;
+  if (dec->pending_len>0)
+    {
+      err=grlibint_appendBytes(&(dec->pending),&(dec->pending_len),
+                               &(dec->pending_cap),data,len);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      src=dec->pending;
+      srclen=dec->pending_len;
+    }
+  else
+    {
+      src=data;
+      srclen=len;
+    }
 
-  cur_idx=0;
-  /* read header */
-  grlibint_copyDataFromBuf((char*)&num_nodes,&cur_idx,sizeof(int),ibyte_array,
-                           ibyte_array_len);
-  grlibint_copyDataFromBuf((char*)&num_edges,&cur_idx,sizeof(int),ibyte_array,
-                           ibyte_array_len);
+  r=dec->r;
+  r.buf=src;
+  r.len=srclen;
+  r.pos=0;
 
-  if (full_graph==1)
+  err=GRL_OK;
+  save=r;
+  while (GRL_IS_OK(err) && (dec->state!=XD_DONE))
     {
-      /* read annotations */
-      grlibint_copyDataFromBuf((char*)&((*ograph)->numannotation),&cur_idx,
-                               sizeof(int),ibyte_array,ibyte_array_len);
-      if ((*ograph)->numannotation>0)
+      save=r;
+      if (dec->state==XD_START)
         {
-          (*ograph)->annotations=(char**)malloc((*ograph)->numannotation*
-                                 sizeof(char*));
-          if ((*ograph)->annotations==NULL)
-            return GRL_NOMEM;
+          /* the magic decides between version 1 and extended streams */
+          if (srclen<XS_MAGICLEN)
+            err=GRL_MEMORYERROR;
+          else
+            err=grlibint_openReader(&r,src,srclen,dec->full_graph);
+          if (GRL_IS_OK(err))
+            dec->state=XD_HEADER;
+
+          /* columns precede the heap and dictionary entries are
+             used throughout the stream, so such streams are kept
+             whole and decoded by graphlib_decoderFinish */
+          if (GRL_IS_OK(err) && (r.flags & (GRE_COLUMNAR|GRE_DICT)))
+            {
+              r.pos=0;
+              dec->state=XD_COLLECT;
+            }
+        }
+      else if (dec->state==XD_COLLECT)
+        err=GRL_MEMORYERROR;
+      else if (dec->state==XD_HEADER)
+        {
+          err=grlibint_decodeHeader(&r,dec->graph,&(dec->num_nodes),
+                                    &(dec->num_edges));
+          if (err==GRL_MEMORYERROR)
+            {
+              /* keys read so far are dropped with the graph */
+              graphlib_delGraph(dec->graph);
+              dec->graph=NULL;
+              err=graphlib_newGraph(&(dec->graph),dec->functions);
+              if (GRL_IS_OK(err))
+                err=GRL_MEMORYERROR;
+            }
+          if (GRL_IS_OK(err))
+            dec->state=XD_NODES;
         }
-      for (i=0;i<(*ograph)->numannotation;i++)
+      else if (dec->state==XD_NODES)
         {
-          grlibint_copyDataFromBuf((char*)&(label_len),&cur_idx,
-                                   sizeof(unsigned int),ibyte_array,
-                                   ibyte_array_len);
-          if (label_len>0)
+          if (dec->count==dec->num_nodes)
+            {
+              dec->state=XD_EDGES;
+              dec->count=0;
+            }
+          else
             {
-              (*ograph)->annotations[i]=(char*)malloc(label_len);
-              if ((*ograph)->annotations[i]==NULL)
-                return GRL_NOMEM;
-              grlibint_copyDataFromBuf((*ograph)->annotations[i],&cur_idx,label_len,
-                                       ibyte_array,ibyte_array_len);
+              err=grlibint_decodeChunk(&r,dec->graph,dec->count,1);
+              if (GRL_IS_OK(err))
+                err=grlibint_decodeNode(&r,dec->graph);
+              if (GRL_IS_OK(err))
+                dec->count++;
             }
+        }
+      else
+        {
+          if (dec->count==dec->num_edges)
+            dec->state=XD_DONE;
           else
-            (*ograph)->annotations[i]=NULL;
+            {
+              err=grlibint_decodeChunk(&r,dec->graph,dec->count,0);
+              if (GRL_IS_OK(err))
+                err=grlibint_decodeEdge(&r,dec->graph);
+              if (GRL_IS_OK(err))
+                dec->count++;
+            }
         }
     }
 
-  /* read attrs */
-  grlibint_copyDataFromBuf((char*)&((*ograph)->num_node_attrs),&cur_idx,
-                           sizeof(int),ibyte_array,ibyte_array_len);
-  if ((*ograph)->num_node_attrs>0)
+  if (err==GRL_MEMORYERROR)
     {
-      (*ograph)->node_attr_keys=(char**)malloc((*ograph)->num_node_attrs*
-                             sizeof(char*));
-      if ((*ograph)->node_attr_keys==NULL)
-        return GRL_NOMEM;
+      r=save;
+      err=GRL_OK;
     }
-  for (i=0;i<(*ograph)->num_node_attrs;i++)
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  /* keep the unconsumed tail, once done trailing bytes are ignored */
+
+  if (dec->state==XD_DONE)
+    dec->pending_len=0;
+  else if (src==dec->pending)
     {
-      grlibint_copyDataFromBuf((char*)&(label_len),&cur_idx,
-                               sizeof(unsigned int),ibyte_array,
-                               ibyte_array_len);
-      if (label_len>0)
-        {
-          (*ograph)->node_attr_keys[i]=(char*)malloc(label_len);
-          if ((*ograph)->node_attr_keys[i]==NULL)
-            return GRL_NOMEM;
-          grlibint_copyDataFromBuf((*ograph)->node_attr_keys[i],&cur_idx,label_len,
-                                   ibyte_array,ibyte_array_len);
-        }
-      else
-        (*ograph)->node_attr_keys[i]=NULL;
+      if (r.pos>0)
+        memmove(dec->pending,dec->pending+r.pos,srclen-r.pos);
+      dec->pending_len=srclen-r.pos;
     }
-  grlibint_copyDataFromBuf((char*)&((*ograph)->num_edge_attrs),&cur_idx,
-                           sizeof(int),ibyte_array,ibyte_array_len);
-  if ((*ograph)->num_edge_attrs>0)
+  else
+    err=grlibint_appendBytes(&(dec->pending),&(dec->pending_len),
+                             &(dec->pending_cap),src+r.pos,srclen-r.pos);
+
+  r.buf=NULL;
+  r.len=0;
+  r.pos=0;
+  dec->r=r;
+  return err;
+}
+
+
+/*............................................................*/
+/* incremental decoder: split a compressed frame into blocks and
+   decode each block as soon as it is complete */
+
+graphlib_error_t grlibint_decoderUnframe(graphlib_decoder_p dec,
+                                         const char *data, uint64_t len)
+{
+  graphlib_error_t err;
+  uint32_t         hdr[XZ_BLOCKHDR/sizeof(uint32_t)];
+  uint64_t         pos,clen;
+  char             *raw;
+
+  err=grlibint_appendBytes(&(dec->frame),&(dec->frame_len),
+                           &(dec->frame_cap),data,len);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  pos=0;
+  if (!dec->frame_started)
     {
-      (*ograph)->edge_attr_keys=(char**)malloc((*ograph)->num_edge_attrs*
-                             sizeof(char*));
-      if ((*ograph)->edge_attr_keys==NULL)
-        return GRL_NOMEM;
+      if (dec->frame_len<XZ_HEADERLEN)
+        return GRL_OK;
+      if ((dec->frame[XZ_MAGICLEN]!=XZ_VERSION) ||
+          (dec->frame[XZ_MAGICLEN+1]!=XZ_CODEC_LZ4))
+        return GRL_UNKNOWNFORMAT;
+      dec->frame_started=1;
+      pos=XZ_HEADERLEN;
     }
-  for (i=0;i<(*ograph)->num_edge_attrs;i++)
+
+  while (GRL_IS_OK(err) && (!dec->frame_done) &&
+         (dec->frame_len-pos>=XZ_BLOCKHDR))
     {
-      grlibint_copyDataFromBuf((char*)&(label_len),&cur_idx,
-                               sizeof(unsigned int),ibyte_array,
-                               ibyte_array_len);
-      if (label_len>0)
+      memcpy(hdr,dec->frame+pos,XZ_BLOCKHDR);
+      if (hdr[0]==0)
         {
-          (*ograph)->edge_attr_keys[i]=(char*)malloc(label_len);
-          if ((*ograph)->edge_attr_keys[i]==NULL)
-            return GRL_NOMEM;
-          grlibint_copyDataFromBuf((*ograph)->edge_attr_keys[i],&cur_idx,label_len,
-                                   ibyte_array,ibyte_array_len);
+          dec->frame_done=1;
+          pos+=XZ_BLOCKHDR;
+          break;
+        }
+      clen=hdr[1]&~XZ_STORED;
+      if (dec->frame_len-pos-XZ_BLOCKHDR<clen)
+        break;
+      pos+=XZ_BLOCKHDR;
+
+      raw=(char*)malloc(hdr[0]);
+      if (raw==NULL)
+        return GRL_NOMEM;
+      if (hdr[1]&XZ_STORED)
+        {
+          err=(clen==hdr[0]) ? GRL_OK : GRL_UNKNOWNFORMAT;
+          if (GRL_IS_OK(err))
+            memcpy(raw,dec->frame+pos,clen);
         }
       else
-        (*ograph)->edge_attr_keys[i]=NULL;
+        err=grlibint_lzDecompress(dec->frame+pos,clen,raw,hdr[0]);
+      if (GRL_IS_OK(err) && (grlibint_crc32(0,raw,hdr[0])!=hdr[2]))
+        err=GRL_FILEERROR;
+      if (GRL_IS_OK(err))
+        err=grlibint_decoderPush(dec,raw,hdr[0]);
+      free(raw);
+      pos+=clen;
     }
 
-  /* read nodes */
-  for(i=0;i<num_nodes;i++)
+  if (pos>0)
     {
-      /* id */
-      grlibint_copyDataFromBuf((char*)&id,&cur_idx,sizeof(graphlib_node_t),
-                               ibyte_array,ibyte_array_len);
+      memmove(dec->frame,dec->frame+pos,dec->frame_len-pos);
+      dec->frame_len-=pos;
+    }
+  return err;
+}
 
-      /* name */
-      grlibint_copyDataFromBuf((char*)&label_len,&cur_idx,sizeof(unsigned int),
-                               ibyte_array,ibyte_array_len);
-      if (label_len!=0)
-        {
-          (*ograph)->functions->deserialize_node(&(node_attr.label),
-                                                 ibyte_array+cur_idx,label_len);
-          cur_idx+=label_len;
-        }
+
+/*............................................................*/
+/* incremental decoder: create, feed, finish */
+
+graphlib_error_t grlibint_newDecoder(graphlib_decoder_p *odec,
+                                     graphlib_functiontable_p functions,
+                                     int full_graph)
+{
+  graphlib_decoder_p dec;
+  graphlib_error_t   err;
+
+  dec=(graphlib_decoder_p)calloc(1,sizeof(graphlib_decoder_t));
+  if (dec==NULL)
+    return GRL_NOMEM;
+  dec->functions=functions;
+  dec->full_graph=full_graph;
+  dec->state=XD_START;
+
+  err=graphlib_newGraph(&(dec->graph),functions);
+  if (GRL_IS_FATALERROR(err))
+    {
+      free(dec);
+      return err;
+    }
+
+  *odec=dec;
+  return GRL_OK;
+}
+
+graphlib_error_t graphlib_newDecoder(graphlib_decoder_p *odec,
+                                     graphlib_functiontable_p functions)
+{
+  return grlibint_newDecoder(odec,functions,1);
+}
+
+graphlib_error_t graphlib_newBasicDecoder(graphlib_decoder_p *odec,
+                                          graphlib_functiontable_p functions)
+{
+  return grlibint_newDecoder(odec,functions,0);
+}
+
+graphlib_error_t graphlib_decoderFeed(graphlib_decoder_p dec,
+                                      const char *chunk, uint64_t len)
+{
+  graphlib_error_t err;
+  uint64_t         need;
+
+  if (GRL_IS_FATALERROR(dec->err))
+    return dec->err;
+
+  /* the first bytes tell whether the stream is compressed */
+
+  err=GRL_OK;
+  if (dec->mode==XD_UNKNOWN)
+    {
+      need=XZ_MAGICLEN-dec->head_len;
+      if (need>len)
+        need=len;
+      memcpy(dec->head+dec->head_len,chunk,need);
+      dec->head_len+=need;
+      chunk+=need;
+      len-=need;
+      if (dec->head_len<XZ_MAGICLEN)
+        return GRL_OK;
+
+      dec->mode=grlibint_isCompressed(dec->head,XZ_MAGICLEN) ?
+        XD_FRAMED : XD_PLAIN;
+      if (dec->mode==XD_FRAMED)
+        err=grlibint_decoderUnframe(dec,dec->head,XZ_MAGICLEN);
       else
-        node_attr.label=NULL;
+        err=grlibint_decoderPush(dec,dec->head,XZ_MAGICLEN);
+    }
 
-      /* attrs */
-      node_attr.attr_values=(void **)calloc(1,(*ograph)->num_node_attrs*sizeof(void *));
-      if (node_attr.attr_values==NULL)
-        return GRL_NOMEM;
-      for (j=0;j<(*ograph)->num_node_attrs;j++)
-        {
-          grlibint_copyDataFromBuf((char*)&label_len,&cur_idx,sizeof(unsigned int),
-                                   ibyte_array,ibyte_array_len);
-          if (label_len!=0)
-            {
-              (*ograph)->functions->
-                deserialize_node_attr((*ograph)->node_attr_keys[j],
-                                      &(node_attr.attr_values[j]),
-                                      ibyte_array+cur_idx,label_len);
-              cur_idx+=label_len;
-            }
-          else
-            node_attr.attr_values[j]=NULL;
-        }
-
-      if (full_graph==1)
-        {
-          /* width */
-          grlibint_copyDataFromBuf((char*)&node_attr.width,
-                                   &cur_idx,sizeof(graphlib_width_t),
-                                   ibyte_array,ibyte_array_len);
-          /* w */
-          grlibint_copyDataFromBuf((char*)&node_attr.w,
-                                   &cur_idx,sizeof(graphlib_width_t),
-                                   ibyte_array,ibyte_array_len);
-          /* height */
-          grlibint_copyDataFromBuf((char*)&node_attr.height,
-                                   &cur_idx,sizeof(graphlib_width_t),
-                                   ibyte_array,ibyte_array_len);
-          /* color */
-          grlibint_copyDataFromBuf((char*)&node_attr.color,
-                                   &cur_idx,sizeof(graphlib_color_t),
-                                   ibyte_array,ibyte_array_len);
-          /* x */
-          grlibint_copyDataFromBuf((char*)&node_attr.x,
-                                   &cur_idx,sizeof(graphlib_coor_t),
-                                   ibyte_array,ibyte_array_len);
-          /* y */
-          grlibint_copyDataFromBuf((char*)&node_attr.y,
-                                   &cur_idx,sizeof(graphlib_coor_t),
-                                   ibyte_array,ibyte_array_len);
-          /* fontsize */
-          grlibint_copyDataFromBuf((char*)&node_attr.fontsize,
-                                   &cur_idx,sizeof(graphlib_fontsize_t),
-                                   ibyte_array,ibyte_array_len);
-        }
-      graphlib_addNode(*ograph,id,&node_attr);
-      if (node_attr.label != NULL)
-        (*ograph)->functions->free_node(node_attr.label);
-      if (node_attr.attr_values != NULL)
-        {
-          for (j=0;j<(*ograph)->num_node_attrs;j++)
-            {
-              (*ograph)->functions->free_node_attr((*ograph)->node_attr_keys[j],
-                                                   node_attr.attr_values[j]);
-            }
-          free(node_attr.attr_values);
-        }
+  if (GRL_IS_OK(err) && (len>0))
+    {
+      if (dec->mode==XD_FRAMED)
+        err=grlibint_decoderUnframe(dec,chunk,len);
+      else
+        err=grlibint_decoderPush(dec,chunk,len);
     }
 
-  /* read edges */
-  for (i=0;i<num_edges;i++)
+  dec->err=err;
+  return err;
+}
+
+graphlib_error_t graphlib_decoderFeedFd(graphlib_decoder_p dec, int fh)
+{
+  graphlib_error_t err;
+  char             *chunk;
+  ssize_t          count;
+
+  chunk=(char*)malloc(XD_CHUNK);
+  if (chunk==NULL)
+    return GRL_NOMEM;
+
+  err=GRL_OK;
+  do
     {
-      /* from_id */
-      grlibint_copyDataFromBuf((char*)&from_id,&cur_idx,sizeof(graphlib_node_t),                               ibyte_array,ibyte_array_len );
+      count=read(fh,chunk,XD_CHUNK);
+      if (count<0)
+        err=GRL_FILEERROR;
+      else if (count>0)
+        err=graphlib_decoderFeed(dec,chunk,count);
+    }
+  while (GRL_IS_OK(err) && (count>0));
 
-      /* to_id */
-      grlibint_copyDataFromBuf((char*)&to_id,&cur_idx,sizeof(graphlib_node_t),
-                               ibyte_array,ibyte_array_len );
+  free(chunk);
+  return err;
+}
 
-      /* name */
-      grlibint_copyDataFromBuf((char*)&label_len,&cur_idx,sizeof(unsigned int),
-                               ibyte_array,ibyte_array_len);
-      if (label_len!=0)
-        {
-          (*ograph)->functions->deserialize_edge(&(edge_attr.label),
-                                                 ibyte_array+cur_idx,label_len);
-          cur_idx+=label_len;
-        }
-      else
-        edge_attr.label=NULL;
+graphlib_error_t graphlib_decoderFinish(graphlib_decoder_p dec,
+                                        graphlib_graph_p *ograph)
+{
+  graphlib_error_t err;
 
-      /* attrs */
-      edge_attr.attr_values=(void **)calloc(1,(*ograph)->num_edge_attrs*sizeof(void *));
-      if (edge_attr.attr_values==NULL)
-        return GRL_NOMEM;
-      for (j=0;j<(*ograph)->num_edge_attrs;j++)
-        {
-          grlibint_copyDataFromBuf((char*)&label_len,&cur_idx,sizeof(unsigned int),
-                                   ibyte_array,ibyte_array_len);
-          if (label_len!=0)
-            {
-              (*ograph)->functions->
-                deserialize_edge_attr((*ograph)->edge_attr_keys[j],
-                                 &(edge_attr.attr_values[j]),
-                                 ibyte_array+cur_idx,label_len);
-              cur_idx+=label_len;
-            }
-          else
-            edge_attr.attr_values[j]=NULL;
-        }
-
-
-      if (full_graph==1)
-        {
-          /* width */
-          grlibint_copyDataFromBuf((char*)&edge_attr.width,&cur_idx,
-                                   sizeof(graphlib_width_t),ibyte_array,
-                                   ibyte_array_len );
-          /* color */
-          grlibint_copyDataFromBuf((char*)&edge_attr.color,&cur_idx,
-                                   sizeof(graphlib_color_t),ibyte_array,
-                                   ibyte_array_len );
-          /* arcstyle */
-          grlibint_copyDataFromBuf((char*)&edge_attr.arcstyle,&cur_idx,
-                                   sizeof(graphlib_arc_t),ibyte_array,
-                                   ibyte_array_len );
-          /* block */
-          grlibint_copyDataFromBuf((char*)&edge_attr.block,&cur_idx,
-                                   sizeof(graphlib_block_t),ibyte_array,
-                                   ibyte_array_len );
-          /* fontsize */
-          grlibint_copyDataFromBuf((char*)&edge_attr.fontsize,&cur_idx,
-                                   sizeof(graphlib_fontsize_t),ibyte_array,
-                                   ibyte_array_len );
-        }
-      graphlib_addDirectedEdge(*ograph,from_id,to_id,&edge_attr);
-      if (edge_attr.label != NULL)
-        (*ograph)->functions->free_edge(edge_attr.label);
-      if (edge_attr.attr_values != NULL)
-        {
-          for (j=0;j<(*ograph)->num_edge_attrs;j++)
-            {
-              (*ograph)->functions->free_edge_attr((*ograph)->edge_attr_keys[j],
-                                                   edge_attr.attr_values[j]);
-            }
-          free(edge_attr.attr_values);
-        }
+  err=dec->err;
+  if (GRL_IS_OK(err) && (dec->mode==XD_FRAMED) && (!dec->frame_done))
+    err=GRL_MEMORYERROR;
+  if (GRL_IS_OK(err) && (dec->state==XD_COLLECT))
+    {
+      graphlib_delGraph(dec->graph);
+      dec->graph=NULL;
+      err=grlibint_deserializeGraph(&(dec->graph),dec->functions,
+                                    dec->pending,dec->pending_len,
+                                    dec->full_graph);
+      if (GRL_IS_OK(err))
+        dec->state=XD_DONE;
     }
+  if (GRL_IS_OK(err) && (dec->state!=XD_DONE))
+    err=GRL_MEMORYERROR;
 
-    return GRL_OK;
+  if (GRL_IS_OK(err))
+    {
+      *ograph=dec->graph;
+      dec->graph=NULL;
+    }
+  graphlib_delDecoder(dec);
+  return err;
 }
 
-
-graphlib_error_t graphlib_deserializeGraph(graphlib_graph_p *ograph,
-                                           graphlib_functiontable_p functions,
-                                           char *ibyte_array,
-                                           uint64_t ibyte_array_len)
+graphlib_error_t graphlib_delDecoder(graphlib_decoder_p dec)
 {
-  return grlibint_deserializeGraph(ograph,functions,ibyte_array,
-                                   ibyte_array_len,1);
+  if (dec->graph!=NULL)
+    graphlib_delGraph(dec->graph);
+  free(dec->pending);
+  free(dec->frame);
+  free(dec);
+  return GRL_OK;
 }
 
-graphlib_error_t graphlib_deserializeBasicGraph(graphlib_graph_p *ograph,
-                                                graphlib_functiontable_p
-                                                  functions,
-                                                char *ibyte_array,
-                                                uint64_t ibyte_array_len)
-{
-  return grlibint_deserializeGraph(ograph,functions,ibyte_array,
-                                   ibyte_array_len,0);
-}
 
 /*-----------------------------------------------------------------*/
 /* Manipulation routines */
@@ -2834,6 +10803,14 @@ graphlib_error_t graphlib_addNode(graphlib_graph_p graph,graphlib_node_t node,
   graphlib_error_t        err;
   int                     newnode,i;
 
+  /* borrowed labels can not be merged or replaced in place */
+  if (graph->borrowed!=NULL)
+    {
+      err=graphlib_materializeLabels(graph);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
 #ifdef FASTPATH
   err=GRL_NONODE;
 #else
@@ -2881,6 +10858,12 @@ graphlib_error_t graphlib_addNode(graphlib_graph_p graph,graphlib_node_t node,
     {
       if (GRL_IS_FATALERROR(err))
         return err;
+      /* a node of a lazily loaded graph is decoded before it changes */
+      err=grlibint_lazyNode(graph,entry);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+      grlibint_textForgetLabels(graph,1,entry->entry.data.attr.label,
+                                entry->entry.data.attr.attr_values);
       newnode=0;
     }
 
@@ -2937,6 +10920,14 @@ graphlib_error_t graphlib_addNodeNoCheck(graphlib_graph_p graph,
   graphlib_error_t        err;
   int                     newnode,i;
 
+  /* borrowed labels can not be merged or replaced in place */
+  if (graph->borrowed!=NULL)
+    {
+      err=graphlib_materializeLabels(graph);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
   err=GRL_NONODE;
   if (err==GRL_NONODE)
     {
@@ -2980,6 +10971,8 @@ graphlib_error_t graphlib_addNodeNoCheck(graphlib_graph_p graph,
     {
       if (GRL_IS_FATALERROR(err))
         return err;
+      grlibint_textForgetLabels(graph,1,entry->entry.data.attr.label,
+                                entry->entry.data.attr.attr_values);
       newnode=0;
     }
 
@@ -3078,6 +11071,14 @@ graphlib_error_t graphlib_addDirectedEdge(graphlib_graph_p graph,
   graphlib_error_t        err;
   int                     i;
 
+  /* borrowed labels can not be merged or replaced in place */
+  if (graph->borrowed!=NULL)
+    {
+      err=graphlib_materializeLabels(graph);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
 #ifdef FASTPATH
   err=GRL_NOEDGE;
 #else
@@ -3138,6 +11139,15 @@ graphlib_error_t graphlib_addDirectedEdge(graphlib_graph_p graph,
     {
       if (GRL_IS_FATALERROR(err))
         return err;
+      /* the labels of a lazily loaded graph are decoded before merging */
+      if (entry->entry.data.attr.attr_values==grlibint_pending_values)
+        {
+          err=grlibint_lazyLoadAll(graph);
+          if (GRL_IS_FATALERROR(err))
+            return err;
+        }
+      grlibint_textForgetLabels(graph,0,entry->entry.data.attr.label,
+                                entry->entry.data.attr.attr_values);
       entry->entry.data.attr.label = graph->functions->merge_edge(attr->label, entry->entry.data.attr.label);
 //      graph->functions->free_edge(entry->entry.data.attr.label);
       for (i=0;i<graph->num_edge_attrs;i++)
@@ -3185,6 +11195,14 @@ graphlib_error_t graphlib_addDirectedEdgeNoCheck(graphlib_graph_p graph,
   graphlib_error_t        err;
   int                     i;
 
+  /* borrowed labels can not be merged or replaced in place */
+  if (graph->borrowed!=NULL)
+    {
+      err=graphlib_materializeLabels(graph);
+      if (GRL_IS_FATALERROR(err))
+        return err;
+    }
+
   err=GRL_NOEDGE;
   if (err==GRL_NOEDGE)
     {
@@ -3299,6 +11317,13 @@ graphlib_error_t graphlib_mergeGraphs(graphlib_graph_p graph1,
   graphlib_nodeentry_p    nodeentry;
   graphlib_edgeentry_p    edgeentry;
 
+  /* graph1 takes merged labels, so it has to own them */
+  err=graphlib_materializeLabels(graph1);
+  if (GRL_IS_OK(err))
+    err=grlibint_lazyLoadAll(graph2);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
   runnode=graph2->nodes;
   runedge=graph2->edges;
 
@@ -3318,6 +11343,9 @@ graphlib_error_t graphlib_mergeGraphs(graphlib_graph_p graph1,
                                     &nodeentry);
               if (err == GRL_OK )
                 {
+                  grlibint_textForgetLabels(graph1,1,
+                    nodeentry->entry.data.attr.label,
+                    nodeentry->entry.data.attr.attr_values);
                   if (graph1->functions->merge_node != NULL)
                     nodeentry->entry.data.attr.label =
                                graph1->functions->merge_node(
@@ -3355,6 +11383,9 @@ graphlib_error_t graphlib_mergeGraphs(graphlib_graph_p graph1,
                                     &edgeentry);
               if (err == GRL_OK ) /*merge the edge labels*/
                 {
+                  grlibint_textForgetLabels(graph1,0,
+                    edgeentry->entry.data.attr.label,
+                    edgeentry->entry.data.attr.attr_values);
                   if (graph1->functions->merge_edge != NULL)
                     edgeentry->entry.data.attr.label =
                                graph1->functions->merge_edge(
@@ -3403,6 +11434,13 @@ graphlib_error_t graphlib_mergeGraphsWeighted(graphlib_graph_p graph1,
   graphlib_edgeentry_p    edgeentry;
   graphlib_nodeentry_p    nodeentry;
 
+  /* graph1 takes merged labels, so it has to own them */
+  err=graphlib_materializeLabels(graph1);
+  if (GRL_IS_OK(err))
+    err=grlibint_lazyLoadAll(graph2);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
   runnode=graph2->nodes;
   runedge=graph2->edges;
 
@@ -3426,6 +11464,9 @@ graphlib_error_t graphlib_mergeGraphsWeighted(graphlib_graph_p graph1,
                   /*widths must be combined*/
                   runnode->node[i].entry.data.attr.width+=nodeentry->entry.data.
                                                             attr.width;
+                  grlibint_textForgetLabels(graph1,1,
+                    nodeentry->entry.data.attr.label,
+                    nodeentry->entry.data.attr.attr_values);
                   if (graph1->functions->merge_node != NULL)
                     nodeentry->entry.data.attr.label =
                                graph1->functions->merge_node(
@@ -3466,6 +11507,9 @@ graphlib_error_t graphlib_mergeGraphsWeighted(graphlib_graph_p graph1,
       /*widths must be combined*/
                   runedge->edge[i].entry.data.attr.width+=edgeentry->entry.data.
                                                             attr.width;
+                  grlibint_textForgetLabels(graph1,0,
+                    edgeentry->entry.data.attr.label,
+                    edgeentry->entry.data.attr.attr_values);
                   if (graph1->functions->merge_edge!=NULL)
                     edgeentry->entry.data.attr.label =
                                graph1->functions->merge_edge(
@@ -3537,6 +11581,9 @@ graphlib_error_t graphlib_getNodeAttr(graphlib_graph_p graph,
   err=grlibint_findNode(graph,node,&entry);
   if (GRL_IS_NOTOK(err))
     return err;
+  err=grlibint_lazyNode(graph,entry);
+  if (GRL_IS_FATALERROR(err))
+    return err;
   *attr=&(entry->entry.data.attr);
 
   return GRL_OK;
@@ -4235,6 +12282,10 @@ graphlib_error_t graphlib_colorGraphByLeadingEdgeLabel(graphlib_graph_p graph)
   graphlib_nodedata_p n;
   graphlib_error_t err;
 
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
   /*color nodes based on name of incoming edge*/
   grlibint_num_colors=0;
   nf=graph->nodes;
@@ -4274,6 +12325,10 @@ graphlib_error_t graphlib_colorGraphByLeadingEdgeAttr(graphlib_graph_p graph, co
   graphlib_nodedata_p n;
   graphlib_error_t err;
 
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
   /*color nodes based on name of incoming edge*/
   grlibint_num_colors=0;
   nf=graph->nodes;
@@ -4303,5 +12358,466 @@ graphlib_error_t graphlib_colorGraphByLeadingEdgeAttr(graphlib_graph_p graph, co
   return GRL_OK;
 }
 
+/*-----------------------------------------------------------------*/
+/* Level of detail export */
+
+/*............................................................*/
+/* nodes of a level of detail export, sorted by id
+   - parent is the source of the first incoming edge (-1 for roots)
+   - the other fields sum up the children left out of a kept node,
+     they become its summary node */
+
+typedef struct grlibint_lodnode_d
+{
+  graphlib_node_t         id;
+  graphlib_nodefragment_p frag;
+  int                     index;
+  int                     parent;
+  int                     keep;
+  int                     collapsed;
+  double                  width;
+  double                  value;
+  double                  edgewidth;
+  void                    *label;
+  void                    *edgelabel;
+} grlibint_lodnode_t;
+
+typedef struct grlibint_lodheap_d
+{
+  double value;
+  int    node;
+} grlibint_lodheap_t;
+
+
+/*............................................................*/
+/* compare level of detail nodes by id */
+
+int grlibint_cmpLodNode(const void *a, const void *b)
+{
+  const grlibint_lodnode_t *na=(const grlibint_lodnode_t*)a;
+  const grlibint_lodnode_t *nb=(const grlibint_lodnode_t*)b;
+
+  if (na->id<nb->id)
+    return -1;
+  if (na->id>nb->id)
+    return 1;
+  return 0;
+}
+
+
+/*............................................................*/
+/* find a node in the sorted level of detail nodes, -1 if unknown */
+
+int grlibint_lodFind(grlibint_lodnode_t *nodes, int num_nodes,
+                     graphlib_node_t id)
+{
+  int lo,hi,mid;
+
+  lo=0;
+  hi=num_nodes;
+  while (lo<hi)
+    {
+      mid=lo+(hi-lo)/2;
+      if (nodes[mid].id<id)
+        lo=mid+1;
+      else
+        hi=mid;
+    }
+  if ((lo<num_nodes) && (nodes[lo].id==id))
+    return lo;
+  return -1;
+}
+
+
+/*............................................................*/
+/* weight of a node: GRW_WIDTH, GRW_W or an annotation */
+
+double grlibint_lodValue(graphlib_graph_p graph, grlibint_lodnode_t *node,
+                         int metric)
+{
+  graphlib_nodedata_p data=&(node->frag->node[node->index].entry.data);
+
+  if (metric==GRW_WIDTH)
+    return data->attr.width;
+  if (metric==GRW_W)
+    return data->attr.w;
+  return node->frag->grannot[node->index*graph->numannotation+metric];
+}
+
+
+/*............................................................*/
+/* restore the min-heap property below pos */
+
+void grlibint_lodSiftDown(grlibint_lodheap_t *heap, int num, int pos)
+{
+  grlibint_lodheap_t tmp;
+  int                child;
+
+  while (2*pos+1<num)
+    {
+      child=2*pos+1;
+      if ((child+1<num) && (heap[child+1].value<heap[child].value))
+        child++;
+      if (heap[pos].value<=heap[child].value)
+        break;
+      tmp=heap[pos];
+      heap[pos]=heap[child];
+      heap[child]=tmp;
+      pos=child;
+    }
+}
+
+
+/*............................................................*/
+/* select the k heaviest nodes in one pass with a bounded min-heap
+   and keep them together with their path to a root */
+
+graphlib_error_t grlibint_lodSelect(graphlib_graph_p graph,
+                                    grlibint_lodnode_t *nodes,
+                                    int num_nodes, int k, int metric)
+{
+  grlibint_lodheap_t *heap;
+  double             value;
+  int                num,i,n;
+
+  if (k>num_nodes)
+    k=num_nodes;
+  heap=(grlibint_lodheap_t*)malloc((k+1)*sizeof(grlibint_lodheap_t));
+  if (heap==NULL)
+    return GRL_NOMEM;
+
+  num=0;
+  for (n=0;n<num_nodes;n++)
+    {
+      value=grlibint_lodValue(graph,&(nodes[n]),metric);
+      if (num<k)
+        {
+          heap[num].value=value;
+          heap[num++].node=n;
+          if (num==k)
+            {
+              for (i=k/2-1;i>=0;i--)
+                grlibint_lodSiftDown(heap,num,i);
+            }
+        }
+      else if (value>heap[0].value)
+        {
+          heap[0].value=value;
+          heap[0].node=n;
+          grlibint_lodSiftDown(heap,num,0);
+        }
+    }
+
+  /* walking up stops at kept nodes, which also ends cycles */
+
+  for (i=0;i<num;i++)
+    {
+      for (n=heap[i].node;(n>=0) && (!nodes[n].keep);n=nodes[n].parent)
+        nodes[n].keep=1;
+    }
+
+  free(heap);
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* copy a kept node into the level of detail graph */
+
+graphlib_error_t grlibint_lodAddNode(graphlib_graph_p lod,
+                                     graphlib_nodeattr_p attr,
+                                     graphlib_node_t id,
+                                     graphlib_annotation_t *annot)
+{
+  graphlib_nodeentry_p entry;
+  graphlib_error_t     err;
+
+  err=graphlib_addNodeNoCheck(lod,id,attr);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  /* the new graph has no free entries, so the node is the last entry
+     of the first fragment; graphlib_addNode sets w to the width */
+
+  entry=&(lod->nodes->node[lod->nodes->count-1]);
+  entry->entry.data.attr.w=attr->w;
+  if (lod->numannotation>0)
+    memcpy(lod->nodes->grannot+(lod->nodes->count-1)*lod->numannotation,
+           annot,lod->numannotation*sizeof(graphlib_annotation_t));
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* build the level of detail graph: kept nodes, edges between them,
+   and one summary node per kept node with children left out */
+
+graphlib_error_t grlibint_lodBuild(graphlib_graph_p graph,
+                                   graphlib_graph_p lod,
+                                   grlibint_lodnode_t *nodes,
+                                   int num_nodes, int metric)
+{
+  graphlib_functiontable_p functions=lod->functions;
+  graphlib_edgefragment_p  edgefrag;
+  graphlib_edgedata_p      edge;
+  graphlib_nodedata_p      data;
+  graphlib_nodeattr_t      attr;
+  graphlib_edgeattr_t      eattr;
+  graphlib_annotation_t    *annot;
+  grlibint_lodnode_t       *from,*to;
+  graphlib_error_t         err;
+  graphlib_node_t          id;
+  void                     **nullvals;
+  int                      n,i,f,t;
+
+  nullvals=(void**)calloc(graph->num_node_attrs+graph->num_edge_attrs+1,
+                          sizeof(void*));
+  annot=(graphlib_annotation_t*)calloc(graph->numannotation+1,
+                                       sizeof(graphlib_annotation_t));
+  if ((nullvals==NULL) || (annot==NULL))
+    {
+      free(nullvals);
+      free(annot);
+      return GRL_NOMEM;
+    }
+
+  err=GRL_OK;
+  for (n=0;(n<num_nodes) && GRL_IS_OK(err);n++)
+    {
+      if (!nodes[n].keep)
+        continue;
+      data=&(nodes[n].frag->node[nodes[n].index].entry.data);
+      err=grlibint_lodAddNode(lod,&(data->attr),data->id,
+                              nodes[n].frag->grannot+
+                              nodes[n].index*graph->numannotation);
+    }
+
+  /* edges between kept nodes are copied, edges to children left out
+     are summed up at their source */
+
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    {
+      for (i=0;(i<edgefrag->count) && GRL_IS_OK(err);i++)
+        {
+          if (!edgefrag->edge[i].full)
+            continue;
+          edge=&(edgefrag->edge[i].entry.data);
+          f=grlibint_lodFind(nodes,num_nodes,edge->node_from);
+          t=grlibint_lodFind(nodes,num_nodes,edge->node_to);
+          if ((f<0) || (t<0) || (!nodes[f].keep))
+            continue;
+          from=&(nodes[f]);
+          to=&(nodes[t]);
+          if (to->keep)
+            {
+              err=graphlib_addDirectedEdgeNoCheck(lod,edge->node_from,
+                                                  edge->node_to,
+                                                  &(edge->attr));
+              continue;
+            }
+
+          data=&(to->frag->node[to->index].entry.data);
+          from->collapsed++;
+          from->width+=data->attr.width;
+          from->value+=grlibint_lodValue(graph,to,metric);
+          from->edgewidth+=edge->attr.width;
+          if (data->attr.label!=NULL)
+            {
+              if (from->label==NULL)
+                from->label=functions->copy_node(data->attr.label);
+              else
+                from->label=functions->merge_node(from->label,
+                                                  data->attr.label);
+            }
+          if (edge->attr.label!=NULL)
+            {
+              if (from->edgelabel==NULL)
+                from->edgelabel=functions->copy_edge(edge->attr.label);
+              else
+                from->edgelabel=functions->merge_edge(from->edgelabel,
+                                                      edge->attr.label);
+            }
+        }
+    }
+
+  /* summary nodes get ids above all existing ones */
+
+  id=(num_nodes>0) ? nodes[num_nodes-1].id : 0;
+  for (n=0;n<num_nodes;n++)
+    {
+      if (nodes[n].collapsed==0)
+        continue;
+      if (GRL_IS_OK(err))
+        {
+          graphlib_setDefNodeAttr(&attr);
+          attr.label=nodes[n].label;
+          attr.width=nodes[n].width;
+          attr.w=(metric==GRW_W) ? nodes[n].value : nodes[n].width;
+          attr.color=GRC_LIGHTGRAY;
+          attr.attr_values=nullvals;
+          if (metric>=0)
+            annot[metric]=nodes[n].value;
+          err=grlibint_lodAddNode(lod,&attr,++id,annot);
+        }
+      if (GRL_IS_OK(err))
+        {
+          graphlib_setDefEdgeAttr(&eattr);
+          eattr.label=nodes[n].edgelabel;
+          eattr.width=nodes[n].edgewidth;
+          eattr.attr_values=nullvals;
+          err=graphlib_addDirectedEdgeNoCheck(lod,nodes[n].id,id,&eattr);
+        }
+      if (nodes[n].label!=NULL)
+        functions->free_node(nodes[n].label);
+      if (nodes[n].edgelabel!=NULL)
+        functions->free_edge(nodes[n].edgelabel);
+    }
+
+  free(nullvals);
+  free(annot);
+  return err;
+}
+
+
+/*............................................................*/
+/* export a reduced graph: the k heaviest nodes by the metric, the
+   nodes on their paths to a root, and summary nodes for the children
+   left out
+   - summary nodes merge the labels of the children they stand for
+     and sum up their widths and metric */
+
+graphlib_error_t graphlib_exportGraphLOD(graphlib_filename_t fn,
+                                         graphlib_format_t format,
+                                         graphlib_graph_p graph, int k,
+                                         int metric)
+{
+  graphlib_nodefragment_p nodefrag;
+  graphlib_edgefragment_p edgefrag;
+  graphlib_edgedata_p     edge;
+  graphlib_graph_p        lod;
+  grlibint_lodnode_t      *nodes;
+  graphlib_error_t        err;
+  int                     num_nodes,n,i,f,t,idx;
+
+  /* k=0 selects nothing and exports an empty graph */
+  if ((k<0) || (metric<GRW_W) || (metric>=graph->numannotation))
+    return GRL_INVALID;
+
+  err=grlibint_lazyLoadAll(graph);
+  if (GRL_IS_FATALERROR(err))
+    return err;
+
+  graphlib_nodeCount(graph,&num_nodes);
+  nodes=(grlibint_lodnode_t*)calloc(num_nodes+1,sizeof(grlibint_lodnode_t));
+  if (nodes==NULL)
+    return GRL_NOMEM;
+
+  n=0;
+  for (nodefrag=graph->nodes;nodefrag!=NULL;nodefrag=nodefrag->next)
+    {
+      for (i=0;i<nodefrag->count;i++)
+        {
+          if (!nodefrag->node[i].full)
+            continue;
+          nodes[n].id=nodefrag->node[i].entry.data.id;
+          nodes[n].frag=nodefrag;
+          nodes[n].index=i;
+          nodes[n++].parent=-1;
+        }
+    }
+  qsort(nodes,num_nodes,sizeof(grlibint_lodnode_t),grlibint_cmpLodNode);
+
+  for (edgefrag=graph->edges;edgefrag!=NULL;edgefrag=edgefrag->next)
+    {
+      for (i=0;i<edgefrag->count;i++)
+        {
+          if (!edgefrag->edge[i].full)
+            continue;
+          edge=&(edgefrag->edge[i].entry.data);
+          f=grlibint_lodFind(nodes,num_nodes,edge->node_from);
+          t=grlibint_lodFind(nodes,num_nodes,edge->node_to);
+          if ((f>=0) && (t>=0) && (f!=t) && (nodes[t].parent<0))
+            nodes[t].parent=f;
+        }
+    }
+
+  err=grlibint_lodSelect(graph,nodes,num_nodes,k,metric);
+  if (GRL_IS_FATALERROR(err))
+    {
+      free(nodes);
+      return err;
+    }
+
+  /* the reduced graph owns copies of the labels, also if the labels
+     of the graph are borrowed */
+
+  err=graphlib_newAnnotatedGraph(&lod,(graph->borrowed!=NULL) ?
+                                 graph->borrowed : graph->functions,
+                                 graph->numannotation);
+  if (GRL_IS_FATALERROR(err))
+    {
+      free(nodes);
+      return err;
+    }
+  lod->textbuf=graph->textbuf;
+  for (i=0;(i<graph->numannotation) && GRL_IS_OK(err);i++)
+    err=graphlib_AnnotationKey(lod,i,graph->annotations[i]);
+  for (i=0;(i<graph->num_node_attrs) && GRL_IS_OK(err);i++)
+    err=graphlib_addNodeAttrKey(lod,graph->node_attr_keys[i],&idx);
+  for (i=0;(i<graph->num_edge_attrs) && GRL_IS_OK(err);i++)
+    err=graphlib_addEdgeAttrKey(lod,graph->edge_attr_keys[i],&idx);
+
+  if (GRL_IS_OK(err))
+    err=grlibint_lodBuild(graph,lod,nodes,num_nodes,metric);
+  if (GRL_IS_OK(err))
+    err=grlibint_exportFile(fn,format,lod,1,0,NULL,NULL);
+
+  graphlib_delGraph(lod);
+  free(nodes);
+  return err;
+}
+
+
+/*-----------------------------------------------------------------*/
+/* Text cache */
+
+/*............................................................*/
+/* keep the text of labels and attribute values between exports, or
+   stop doing so and drop the kept text */
+
+graphlib_error_t graphlib_setTextCache(graphlib_graph_p graph, int enable)
+{
+  grlibint_textcache_t *cache;
+
+  if ((enable) && (graph->textcache==NULL))
+    {
+      cache=(grlibint_textcache_t*)calloc(1,sizeof(grlibint_textcache_t));
+      if (cache==NULL)
+        return GRL_NOMEM;
+      pthread_mutex_init(&(cache->lock),NULL);
+      graph->textcache=cache;
+    }
+  else if ((!enable) && (graph->textcache!=NULL))
+    {
+      grlibint_textFree(graph->textcache);
+      graph->textcache=NULL;
+    }
+  return GRL_OK;
+}
+
+
+/*............................................................*/
+/* forget the kept text of a label changed in place by the caller,
+   or of all labels if label is NULL */
+
+graphlib_error_t graphlib_forgetText(graphlib_graph_p graph,
+                                     const void *label)
+{
+  if (graph->textcache!=NULL)
+    grlibint_textForget(graph->textcache,label);
+  return GRL_OK;
+}
+
+
 /*-----------------------------------------------------------------*/
 /* The End. */
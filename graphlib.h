@@ -130,6 +130,77 @@ extern "C" {
 #define GRF_DOT       0   /* use AT&T DOT format with hex. colors */
 #define GRF_GML       1   /* use GraphML (GML) */
 #define GRF_PLAINDOT  2   /* use AT&T DOT format with color names */
+#define GRF_BINCOL    3   /* binary little endian columns, see below */
+
+#define GRF_GZIP      0x100 /* flag: gzip compress the export, only
+                               available if built with zlib */
+
+
+/*.......................................................*/
+/* Layout of GRF_BINCOL exports (all little endian)
+   - header: magic "\211GRC\r\n\032\n", uint32 version (1), uint32
+     number of columns, uint64 number of nodes, uint64 number of edges
+   - column table: per column uint32 kind (GRK_), uint32 index (the
+     annotation of GRK_ANNOTATION), uint64 offset from the start of
+     the file (multiple of 8), uint64 number of elements
+   - node columns hold one element per node, edge columns one per
+   edge, both in the same order; label and key columns hold uint64
+   offsets into the heap, one more than there are labels, the text
+   of label i spans offsets i to i+1 (not NUL terminated) */
+
+#define GRK_NODE_ID        0  /* int32  */
+#define GRK_NODE_WIDTH     1  /* double */
+#define GRK_NODE_W         2  /* double */
+#define GRK_NODE_COLOR     3  /* int32  */
+#define GRK_NODE_LABEL     4  /* uint64 heap offsets */
+#define GRK_ANNOTATION     5  /* double, one column per annotation */
+#define GRK_ANNOTATION_KEY 6  /* uint64 heap offsets */
+#define GRK_EDGE_FROM      7  /* int32  */
+#define GRK_EDGE_TO        8  /* int32  */
+#define GRK_EDGE_WIDTH     9  /* double */
+#define GRK_EDGE_COLOR     10 /* int32  */
+#define GRK_EDGE_LABEL     11 /* uint64 heap offsets */
+#define GRK_HEAP           12 /* bytes  */
+
+
+/*.......................................................*/
+/* Level of detail metrics (annotation numbers select annotations) */
+
+#define GRW_WIDTH -1 /* node width */
+#define GRW_W     -2 /* node w */
+
+
+/*.......................................................*/
+/* Serialization encodings (can be combined) */
+
+#define GRE_DEFAULT   0x00 /* fixed size fields, as graphlib_serializeGraph */
+#define GRE_COMPACT   0x01 /* varint lengths and counts, delta coded ids */
+#define GRE_COMPRESS  0x02 /* LZ4 block compressed frame */
+#define GRE_INDEX     0x04 /* chunk offset index for parallel decoding */
+#define GRE_COLUMNAR  0x08 /* one column per field, labels in a heap */
+#define GRE_DICT      0x10 /* distinct labels stored once, by reference */
+
+
+/*.......................................................*/
+/* Deserialization flags (can be combined) */
+
+#define GRD_DEFAULT   0x00 /* labels are copied out of the buffer */
+#define GRD_BORROW    0x01 /* labels point into the buffer */
+
+
+/*.......................................................*/
+/* Serialized fields (can be combined) */
+
+#define GRM_ANNOTATIONS 0x01 /* annotation keys */
+#define GRM_SIZE        0x02 /* node width, w and height, edge width */
+#define GRM_COLOR       0x04 /* node and edge colors */
+#define GRM_COORDS      0x08 /* node coordinates */
+#define GRM_FONTSIZE    0x10 /* node and edge font sizes */
+#define GRM_STYLE       0x20 /* edge arc styles and blocks */
+#define GRM_LABELS      0x40 /* node and edge labels */
+#define GRM_ATTRS       0x80 /* attribute values */
+#define GRM_BASIC       (GRM_LABELS|GRM_ATTRS) /* serializeBasicGraph */
+#define GRM_ALL         0xff /* as graphlib_serializeGraph */
 
 
 /*.......................................................*/
@@ -252,6 +323,15 @@ typedef struct graphlib_functiontable_d
   long (*edge_checksum)(const char *, const void *); /* For coloring */
 } graphlib_functiontable_t;
 
+/* Routines writing the text of a label (or of an attribute value,
+   given its key) into a buffer of the given size, see
+   graphlib_setTextBufFunctions: they return the length of the text,
+   which is not NUL terminated, and write nothing if it does not fit */
+
+typedef size_t (*graphlib_text_buf_fn)(const void *, char *, size_t);
+typedef size_t (*graphlib_attr_text_buf_fn)(const char *, const void *,
+                                            char *, size_t);
+
 
 /*.......................................................*/
 /* Node annotations */
@@ -278,6 +358,12 @@ typedef char graphlib_filename_t[GRL_MAX_FN_LENGTH];
 /* IDs for individual nodes */
 typedef int  graphlib_node_t;
 
+/* Write routine of an export sink: gets its argument and the next
+   len bytes of output, returns GRL_OK or an error code that stops
+   the export */
+typedef graphlib_error_t (*graphlib_sink_fn)(void *, const char *,
+                                             uint64_t);
+
 
 /*.......................................................*/
 /* Transparent pointer to one graph, used as a graph handle */
@@ -285,6 +371,75 @@ typedef int  graphlib_node_t;
 typedef struct graphlib_graph_d *graphlib_graph_p;
 
 
+/*.......................................................*/
+/* Transparent pointer to an incremental decoder */
+
+typedef struct graphlib_decoder_d *graphlib_decoder_p;
+
+
+/*.......................................................*/
+/* Read-only view on a graph in the indexed layout */
+/* The view lives in caller storage and only refers to the
+   serialized buffer; never access the fields directly */
+
+typedef struct graphlib_graphview_d *graphlib_graphview_p;
+typedef struct graphlib_graphview_d
+{
+  const char *base;
+  uint64_t   len;
+  uint64_t   num_nodes;
+  uint64_t   num_edges;
+  int        numannotation;
+  int        num_node_attrs;
+  int        num_edge_attrs;
+  int        directed;
+  uint64_t   node_rec;
+  uint64_t   edge_rec;
+  uint64_t   annotations;
+  uint64_t   attrkeys;
+  uint64_t   nodes;
+  uint64_t   edges;
+  uint64_t   heap;
+  uint64_t   heap_len;
+} graphlib_graphview_t;
+
+
+/*.......................................................*/
+/* Node and edge as seen through a view */
+/* Labels point into the serialized buffer in the format produced
+   by the serialize routines of the function table */
+
+typedef struct graphlib_viewnode_d *graphlib_viewnode_p;
+typedef struct graphlib_viewnode_d
+{
+  graphlib_node_t     id;
+  graphlib_width_t    width,w,height;
+  graphlib_color_t    color;
+  graphlib_coor_t     x,y;
+  graphlib_fontsize_t fontsize;
+  const char          *label;
+  unsigned int        label_len;
+  uint64_t            out_first;  /* first outgoing edge */
+  uint64_t            out_count;  /* number of outgoing edges */
+} graphlib_viewnode_t;
+
+typedef struct graphlib_viewedge_d *graphlib_viewedge_p;
+typedef struct graphlib_viewedge_d
+{
+  graphlib_node_t     node_from;
+  graphlib_node_t     node_to;
+  uint64_t            index_from; /* node position, UINT64_MAX if none */
+  uint64_t            index_to;
+  graphlib_width_t    width;
+  graphlib_color_t    color;
+  graphlib_arc_t      arcstyle;
+  graphlib_block_t    block;
+  graphlib_fontsize_t fontsize;
+  const char          *label;
+  unsigned int        label_len;
+} graphlib_viewedge_t;
+
+
 /*-----------------------------------------------------------------*/
 /* Management routines */
 
@@ -651,21 +806,83 @@ graphlib_error_t graphlib_loadGraph(graphlib_filename_t fn,
                                     graphlib_functiontable_p functions);
 
 
+/*.......................................................*/
+/* load a graph stored in GraphLib's internal format
+   by memory mapping the file */
+/* IN: filename
+       pointer to graph handle storage
+       function table
+   Comment: same as graphlib_loadGraph, but the graph is created
+   directly from the mapped file instead of a copy in memory, which
+   lowers peak memory use for large files */
+
+graphlib_error_t graphlib_loadGraphMapped(graphlib_filename_t fn,
+                                          graphlib_graph_p *newgraph,
+                                          graphlib_functiontable_p functions);
+
+
+/*.......................................................*/
+/* load a graph stored in GraphLib's internal format, but decode
+   labels and attribute values only when they are needed */
+/* IN: filename
+       pointer to graph handle storage
+       function table
+   Comment: ids, edges, numeric attributes and annotations are
+   available immediately; the labels and attribute values of a node
+   are decoded by graphlib_getNodeAttr, all remaining ones by the
+   first routine that needs them (serialize, save, export, merge,
+   coloring by edge labels). The file is mapped until then and must
+   not change. Version 1 files are loaded completely, save with
+   graphlib_saveGraphIndexed to load lazily */
+
+graphlib_error_t graphlib_loadGraphLazy(graphlib_filename_t fn,
+                                        graphlib_graph_p *newgraph,
+                                        graphlib_functiontable_p functions);
+
+
 /*.......................................................*/
 /* store a graph in GraphLib's internal format */
 /* IN: filename
-       graph handle */
+       graph handle
+   Comment: writes format version 1, which every GraphLib release
+   can read; use graphlib_saveGraphIndexed for version 2 */
 
 graphlib_error_t graphlib_saveGraph(graphlib_filename_t fn,
                                     graphlib_graph_p graph);
 
 
+/*.......................................................*/
+/* store a graph in GraphLib's internal format, version 2 */
+/* IN: filename
+       graph handle
+   Comment: writes format version 2 (indexed layout with checksums)
+   with bounded memory use; graphlib_loadGraph reads both version 1
+   and 2, older GraphLib releases only version 1. Only version 2
+   files are loaded lazily by graphlib_loadGraphLazy */
+
+graphlib_error_t graphlib_saveGraphIndexed(graphlib_filename_t fn,
+                                           graphlib_graph_p graph);
+
+
+/*.......................................................*/
+/* store a graph in GraphLib's internal format, compressed */
+/* IN: filename
+       graph handle
+   Comment: version 2 file in a frame of LZ4 compressed blocks,
+   graphlib_loadGraph and graphlib_loadGraphMapped detect the
+   compression and read these files transparently */
+
+graphlib_error_t graphlib_saveGraphCompressed(graphlib_filename_t fn,
+                                              graphlib_graph_p graph);
+
+
 /*.......................................................*/
 /* export a graph in external format */
 /* IN: filename
        format (use GRF_ constants)
        graph handle
-   Comment: exported graphs can not be loaded again */
+   Comment: exported graphs can not be loaded again; file names
+   ending in .gz select GRF_GZIP */
 
 graphlib_error_t graphlib_exportGraph(graphlib_filename_t fn,
                                       graphlib_format_t format,
@@ -679,7 +896,8 @@ graphlib_error_t graphlib_exportGraph(graphlib_filename_t fn,
        number of graph attributes
        array of graph attribute strings
        array of graph attribute values
-   Comment: exported graphs can not be loaded again */
+   Comment: exported graphs can not be loaded again; file names
+   ending in .gz select GRF_GZIP */
 
 graphlib_error_t graphlib_exportAttributedGraph(graphlib_filename_t fn,
                                       graphlib_format_t format,
@@ -688,6 +906,125 @@ graphlib_error_t graphlib_exportAttributedGraph(graphlib_filename_t fn,
                                       char **attr_keys,
                                       char **attr_values);
 
+/*.......................................................*/
+/* export a graph in external format using several threads */
+/* IN: filename
+       format (use GRF_ constants)
+       graph handle
+       number of threads (0 or less: number of online processors)
+   Comment: the file is identical to graphlib_exportGraph; node and
+   edge fragments are formatted by the threads and written in order */
+
+graphlib_error_t graphlib_exportGraphParallel(graphlib_filename_t fn,
+                                              graphlib_format_t format,
+                                              graphlib_graph_p graph,
+                                              int nthreads);
+
+/*.......................................................*/
+/* export a graph in external format through a write routine */
+/* IN: format (use GRF_ constants)
+       graph handle
+       write routine
+       argument passed to the write routine
+   Comment: the routine is called in order with consecutive pieces
+   of the output, possibly from a separate thread */
+
+graphlib_error_t graphlib_exportGraphToSink(graphlib_format_t format,
+                                            graphlib_graph_p graph,
+                                            graphlib_sink_fn write,
+                                            void *arg);
+
+/*.......................................................*/
+/* export a graph in external format into a file descriptor */
+/* IN: open file descriptor
+       format (use GRF_ constants)
+       graph handle
+   Comment: the descriptor stays open, output starts at its
+   current position */
+
+graphlib_error_t graphlib_exportGraphToFd(int fd, graphlib_format_t format,
+                                          graphlib_graph_p graph);
+
+/*.......................................................*/
+/* export a graph in external format into a stdio stream */
+/* IN: open stream
+       format (use GRF_ constants)
+       graph handle
+   Comment: the stream stays open and is not flushed */
+
+graphlib_error_t graphlib_exportGraphToFile(FILE *file,
+                                            graphlib_format_t format,
+                                            graphlib_graph_p graph);
+
+/*.......................................................*/
+/* export a graph in external format into memory */
+/* IN: format (use GRF_ constants)
+       graph handle
+       pointer to the buffer (allocated, to be freed by the caller)
+       pointer to return value (length of the output)
+   Comment: the buffer is not NUL terminated */
+
+graphlib_error_t graphlib_exportGraphToBuffer(graphlib_format_t format,
+                                              graphlib_graph_p graph,
+                                              char **obuf, uint64_t *olen);
+
+/*.......................................................*/
+/* export the heaviest part of a graph in external format */
+/* IN: filename
+       format (use GRF_ constants)
+       graph handle
+       number of nodes to select
+       metric (GRW_ constant or annotation number)
+   Comment: the k nodes with the largest metric are exported with
+   the nodes on their path to a root; the children left out of each
+   exported node are collapsed into one summary node with merged
+   labels and summed up widths and metric. k=0 exports an empty
+   graph; a negative k, or a metric that is neither a GRW_ constant
+   nor an annotation of the graph, returns GRL_INVALID */
+
+graphlib_error_t graphlib_exportGraphLOD(graphlib_filename_t fn,
+                                         graphlib_format_t format,
+                                         graphlib_graph_p graph, int k,
+                                         int metric);
+
+/*.......................................................*/
+/* keep the text of labels between exports */
+/* IN: graph handle
+       1 to keep the text, 0 to drop it and stop keeping it
+   Comment: exports look up the text of labels and attribute values
+   by their address instead of calling the _to_text routines again;
+   graphlib forgets the text of labels it merges or frees, callers
+   that change a label in place use graphlib_forgetText */
+
+graphlib_error_t graphlib_setTextCache(graphlib_graph_p graph, int enable);
+
+/*.......................................................*/
+/* write the text of labels directly into the export buffers */
+/* IN: graph handle
+       routines for node labels, node attribute values, edge labels
+       and edge attribute values, each NULL to use the _to_text
+       routine of the function table
+   Comment: used for labels other than NULL; a routine whose text
+   did not fit is called again with a large enough buffer. Graphs
+   whose _to_text routines are the default ones use built in
+   routines for string labels */
+
+graphlib_error_t graphlib_setTextBufFunctions(graphlib_graph_p graph,
+                                      graphlib_text_buf_fn node_to_text_buf,
+                                      graphlib_attr_text_buf_fn
+                                        node_attr_to_text_buf,
+                                      graphlib_text_buf_fn edge_to_text_buf,
+                                      graphlib_attr_text_buf_fn
+                                        edge_attr_to_text_buf);
+
+/*.......................................................*/
+/* forget the kept text of a label */
+/* IN: graph handle
+       label or attribute value, NULL for all labels of the graph */
+
+graphlib_error_t graphlib_forgetText(graphlib_graph_p graph,
+                                     const void *label);
+
 /*.......................................................*/
 /* serialize a graph into a byte array for transfer */
 /* IN: graph handle
@@ -710,6 +1047,182 @@ graphlib_error_t graphlib_serializeBasicGraph(graphlib_graph_p igraph,
                                               uint64_t *obyte_array_len );
 
 
+/*.......................................................*/
+/* compute the exact length of a serialized graph */
+/* IN: graph handle
+       pointer to return value (length of serialized graph) */
+
+graphlib_error_t graphlib_serializedGraphLength(graphlib_graph_p igraph,
+                                                uint64_t *olen);
+
+
+/*.......................................................*/
+/* compute the exact length of a serialized graph
+   without annotations and only the label attribute */
+/* IN: graph handle
+       pointer to return value (length of serialized graph) */
+
+graphlib_error_t graphlib_serializedBasicGraphLength(graphlib_graph_p igraph,
+                                                     uint64_t *olen);
+
+
+/*.......................................................*/
+/* serialize a graph into a caller supplied byte array */
+/* IN: graph handle
+       byte array
+       size of byte array
+       pointer to return value (length of serialized graph)
+   Comment: if the array is too small, GRL_MEMORYERROR is returned,
+   nothing is written and the required length is stored */
+
+graphlib_error_t graphlib_serializeGraphInto(graphlib_graph_p igraph,
+                                             char *obyte_array,
+                                             uint64_t obyte_array_len,
+                                             uint64_t *oused);
+
+
+/*.......................................................*/
+/* serialize a graph into a caller supplied byte array.
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       byte array
+       size of byte array
+       pointer to return value (length of serialized graph)
+   Comment: if the array is too small, GRL_MEMORYERROR is returned,
+   nothing is written and the required length is stored */
+
+graphlib_error_t graphlib_serializeBasicGraphInto(graphlib_graph_p igraph,
+                                                  char *obyte_array,
+                                                  uint64_t obyte_array_len,
+                                                  uint64_t *oused);
+
+
+/*.......................................................*/
+/* serialize a graph into a byte array using several threads */
+/* IN: graph handle
+       number of threads (0 or less: number of online processors)
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: the result is identical to graphlib_serializeGraph; node
+   and edge fragments are distributed over the threads */
+
+graphlib_error_t graphlib_serializeGraphParallel(graphlib_graph_p igraph,
+                                                 int nthreads,
+                                                 char **obyte_array,
+                                                 uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize a graph into a byte array using several threads.
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       number of threads (0 or less: number of online processors)
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: the result is identical to graphlib_serializeBasicGraph */
+
+graphlib_error_t graphlib_serializeBasicGraphParallel(graphlib_graph_p igraph,
+                                                      int nthreads,
+                                                      char **obyte_array,
+                                                      uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize a graph into a byte array using a selectable encoding */
+/* IN: graph handle
+       encoding (combination of GRE_ constants)
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: with GRE_DEFAULT the result is identical to
+   graphlib_serializeGraph, otherwise a self-describing stream is
+   produced; GRE_COMPRESS compresses the stream selected by the
+   other flags. GRE_COLUMNAR stores each field as an aligned column
+   (raw, also with GRE_COMPACT) and ignores GRE_INDEX. GRE_DICT
+   stores every distinct label and attribute value once and refers
+   to it from nodes and edges;
+   graphlib_deserializeGraph reads all of them */
+
+graphlib_error_t graphlib_serializeGraphEncoded(graphlib_graph_p igraph,
+                                                int encoding,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize a graph into a byte array using a selectable encoding.
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       encoding (combination of GRE_ constants)
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: see graphlib_serializeGraphEncoded; streams produced with
+   GRE_COMPACT record that they are basic, so they can be read by
+   either deserialize routine */
+
+graphlib_error_t graphlib_serializeBasicGraphEncoded(graphlib_graph_p igraph,
+                                                     int encoding,
+                                                     char **obyte_array,
+                                                     uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize selected fields of a graph into a byte array */
+/* IN: graph handle
+       encoding (combination of GRE_ constants)
+       fields (combination of GRM_ constants)
+       NULL terminated list of node attribute keys or NULL
+       NULL terminated list of edge attribute keys or NULL
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: with GRM_ATTRS only the listed attributes are included,
+   all of them for a NULL list; GRL_NOATTRIBUTE if a key is unknown.
+   Fields other than GRM_ALL and GRM_BASIC are recorded in the
+   stream, also for GRE_DEFAULT, and either deserialize routine
+   restores them. Fields left out get their default values, labels
+   are NULL */
+
+graphlib_error_t graphlib_serializeGraphMask(graphlib_graph_p igraph,
+                                             int encoding, int mask,
+                                             char **node_keys,
+                                             char **edge_keys,
+                                             char **obyte_array,
+                                             uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize a graph into a scatter/gather list (e.g., for writev) */
+/* IN: graph handle
+       pointer to iovec array
+       pointer to number of iovec entries
+       pointer to return value (length of serialized graph)
+   Comment: the concatenated entries are identical to the output
+   of graphlib_serializeGraph. Labels using the default routines are
+   referenced in place, so the graph must not be modified while the
+   list is in use. Release the list with a single free() */
+
+struct iovec;
+
+graphlib_error_t graphlib_serializeGraphIov(graphlib_graph_p igraph,
+                                            struct iovec **oiov,
+                                            int *oiovcnt,
+                                            uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* serialize a graph into a scatter/gather list (e.g., for writev).
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       pointer to iovec array
+       pointer to number of iovec entries
+       pointer to return value (length of serialized graph)
+   Comment: see graphlib_serializeGraphIov */
+
+graphlib_error_t graphlib_serializeBasicGraphIov(graphlib_graph_p igraph,
+                                                 struct iovec **oiov,
+                                                 int *oiovcnt,
+                                                 uint64_t *obyte_array_len);
+
+
 /*.......................................................*/
 /* deserialize a graph from a byte array for transfer */
 /* Assumes equal edge label width */
@@ -740,6 +1253,283 @@ graphlib_error_t graphlib_deserializeBasicGraph(graphlib_graph_p *ograph,
                                                 uint64_t ibyte_array_len );
 
 
+/*.......................................................*/
+/* deserialize a graph from a byte array using several threads */
+/* IN: graph handle
+       function table
+       pointer to byte array
+       length of serialized graph
+       number of threads (0 for one per processor)
+   Comment: the result matches graphlib_deserializeGraph. Only streams
+   encoded with GRE_INDEX can be split, edges are then assumed to be
+   unique; other streams and streams with duplicate node ids are
+   decoded sequentially */
+
+graphlib_error_t graphlib_deserializeGraphParallel(graphlib_graph_p *ograph,
+                                                   graphlib_functiontable_p
+                                                     functions,
+                                                   char *ibyte_array,
+                                                   uint64_t ibyte_array_len,
+                                                   int nthreads);
+
+
+/*.......................................................*/
+/* deserialize a graph from a byte array using several threads.
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       function table
+       pointer to byte array
+       length of serialized graph
+       number of threads (0 for one per processor)
+   Comment: see graphlib_deserializeGraphParallel */
+
+graphlib_error_t graphlib_deserializeBasicGraphParallel(graphlib_graph_p
+                                                          *ograph,
+                                                        graphlib_functiontable_p
+                                                          functions,
+                                                        char *ibyte_array,
+                                                        uint64_t
+                                                          ibyte_array_len,
+                                                        int nthreads);
+
+/*.......................................................*/
+/* deserialize a graph from a byte array with GRD_ flags */
+/* IN: graph handle
+       function table
+       pointer to byte array
+       length of serialized graph
+       flags (combination of GRD_ constants)
+   Comment: with GRD_BORROW labels and attribute values are not
+   copied but point into the byte array, which must stay unchanged
+   until the graph is deleted or graphlib_materializeLabels has been
+   called. Adding nodes or edges to the graph or merging another graph
+   into it calls graphlib_materializeLabels first; other changes to
+   labels in place are not allowed. Labels can only be borrowed
+   with the default label routines, and not from compressed streams
+   or streams with duplicate nodes; the flag is ignored otherwise */
+
+graphlib_error_t graphlib_deserializeGraphFlags(graphlib_graph_p *ograph,
+                                                graphlib_functiontable_p
+                                                  functions,
+                                                char *ibyte_array,
+                                                uint64_t ibyte_array_len,
+                                                int flags);
+
+
+/*.......................................................*/
+/* deserialize a graph from a byte array with GRD_ flags.
+   Does not copy annotations and only copies the label attribute */
+/* IN: graph handle
+       function table
+       pointer to byte array
+       length of serialized graph
+       flags (combination of GRD_ constants)
+   Comment: see graphlib_deserializeGraphFlags */
+
+graphlib_error_t graphlib_deserializeBasicGraphFlags(graphlib_graph_p *ograph,
+                                                     graphlib_functiontable_p
+                                                       functions,
+                                                     char *ibyte_array,
+                                                     uint64_t ibyte_array_len,
+                                                     int flags);
+
+
+/*.......................................................*/
+/* copy borrowed labels into the graph */
+/* IN: graph handle
+   Comment: afterwards the graph no longer refers to the buffer it
+   was deserialized from, or the file it was lazily loaded from;
+   does nothing for other graphs */
+
+graphlib_error_t graphlib_materializeLabels(graphlib_graph_p graph);
+
+
+/*.......................................................*/
+/* create an incremental decoder for a serialized graph */
+/* IN: pointer to decoder handle storage
+       function table
+   Comment: the decoder accepts everything graphlib_deserializeGraph
+   does (the Basic variant everything graphlib_deserializeBasicGraph
+   does), including compressed streams, in chunks of any size */
+
+graphlib_error_t graphlib_newDecoder(graphlib_decoder_p *odec,
+                                     graphlib_functiontable_p functions);
+
+graphlib_error_t graphlib_newBasicDecoder(graphlib_decoder_p *odec,
+                                          graphlib_functiontable_p functions);
+
+
+/*.......................................................*/
+/* pass the next chunk of a serialized graph to a decoder */
+/* IN: decoder handle
+       pointer to chunk
+       length of chunk
+   Comment: nodes and edges are added to the graph as soon as they are
+   complete, only an incomplete item is buffered; the chunk can be
+   reused on return. GRE_COLUMNAR and GRE_DICT streams are buffered
+   and decoded by graphlib_decoderFinish. Errors are sticky */
+
+graphlib_error_t graphlib_decoderFeed(graphlib_decoder_p dec,
+                                      const char *chunk, uint64_t len);
+
+
+/*.......................................................*/
+/* read from a file descriptor until end of file and pass the data
+   to a decoder */
+/* IN: decoder handle
+       file descriptor (file, pipe or socket) */
+
+graphlib_error_t graphlib_decoderFeedFd(graphlib_decoder_p dec, int fh);
+
+
+/*.......................................................*/
+/* finish decoding and delete the decoder */
+/* IN: decoder handle
+       pointer to graph handle storage
+   Comment: fails with GRL_MEMORYERROR if the stream is incomplete */
+
+graphlib_error_t graphlib_decoderFinish(graphlib_decoder_p dec,
+                                        graphlib_graph_p *ograph);
+
+
+/*.......................................................*/
+/* delete a decoder without creating a graph */
+/* IN: decoder handle */
+
+graphlib_error_t graphlib_delDecoder(graphlib_decoder_p dec);
+
+
+/*-----------------------------------------------------------------*/
+/* Graph View Routines */
+
+/*.......................................................*/
+/* serialize a graph into the indexed layout used by views */
+/* IN: graph handle
+       pointer to byte array
+       pointer to return value (length of serialized graph)
+   Comment: the layout contains the full graph including annotation
+   values; nodes are sorted by id and edges by (source,target) */
+
+graphlib_error_t graphlib_serializeGraphIndexed(graphlib_graph_p igraph,
+                                                char **obyte_array,
+                                                uint64_t *obyte_array_len);
+
+
+/*.......................................................*/
+/* deserialize a graph from a byte array in the indexed layout */
+/* IN: graph handle
+       function table
+       pointer to byte array
+       length of byte array
+   Comment: checksums are verified if present; a layout written with
+   the other byte order is converted in place, so the byte array may
+   be modified */
+
+graphlib_error_t graphlib_deserializeGraphIndexed(graphlib_graph_p *ograph,
+                                                  graphlib_functiontable_p
+                                                    functions,
+                                                  char *ibyte_array,
+                                                  uint64_t ibyte_array_len);
+
+
+/*.......................................................*/
+/* open a read-only view on a graph in the indexed layout */
+/* IN: pointer to view storage (e.g., on the stack)
+       pointer to byte array
+       length of byte array
+   Comment: no memory is allocated and nothing is copied; the byte
+   array must stay valid and unchanged while the view is in use.
+   Returns GRL_UNKNOWNFORMAT for anything but a valid indexed layout
+   in native byte order */
+
+graphlib_error_t graphlib_viewGraph(graphlib_graphview_p view,
+                                    const char *ibyte_array,
+                                    uint64_t ibyte_array_len);
+
+
+/*.......................................................*/
+/* count nodes and edges of a view */
+/* IN: view
+       pointer to return value */
+
+graphlib_error_t graphlib_viewNodeCount(graphlib_graphview_p view,
+                                        uint64_t *onum_nodes);
+
+graphlib_error_t graphlib_viewEdgeCount(graphlib_graphview_p view,
+                                        uint64_t *onum_edges);
+
+
+/*.......................................................*/
+/* access a node or edge of a view by position */
+/* IN: view
+       position (0 to count-1)
+       pointer to node/edge storage
+   Comment: positions follow the sort order, so the outgoing edges
+   of a node are edges out_first to out_first+out_count-1 */
+
+graphlib_error_t graphlib_viewNode(graphlib_graphview_p view, uint64_t index,
+                                   graphlib_viewnode_p onode);
+
+graphlib_error_t graphlib_viewEdge(graphlib_graphview_p view, uint64_t index,
+                                   graphlib_viewedge_p oedge);
+
+
+/*.......................................................*/
+/* find the position of a node or edge in a view */
+/* IN: view
+       node id / source and target node ids
+       pointer to return value (position)
+   Comment: returns GRL_NONODE / GRL_NOEDGE if not present */
+
+graphlib_error_t graphlib_viewFindNode(graphlib_graphview_p view,
+                                       graphlib_node_t node,
+                                       uint64_t *oindex);
+
+graphlib_error_t graphlib_viewFindEdge(graphlib_graphview_p view,
+                                       graphlib_node_t node_from,
+                                       graphlib_node_t node_to,
+                                       uint64_t *oindex);
+
+
+/*.......................................................*/
+/* access the keys stored in a view */
+/* IN: view
+       number of annotation / attribute
+       pointer to return value (key string inside the byte array) */
+
+graphlib_error_t graphlib_viewAnnotationKey(graphlib_graphview_p view,
+                                            int num, const char **okey);
+
+graphlib_error_t graphlib_viewNodeAttrKey(graphlib_graphview_p view,
+                                          int num, const char **okey);
+
+graphlib_error_t graphlib_viewEdgeAttrKey(graphlib_graphview_p view,
+                                          int num, const char **okey);
+
+
+/*.......................................................*/
+/* access attributes and annotations of a node or edge of a view */
+/* IN: view
+       position of node/edge
+       number of attribute / annotation
+       pointer to return value (serialized attribute and its length,
+       NULL and 0 if not set / annotation value) */
+
+graphlib_error_t graphlib_viewNodeAttr(graphlib_graphview_p view,
+                                       uint64_t index, int num,
+                                       const char **odata,
+                                       unsigned int *olen);
+
+graphlib_error_t graphlib_viewEdgeAttr(graphlib_graphview_p view,
+                                       uint64_t index, int num,
+                                       const char **odata,
+                                       unsigned int *olen);
+
+graphlib_error_t graphlib_viewAnnotationGet(graphlib_graphview_p view,
+                                            uint64_t index, int num,
+                                            graphlib_annotation_t *val);
+
+
 /*-----------------------------------------------------------------*/
 /* Graph Merge Routines */
 
@@ -101,14 +101,17 @@ int main(int argc, char **argv)
       ac++;
     }
 
+  err=graphlib_Init();
+  CHECKERROR(err,"Initializing GraphLib");
+
   printf("Loading %s\n",argv[ac]);
-  err=graphlib_loadGraph(argv[ac],&gr,NULL); 
+  err=graphlib_loadGraphMapped(argv[ac],&gr,NULL); 
   CHECKERROR(err,"Load initial graph");  
 
   for (i=ac+1; i<argc-1; i++)
     {
       printf("Loading %s\n",argv[i]);
-      err=graphlib_loadGraph(argv[i],&gradd,NULL); 
+      err=graphlib_loadGraphMapped(argv[i],&gradd,NULL); 
       CHECKERROR(err,"Load additional graph");
 
       err=graphlib_mergeGraphs(gr,gradd);
@@ -156,7 +159,10 @@ int main(int argc, char **argv)
   printf("Cleaning up\n");
 
   err=graphlib_delGraph(gr);
-  CHECKERROR(err,"Deleting initial Graph");  
+  CHECKERROR(err,"Deleting initial Graph");
+
+  err=graphlib_Finish();
+  CHECKERROR(err,"Finalizing GraphLib");  
 
   return 0;
 }